@@ -0,0 +1,95 @@
+#include "builder.hpp"
+
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+
+GraphBuilder::GraphBuilder(Graph &graph, GraphValidator *validator, GraphIndex *index)
+        : graph(&graph), validator(validator), index(index), first_added(graph.nodes.size()) {}
+
+void GraphBuilder::reserve(size_t node_count) {
+    graph->nodes.reserve(graph->nodes.size() + node_count);
+}
+
+uint32_t GraphBuilder::add_nodes(const Func &func, size_t count) {
+    const auto first = static_cast<uint32_t>(graph->nodes.size());
+    if (count == 0) {
+        return first;
+    }
+
+    std::vector<NodeId> ids(count);
+    generate_uuids(ids);
+
+    // like Node(func) without drawing an id that would be replaced anyway
+    Node prototype{};
+    prototype.func_id = func.id;
+    prototype.name = func.name;
+    prototype.inputs.resize(func.args.size());
+    prototype.events.resize(func.events.size());
+
+    // growing by at least double keeps repeated small adds amortized O(1)
+    if (first + count > graph->nodes.capacity()) {
+        graph->nodes.reserve(std::max(first + count, 2 * graph->nodes.capacity()));
+    }
+    for (const auto &id: ids) {
+        auto &node = graph->nodes.emplace_back(prototype);
+        node.id = id;
+    }
+    return first;
+}
+
+uint32_t GraphBuilder::add_node(const Func &func) {
+    return add_nodes(func, 1);
+}
+
+void GraphBuilder::set_const(uint32_t node_idx, uint32_t arg_idx, Value value) {
+    auto &input = graph->nodes[node_idx].inputs[arg_idx];
+    input.binding = BindingType::Const;
+    input.value = std::move(value);
+    if (node_idx < first_added) {
+        rewired.push_back(node_idx);
+    }
+}
+
+void GraphBuilder::bind(uint32_t consumer_idx, uint32_t arg_idx, uint32_t producer_idx, uint32_t output_idx) {
+    assert(producer_idx < graph->nodes.size());
+    auto &input = graph->nodes[consumer_idx].inputs[arg_idx];
+    input.binding = BindingType::Binding;
+    input.value.reset();
+    input.output_node_id = graph->nodes[producer_idx].id;
+    input.output_idx = output_idx;
+    if (consumer_idx < first_added) {
+        rewired.push_back(consumer_idx);
+    }
+}
+
+bool GraphBuilder::commit() {
+    if (index != nullptr) {
+        std::vector<NodeId> ids;
+        ids.reserve(rewired.size() + graph->nodes.size() - first_added);
+        for (const auto node_idx: rewired) {
+            ids.push_back(graph->nodes[node_idx].id);
+        }
+        for (auto i = first_added; i < graph->nodes.size(); ++i) {
+            ids.push_back(graph->nodes[i].id);
+        }
+        index->touch(ids);
+    }
+
+    bool valid = true;
+    if (validator != nullptr) {
+        for (const auto node_idx: rewired) {
+            validator->touch(graph->nodes[node_idx].id);
+        }
+        for (auto i = first_added; i < graph->nodes.size(); ++i) {
+            validator->touch(graph->nodes[i].id);
+        }
+        valid = validator->validate();
+    }
+
+    rewired.clear();
+    first_added = graph->nodes.size();
+    return valid;
+}
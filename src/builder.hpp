@@ -0,0 +1,46 @@
+#pragma once
+
+#include "func.hpp"
+#include "graph.hpp"
+#include "index.hpp"
+#include "validator.hpp"
+#include "value.hpp"
+
+#include "utils/nocopy.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+// Appends nodes to a graph in bulk. Nodes are addressed by their index in Graph::nodes, ids are
+// generated in batches and inputs are copied from one prototype per func. Nothing is checked
+// until commit(), which hands every node added or rewired to the validator and the index, if
+// there are any.
+struct GraphBuilder {
+    NOCOPY(GraphBuilder)
+
+    Graph *graph;
+    GraphValidator *validator;
+    GraphIndex *index;
+
+    size_t first_added;            // graph.nodes.size() when the batch started
+    std::vector<uint32_t> rewired; // nodes from before the batch with changed inputs
+
+    explicit GraphBuilder(Graph &graph, GraphValidator *validator = nullptr, GraphIndex *index = nullptr);
+
+    void reserve(size_t node_count);
+
+    // Appends count nodes of func, returns the index of the first one.
+    uint32_t add_nodes(const Func &func, size_t count);
+
+    uint32_t add_node(const Func &func);
+
+    void set_const(uint32_t node_idx, uint32_t arg_idx, Value value);
+
+    // arg_idx is into Func::args of the consumer, output_idx counts the Out args of the producer
+    void bind(uint32_t consumer_idx, uint32_t arg_idx, uint32_t producer_idx, uint32_t output_idx = 0);
+
+    // Ends the batch, a new one starts at the current end of the graph. Returns whether the
+    // validator found no issues, true without one.
+    bool commit();
+};
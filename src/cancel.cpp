@@ -0,0 +1,25 @@
+#include "cancel.hpp"
+
+
+static thread_local const CancelScope *current_scope = nullptr;
+
+
+bool CancelScope::is_expired() const {
+    return deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline;
+}
+
+CancelScopeGuard::CancelScopeGuard(const CancelScope &scope) : previous(current_scope) {
+    current_scope = &scope;
+}
+
+CancelScopeGuard::~CancelScopeGuard() {
+    current_scope = previous;
+}
+
+bool stop_requested() {
+    return current_scope != nullptr && current_scope->stop_requested();
+}
+
+const CancelScope *current_cancel_scope() {
+    return current_scope;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "utils/nocopy.hpp"
+
+#include <atomic>
+#include <chrono>
+
+
+// Cooperative cancellation of a run. The executor checks the token between nodes and skips the
+// remaining ones once it is cancelled; funcs that run for long poll stop_requested().
+struct CancelToken {
+    std::atomic<bool> cancelled{false};
+
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    [[nodiscard]] bool is_cancelled() const { return cancelled.load(std::memory_order_relaxed); }
+};
+
+// What the node running on a thread has to observe: the token of its run and its own deadline.
+struct CancelScope {
+    const CancelToken *token = nullptr;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    [[nodiscard]] bool is_cancelled() const { return token != nullptr && token->is_cancelled(); }
+
+    [[nodiscard]] bool is_expired() const;
+
+    [[nodiscard]] bool stop_requested() const { return is_cancelled() || is_expired(); }
+};
+
+// Makes scope the one stop_requested() reports on for the calling thread until destruction.
+struct CancelScopeGuard {
+    NOCOPY(CancelScopeGuard)
+
+    const CancelScope *previous;
+
+    explicit CancelScopeGuard(const CancelScope &scope);
+
+    ~CancelScopeGuard();
+};
+
+// For funcs: true once the run of the node executing on this thread was cancelled or the node
+// ran past its timeout. Always false outside of a node.
+bool stop_requested();
+
+// scope of the node executing on this thread, null outside of a node
+const CancelScope *current_cancel_scope();
@@ -0,0 +1,285 @@
+#include "checkpoint.hpp"
+
+#include "encoding.hpp"
+
+#include "utils/file_sync.hpp"
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+
+static constexpr uint32_t CheckpointMagic = 0x54504b43; // "CKPT"
+static constexpr uint32_t CheckpointVersion = 2;
+static constexpr uint32_t CheckpointHeaderSize = 32;
+static constexpr uint32_t RecordHeaderSize = 16; // node index, payload size, checksum of the payload
+
+
+// returns false for outputs too large for the 32 bit size of a record
+static bool append_record(std::vector<std::byte> &bytes, uint32_t node_idx, std::span<const Value> node_outputs) {
+    const auto payload_size = encoded_size(node_outputs);
+    if (payload_size > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    const auto offset = bytes.size();
+    bytes.resize(offset + RecordHeaderSize + payload_size, std::byte{0});
+    auto record = bytes.data() + offset;
+    encode_values(node_outputs, record + RecordHeaderSize);
+    store_u32(record, node_idx);
+    store_u32(record + 4, static_cast<uint32_t>(payload_size));
+    const auto checksum = hash_bytes(record + RecordHeaderSize, payload_size);
+    std::memcpy(record + 8, &checksum, sizeof(checksum));
+    return true;
+}
+
+// writes next to the file, syncs it and renames it over, a crash while saving keeps the previous save
+static bool replace_file(const std::string &path, std::span<const std::byte> bytes) {
+    const auto temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file.good()) {
+            return false;
+        }
+    }
+    if (!sync_file(temporary)) {
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error && sync_parent_directory(path);
+}
+
+static bool append_file(const std::string &path, std::span<const std::byte> bytes) {
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file.good()) {
+            return false;
+        }
+    }
+    return sync_file(path);
+}
+
+// Writes the queued records, or the whole checkpoint if it has to start the file over. The
+// caller holds write_mutex, mutex is only held to take what is written, encoding happens outside.
+static bool write_checkpoint(Checkpoint &checkpoint) {
+    std::vector<std::byte> bytes;
+    bool rewrite;
+    uint64_t fingerprint = 0;
+    std::vector<uint8_t> completed;
+    std::vector<NodeOutputs> outputs;
+    {
+        std::lock_guard lock(checkpoint.mutex);
+        rewrite = checkpoint.rewrite;
+        if (rewrite) {
+            fingerprint = checkpoint.fingerprint;
+            completed = checkpoint.completed;
+            outputs = checkpoint.outputs;
+        } else {
+            bytes = std::move(checkpoint.pending);
+        }
+        checkpoint.pending.clear();
+    }
+
+    if (rewrite) {
+        const auto node_count = static_cast<uint32_t>(completed.size());
+        bytes.assign(CheckpointHeaderSize, std::byte{0});
+        store_u32(bytes.data(), CheckpointMagic);
+        store_u32(bytes.data() + 4, CheckpointVersion);
+        store_u32(bytes.data() + 8, node_count);
+        std::memcpy(bytes.data() + 16, &fingerprint, sizeof(fingerprint));
+        for (uint32_t node_idx = 0; node_idx < node_count; ++node_idx) {
+            if (completed[node_idx]) {
+                append_record(bytes, node_idx, outputs[node_idx]);
+            }
+        }
+    } else if (bytes.empty()) {
+        return true;
+    }
+
+    const bool written = rewrite ? replace_file(checkpoint.path, bytes) : append_file(checkpoint.path, bytes);
+
+    // a failed append may have left part of a record behind, the next write starts over
+    std::lock_guard lock(checkpoint.mutex);
+    checkpoint.rewrite = !written;
+    if (written) {
+        ++checkpoint.save_count;
+    }
+    return written;
+}
+
+
+void Checkpoint::begin_run(GraphInstance &instance, std::vector<uint8_t> &restored) {
+    const auto &plan = *instance.plan;
+    const auto current = instance_fingerprint(instance);
+
+    std::lock_guard lock(mutex);
+    if (current != fingerprint || completed.size() != plan.node_count) {
+        fingerprint = current;
+        completed.assign(plan.node_count, 0);
+        outputs.assign(plan.node_count, {});
+        pending.clear();
+        rewrite = true;
+    }
+
+    // Producers run again unless they were saved too, which outputs that cannot be encoded and
+    // streaming or timed out nodes never are. Their consumers would then be released twice, so a
+    // node only counts as done when all of its producers do.
+    for (const auto node_idx: plan.order) {
+        if (!completed[node_idx]) {
+            continue;
+        }
+        for (auto source_idx = plan.source_offsets[node_idx]; source_idx < plan.source_offsets[node_idx + 1]; ++source_idx) {
+            const auto &source = plan.sources[source_idx];
+            if (source.binding == BindingType::Binding && !completed[source.node_idx]) {
+                completed[node_idx] = 0;
+                outputs[node_idx].clear();
+                break;
+            }
+        }
+    }
+
+    restored = completed;
+    for (uint32_t node_idx = 0; node_idx < plan.node_count; ++node_idx) {
+        if (completed[node_idx]) {
+            instance.outputs[node_idx] = outputs[node_idx];
+        }
+    }
+    last_save = std::chrono::steady_clock::now();
+}
+
+void Checkpoint::complete(uint32_t node_idx, const NodeOutputs &node_outputs) {
+    std::vector<std::byte> record;
+    if (!std::ranges::all_of(node_outputs, is_encodable) || !append_record(record, node_idx, node_outputs)) {
+        return;
+    }
+
+    bool due = false;
+    {
+        std::lock_guard lock(mutex);
+        completed[node_idx] = 1;
+        outputs[node_idx] = node_outputs;
+        pending.insert(pending.end(), record.begin(), record.end());
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_save >= interval) {
+            last_save = now;
+            due = true;
+        }
+    }
+
+    // a node finishing while another one writes leaves its record for the next write
+    std::unique_lock write_lock(write_mutex, std::try_to_lock);
+    if (due && write_lock.owns_lock()) {
+        write_checkpoint(*this);
+    }
+}
+
+void Checkpoint::end_run(RunResult result) {
+    std::lock_guard write_lock(write_mutex);
+    if (result != RunResult::Ok) {
+        write_checkpoint(*this);
+        return;
+    }
+
+    std::lock_guard lock(mutex);
+    std::ranges::fill(completed, 0);
+    std::ranges::fill(outputs, NodeOutputs{});
+    pending.clear();
+    rewrite = true;
+    std::error_code error;
+    std::filesystem::remove(path, error);
+}
+
+
+uint64_t instance_fingerprint(const GraphInstance &instance) {
+    const auto &plan = *instance.plan;
+
+    uint64_t hash = hash_combine(0, plan.node_count);
+    for (uint32_t node_idx = 0; node_idx < plan.node_count; ++node_idx) {
+        const auto *func = plan.funcs[node_idx];
+        hash = hash_combine(hash, func != nullptr ? hash_uuid(func->id) : 0);
+
+        for (auto source_idx = plan.source_offsets[node_idx]; source_idx < plan.source_offsets[node_idx + 1]; ++source_idx) {
+            const auto &source = plan.sources[source_idx];
+            hash = hash_combine(hash, static_cast<uint64_t>(source.binding));
+            switch (source.binding) {
+                case BindingType::None:
+                    break;
+                case BindingType::Const:
+                    hash = hash_combine(hash, hash_value(instance.const_value(source_idx)));
+                    break;
+                case BindingType::Binding:
+                    hash = hash_combine(hash, (static_cast<uint64_t>(source.node_idx) << 32) | source.output_idx);
+                    break;
+            }
+        }
+    }
+    return hash;
+}
+
+bool save_checkpoint(Checkpoint &checkpoint) {
+    std::lock_guard write_lock(checkpoint.write_mutex);
+    {
+        std::lock_guard lock(checkpoint.mutex);
+        checkpoint.rewrite = true;
+    }
+    return write_checkpoint(checkpoint);
+}
+
+bool load_checkpoint(Checkpoint *checkpoint, const std::string &path) {
+    checkpoint->path = path;
+    checkpoint->fingerprint = 0;
+    checkpoint->completed.clear();
+    checkpoint->outputs.clear();
+    checkpoint->pending.clear();
+    checkpoint->rewrite = true;
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return true;
+    }
+    std::vector<std::byte> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file || bytes.size() < CheckpointHeaderSize
+        || load_u32(bytes.data()) != CheckpointMagic || load_u32(bytes.data() + 4) != CheckpointVersion) {
+        return false;
+    }
+
+    const auto node_count = load_u32(bytes.data() + 8);
+    uint64_t fingerprint = 0;
+    std::memcpy(&fingerprint, bytes.data() + 16, sizeof(fingerprint));
+    std::vector<uint8_t> completed(node_count, 0);
+    std::vector<NodeOutputs> outputs(node_count);
+
+    // a record torn by a crash ends the file, the first write then starts it over
+    size_t offset = CheckpointHeaderSize;
+    while (bytes.size() - offset >= RecordHeaderSize) {
+        const auto node_idx = load_u32(bytes.data() + offset);
+        const auto payload_size = load_u32(bytes.data() + offset + 4);
+        uint64_t checksum;
+        std::memcpy(&checksum, bytes.data() + offset + 8, sizeof(checksum));
+        if (payload_size > bytes.size() - offset - RecordHeaderSize) {
+            break;
+        }
+        const auto payload = std::span<const std::byte>(bytes.data() + offset + RecordHeaderSize, payload_size);
+        if (hash_bytes(payload.data(), payload.size()) != checksum) {
+            break;
+        }
+        if (node_idx >= node_count || !decode_values(payload, outputs[node_idx], false)) {
+            return false;
+        }
+        completed[node_idx] = 1;
+        offset += RecordHeaderSize + payload_size;
+    }
+
+    checkpoint->fingerprint = fingerprint;
+    checkpoint->completed = std::move(completed);
+    checkpoint->outputs = std::move(outputs);
+    checkpoint->rewrite = offset != bytes.size();
+    return true;
+}
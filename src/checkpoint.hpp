@@ -0,0 +1,71 @@
+#pragma once
+
+#include "plan.hpp"
+#include "value.hpp"
+
+#include "utils/nocopy.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// Completed node outputs of a GraphInstance, saved to disk every interval while the instance
+// runs. A run that starts with a checkpoint of the same plan and Const inputs takes the saved
+// outputs instead of evaluating those nodes again, so a crashed or pre-empted run resumes where
+// the last save left off. A run that completes removes the file, a cancelled or timed out one
+// saves what it got.
+//
+// Nodes of streaming funcs and nodes with outputs that have no encoding (see encoding.hpp) are
+// not saved and always run again.
+//
+// Stored as a 32 byte header (magic, version, node count, padding, fingerprint, padding)
+// followed by one record per completed node: node index, payload size, checksum of the payload,
+// then the outputs in the encoding of encoding.hpp. A finishing node encodes its record and
+// queues it; once per interval one of them appends the queued records to the file and syncs it,
+// outside the lock the others queue under. The file is only written whole, next to it and
+// renamed over, when it is started for another fingerprint, after a failed append, after loading
+// one with a torn end and by save_checkpoint(). A record torn by a crash ends the load.
+struct Checkpoint {
+    NOCOPY(Checkpoint)
+
+    std::string path;
+    std::chrono::milliseconds interval{60000};
+
+    std::mutex write_mutex; // held while writing the file, taken before mutex
+
+    std::mutex mutex; // guards everything below while the instance runs
+    uint64_t fingerprint = 0;
+    std::vector<uint8_t> completed; // per node
+    std::vector<NodeOutputs> outputs;
+    std::vector<std::byte> pending; // records queued since the last write
+    bool rewrite = true;            // the next write replaces the file instead of appending to it
+    std::chrono::steady_clock::time_point last_save{};
+    uint32_t save_count = 0;
+
+    Checkpoint() = default;
+
+    // Called by the executor before a run. Copies the saved outputs that still apply into the
+    // instance and marks their nodes in restored; anything saved for another plan or other Const
+    // inputs is dropped, and so is every node with a producer that was not saved.
+    void begin_run(GraphInstance &instance, std::vector<uint8_t> &restored);
+
+    // called by the executor for every node that produced its outputs
+    void complete(uint32_t node_idx, const NodeOutputs &node_outputs);
+
+    void end_run(RunResult result);
+};
+
+// hash of the funcs, wiring and Const inputs of the instance, outputs saved for one fingerprint
+// are valid for any instance with the same one
+uint64_t instance_fingerprint(const GraphInstance &instance);
+
+// writes the whole checkpoint, completed and outputs may have been changed by hand
+bool save_checkpoint(Checkpoint &checkpoint);
+
+// Reads the checkpoint at path, a missing file leaves an empty checkpoint that runs start from
+// scratch with. Returns false for a file that is not a valid checkpoint; records after one that
+// was torn are ignored.
+bool load_checkpoint(Checkpoint *checkpoint, const std::string &path);
@@ -0,0 +1,77 @@
+#include "datatype.hpp"
+
+#include "tensor.hpp"
+
+#include "utils/utils.hpp"
+
+
+DatatypeRegistry::DatatypeRegistry() : types(MaxDatatypes) {
+    Datatype none{};
+    none.name = "none";
+    none.trivial = true;
+    add(std::move(none));
+    add(make_datatype<int32_t>(DatatypeInt, "int"));
+    add(make_datatype<float>(DatatypeFloat, "float"));
+    add(make_datatype<int64_t>(DatatypeInt64, "int64"));
+    add(make_datatype<double>(DatatypeDouble, "double"));
+    add(make_datatype<bool>(DatatypeBool, "bool"));
+    add(make_datatype<std::string>(DatatypeString, "string"));
+    add(make_datatype<Tensor>(DatatypeTensor, "tensor"));
+}
+
+void DatatypeRegistry::add(Datatype datatype) {
+    assert(datatype.id < MaxDatatypes);
+    const auto id = datatype.id;
+
+    // readers only touch the slot once registered is set, ids may be sparse
+    std::lock_guard lock(mutex);
+    assert(!contains(id));
+    types[id] = std::move(datatype);
+    registered[id].store(true, std::memory_order_release);
+}
+
+// leaked on purpose, Values in other statics are destroyed through it at exit
+DatatypeRegistry &datatype_registry() {
+    static auto *registry = new DatatypeRegistry{};
+    return *registry;
+}
+
+
+uint64_t hash_trivial(const void *data, size_t size) {
+    if (size == 4) {
+        uint32_t word;
+        std::memcpy(&word, data, sizeof(word));
+        return mix64(word);
+    }
+    if (size == 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        return mix64(word);
+    }
+    return hash_bytes(data, size);
+}
+
+void hash_values(const Datatype &datatype, const void *values, size_t count, uint64_t *hashes) {
+    if (datatype.ops.hash_batch != nullptr) {
+        datatype.ops.hash_batch(values, count, hashes);
+        return;
+    }
+
+    auto bytes = static_cast<const std::byte *>(values);
+    for (size_t i = 0; i < count; ++i) {
+        hashes[i] = datatype.ops.hash(bytes + i * datatype.size);
+    }
+}
+
+void copy_values(const Datatype &datatype, void *dst, const void *src, size_t count) {
+    if (datatype.ops.copy_batch != nullptr) {
+        datatype.ops.copy_batch(dst, src, count);
+        return;
+    }
+
+    auto dst_bytes = static_cast<std::byte *>(dst);
+    auto src_bytes = static_cast<const std::byte *>(src);
+    for (size_t i = 0; i < count; ++i) {
+        datatype.ops.copy(dst_bytes + i * datatype.size, src_bytes + i * datatype.size);
+    }
+}
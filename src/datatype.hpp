@@ -0,0 +1,173 @@
+#pragma once
+
+#include "utils/nocopy.hpp"
+
+#include <yaml-cpp/yaml.h>
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+using DatatypeId = uint32_t;
+
+constexpr DatatypeId DatatypeNone = 0;
+constexpr DatatypeId DatatypeInt = 1;
+constexpr DatatypeId DatatypeFloat = 2;
+constexpr DatatypeId DatatypeInt64 = 3;
+constexpr DatatypeId DatatypeDouble = 4;
+constexpr DatatypeId DatatypeBool = 5;
+constexpr DatatypeId DatatypeString = 6;
+constexpr DatatypeId DatatypeTensor = 7; // Tensor, see tensor.hpp
+
+constexpr DatatypeId MaxDatatypes = 1024;
+
+
+// Operations on a single value of a datatype, the pointers refer to properly aligned storage of
+// Datatype::size bytes. construct, copy and move build into uninitialized storage.
+struct DatatypeOps {
+    void (*construct)(void *dst) = nullptr;
+    void (*copy)(void *dst, const void *src) = nullptr;
+    void (*move)(void *dst, void *src) = nullptr;
+    void (*destroy)(void *value) = nullptr;
+    uint64_t (*hash)(const void *value) = nullptr;
+    bool (*equal)(const void *lhs, const void *rhs) = nullptr;
+    void (*emit)(YAML::Emitter &out, const void *value) = nullptr;
+    bool (*parse)(const YAML::Node &node, void *value) = nullptr; // into a constructed value
+
+    // optional kernels over count consecutive values, the generic paths loop over the ops above
+    void (*hash_batch)(const void *values, size_t count, uint64_t *hashes) = nullptr;
+    void (*copy_batch)(void *dst, const void *src, size_t count) = nullptr;
+};
+
+struct Datatype {
+    DatatypeId id = DatatypeNone;
+    std::string name;
+    uint32_t size = 0;
+    uint32_t alignment = 1;
+    bool trivial = false; // trivially copyable, copies and moves are memcpy
+    DatatypeOps ops;
+};
+
+// Datatypes indexed by id. Lookups are lock-free: add() fills the slot of the id under a mutex
+// and then publishes it with a release store, so datatypes may be registered while other threads
+// look up the ones registered before. A registered datatype never changes.
+struct DatatypeRegistry {
+    NOCOPY(DatatypeRegistry)
+
+    std::vector<Datatype> types; // MaxDatatypes slots, only the registered ones are filled in
+    std::array<std::atomic<bool>, MaxDatatypes> registered{};
+    std::mutex mutex; // serializes add()
+
+    DatatypeRegistry();
+
+    void add(Datatype datatype);
+
+    [[nodiscard]] const Datatype &get(DatatypeId id) const {
+        assert(contains(id));
+        return types[id];
+    }
+
+    [[nodiscard]] bool contains(DatatypeId id) const {
+        return id < MaxDatatypes && registered[id].load(std::memory_order_acquire);
+    }
+};
+
+DatatypeRegistry &datatype_registry();
+
+inline const Datatype &get_datatype(DatatypeId id) {
+    return datatype_registry().get(id);
+}
+
+
+// 64-bit finalizer from MurmurHash3
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+// word-sized values go through mix64 so that hash_batch and hash agree
+uint64_t hash_trivial(const void *data, size_t size);
+
+template<typename T>
+uint64_t hash_datatype_value(const T &value) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        return hash_trivial(&value, sizeof(T));
+    } else {
+        return static_cast<uint64_t>(std::hash<T>{}(value));
+    }
+}
+
+// Builds a Datatype for T out of its constructors, std::hash and operator==. Trivially copyable
+// types hash and compare by their bytes instead, so NaN equals itself and -0.0 differs from 0.0
+// like in the output cache and in tensors. Values are emitted with YAML::Emitter::operator<< and parsed
+// with YAML::convert<T> if T supports them.
+template<typename T>
+Datatype make_datatype(DatatypeId id, std::string name) {
+    Datatype datatype{};
+    datatype.id = id;
+    datatype.name = std::move(name);
+    datatype.size = sizeof(T);
+    datatype.alignment = alignof(T);
+    datatype.trivial = std::is_trivially_copyable_v<T>;
+
+    auto &ops = datatype.ops;
+    ops.construct = [](void *dst) { new(dst) T{}; };
+    ops.copy = [](void *dst, const void *src) { new(dst) T(*static_cast<const T *>(src)); };
+    ops.move = [](void *dst, void *src) { new(dst) T(std::move(*static_cast<T *>(src))); };
+    ops.destroy = [](void *value) { static_cast<T *>(value)->~T(); };
+    ops.hash = [](const void *value) { return hash_datatype_value(*static_cast<const T *>(value)); };
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        ops.equal = [](const void *lhs, const void *rhs) { return std::memcmp(lhs, rhs, sizeof(T)) == 0; };
+    } else {
+        ops.equal = [](const void *lhs, const void *rhs) {
+            return *static_cast<const T *>(lhs) == *static_cast<const T *>(rhs);
+        };
+    }
+    if constexpr (requires(YAML::Emitter &out, const T &value) { out << value; }) {
+        ops.emit = [](YAML::Emitter &out, const void *value) { out << *static_cast<const T *>(value); };
+    }
+    if constexpr (requires(const YAML::Node &node, T &value) { YAML::convert<T>::decode(node, value); }) {
+        ops.parse = [](const YAML::Node &node, void *value) {
+            return YAML::convert<T>::decode(node, *static_cast<T *>(value));
+        };
+    }
+
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        ops.copy_batch = [](void *dst, const void *src, size_t count) {
+            std::memcpy(dst, src, count * sizeof(T));
+        };
+        if constexpr (sizeof(T) == 4 || sizeof(T) == 8) {
+            ops.hash_batch = [](const void *values, size_t count, uint64_t *hashes) {
+                using Word = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+                auto bytes = static_cast<const std::byte *>(values);
+                // branch-free per element so the compiler vectorizes it
+                for (size_t i = 0; i < count; ++i) {
+                    Word word;
+                    std::memcpy(&word, bytes + i * sizeof(T), sizeof(T));
+                    hashes[i] = mix64(word);
+                }
+            };
+        }
+    }
+
+    return datatype;
+}
+
+
+// generic helpers over count consecutive values, they use the batch kernels when available
+void hash_values(const Datatype &datatype, const void *values, size_t count, uint64_t *hashes);
+
+void copy_values(const Datatype &datatype, void *dst, const void *src, size_t count);
@@ -0,0 +1,181 @@
+#include "encoding.hpp"
+
+#include "tensor.hpp"
+
+#include <algorithm>
+#include <limits>
+
+
+// value record: datatype, payload size, 8 bytes of padding, payload padded to 16 bytes
+static constexpr uint32_t ValueHeaderSize = 16;
+
+// payload sizes are stored in 32 bits and padded, tensor shapes take 4 bytes per axis
+static constexpr size_t MaxPayloadSize = std::numeric_limits<uint32_t>::max() - EncodingAlignment;
+static constexpr uint32_t MaxTensorRank = 64;
+
+static size_t padded(size_t size) {
+    return (size + EncodingAlignment - 1) & ~static_cast<size_t>(EncodingAlignment - 1);
+}
+
+static size_t payload_size(const Value &value) {
+    switch (value.datatype) {
+        case DatatypeNone:
+            return 0;
+        case DatatypeString:
+            return static_cast<const std::string *>(value.data())->size();
+        case DatatypeTensor: {
+            const auto &tensor = *static_cast<const Tensor *>(value.data());
+            if (tensor.element == DatatypeNone || !get_datatype(tensor.element).trivial) {
+                return 0;
+            }
+            return padded(8 + 4 * tensor.shape.size()) + tensor.byte_size();
+        }
+        default: {
+            const auto &type = get_datatype(value.datatype);
+            return type.trivial ? type.size : 0;
+        }
+    }
+}
+
+bool is_encodable(const Value &value) {
+    if (value.datatype != DatatypeTensor) {
+        return is_encodable_datatype(value.datatype) && payload_size(value) <= MaxPayloadSize;
+    }
+    const auto &tensor = *static_cast<const Tensor *>(value.data());
+    return tensor.element != DatatypeNone && get_datatype(tensor.element).trivial
+           && tensor.shape.size() <= MaxTensorRank && payload_size(value) <= MaxPayloadSize;
+}
+
+bool is_encodable_datatype(DatatypeId datatype) {
+    if (datatype == DatatypeNone || datatype == DatatypeString || datatype == DatatypeTensor) {
+        return true;
+    }
+    if (!datatype_registry().contains(datatype)) {
+        return false;
+    }
+    const auto &type = get_datatype(datatype);
+    return type.trivial && type.alignment <= EncodingAlignment;
+}
+
+size_t encoded_size(std::span<const Value> values) {
+    size_t size = EncodingAlignment;
+    for (const auto &value: values) {
+        size += ValueHeaderSize + (is_encodable(value) ? padded(payload_size(value)) : 0);
+    }
+    return size;
+}
+
+void encode_values(std::span<const Value> values, std::byte *dst) {
+    std::memset(dst, 0, EncodingAlignment);
+    store_u32(dst, static_cast<uint32_t>(values.size()));
+    dst += EncodingAlignment;
+
+    for (const auto &value: values) {
+        // anything without a raw byte representation arrives as an empty value
+        const auto datatype = is_encodable(value) ? value.datatype : DatatypeNone;
+        const auto size = datatype != DatatypeNone ? static_cast<uint32_t>(payload_size(value)) : 0;
+        std::memset(dst, 0, ValueHeaderSize);
+        store_u32(dst, datatype);
+        store_u32(dst + 4, size);
+        dst += ValueHeaderSize;
+
+        if (datatype == DatatypeString) {
+            std::memcpy(dst, static_cast<const std::string *>(value.data())->data(), size);
+        } else if (datatype == DatatypeTensor) {
+            const auto &tensor = *static_cast<const Tensor *>(value.data());
+            const auto shape_size = padded(8 + 4 * tensor.shape.size());
+            std::memset(dst, 0, shape_size);
+            store_u32(dst, tensor.element);
+            store_u32(dst + 4, static_cast<uint32_t>(tensor.shape.size()));
+            for (size_t i = 0; i < tensor.shape.size(); ++i) {
+                store_u32(dst + 8 + 4 * i, tensor.shape[i]);
+            }
+            std::memcpy(dst + shape_size, tensor.data(), tensor.byte_size());
+        } else if (datatype != DatatypeNone) {
+            std::memcpy(dst, value.data(), size);
+        }
+        dst += padded(size);
+    }
+}
+
+bool decode_values(std::span<const std::byte> src, std::vector<Value> &values, bool borrow) {
+    if (src.size() < EncodingAlignment) {
+        return false;
+    }
+    const auto count = load_u32(src.data());
+    size_t offset = EncodingAlignment;
+    if (count > (src.size() - offset) / ValueHeaderSize) {
+        return false;
+    }
+
+    values.clear();
+    values.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (offset + ValueHeaderSize > src.size()) {
+            return false;
+        }
+        const auto datatype = load_u32(src.data() + offset);
+        const auto size = load_u32(src.data() + offset + 4);
+        offset += ValueHeaderSize;
+        if (size > src.size() - offset || (datatype != DatatypeNone && !datatype_registry().contains(datatype))) {
+            return false;
+        }
+        const auto payload = src.data() + offset;
+        offset += std::min(padded(size), src.size() - offset);
+
+        auto &value = values.emplace_back();
+        if (datatype == DatatypeNone) {
+            continue;
+        }
+        if (datatype == DatatypeString) {
+            value = make_value(DatatypeString, std::string(reinterpret_cast<const char *>(payload), size));
+            continue;
+        }
+        if (datatype == DatatypeTensor) {
+            // element, rank and shape, then the elements, all within the payload
+            if (size < 8) {
+                return false;
+            }
+            Tensor tensor{};
+            tensor.element = load_u32(payload);
+            const auto rank = load_u32(payload + 4);
+            if (tensor.element == DatatypeNone || !datatype_registry().contains(tensor.element)
+                || !get_datatype(tensor.element).trivial || rank > MaxTensorRank) {
+                return false;
+            }
+            const auto shape_size = padded(8 + 4 * static_cast<size_t>(rank));
+            if (shape_size > size) {
+                return false;
+            }
+            size_t byte_size = get_datatype(tensor.element).size;
+            for (uint32_t axis = 0; axis < rank; ++axis) {
+                const auto extent = load_u32(payload + 8 + 4 * axis);
+                if (extent != 0 && byte_size > (size - shape_size) / extent) {
+                    return false;
+                }
+                byte_size *= extent;
+                tensor.shape.push_back(extent);
+            }
+            if (shape_size + byte_size > size) {
+                return false;
+            }
+            const auto elements = payload + shape_size;
+            if (borrow) {
+                tensor.storage = std::shared_ptr<std::byte>(const_cast<std::byte *>(elements), [](std::byte *) {});
+            } else {
+                tensor = Tensor::uninitialized(tensor.element, std::move(tensor.shape));
+                std::memcpy(tensor.mutable_data(), elements, tensor.byte_size());
+            }
+            value = make_value(DatatypeTensor, std::move(tensor));
+            continue;
+        }
+
+        const auto &type = get_datatype(datatype);
+        if (!type.trivial || type.size != size) {
+            return false;
+        }
+        std::memcpy(value.allocate(type), payload, size);
+        value.datatype = datatype;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "value.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+
+// Raw byte encoding of values shared by the remote worker channel and traces. Every part of an
+// encoding starts 16 byte aligned relative to its beginning, so element data can be used in place.
+constexpr uint32_t EncodingAlignment = 16;
+
+constexpr uint32_t align_up(uint32_t size, uint32_t alignment) {
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+inline uint32_t load_u32(const std::byte *src) {
+    uint32_t value;
+    std::memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+inline void store_u32(std::byte *dst, uint32_t value) {
+    std::memcpy(dst, &value, sizeof(value));
+}
+
+
+// Values are written as raw bytes of their datatype: trivial datatypes and strings directly,
+// tensors of trivial elements as shape plus element bytes. Other datatypes, tensors of more than
+// 64 axes and values of 4 GiB or more are not supported and come back as empty values.
+bool is_encodable(const Value &value);
+
+// whether values of the datatype can be encoded, tensors only if their elements can
+bool is_encodable_datatype(DatatypeId datatype);
+
+size_t encoded_size(std::span<const Value> values);
+
+void encode_values(std::span<const Value> values, std::byte *dst);
+
+// Returns false unless src holds a complete encoding, every value is checked against the bounds
+// of src. With borrow set, tensors point into src instead of owning a copy of their elements and
+// must not outlive it.
+bool decode_values(std::span<const std::byte> src, std::vector<Value> &values, bool borrow);
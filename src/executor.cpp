@@ -0,0 +1,773 @@
+#include "executor.hpp"
+
+#include "checkpoint.hpp"
+#include "subgraph.hpp"
+#include "trace.hpp"
+
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+
+
+struct RunState {
+    TenantId tenant = 0;
+    const GraphPlan *plan = nullptr;
+    GraphInstance *instance = nullptr;
+    std::vector<uint32_t> pending; // producers not finished yet
+    std::vector<uint8_t> stopped;  // nodes skipped, cancelled, past their timeout or not evaluated
+    uint32_t remaining = 0;
+    std::condition_variable done_cv;
+    std::vector<std::unique_ptr<StreamChannel>> channels; // indexed like GraphPlan::streams
+    std::vector<std::thread> stages;                      // streaming nodes, joined by run()
+    const CancelToken *token = nullptr;
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> timed_out{false};
+    std::atomic<bool> invalid{false};
+};
+
+// Nodes are skipped once the run is cancelled and after a producer that was stopped, their inputs
+// are missing then. Streaming producers may still be running, only the finished ones are looked at.
+static bool skip_node(RunState &run, uint32_t node_idx) {
+    const auto &plan = *run.plan;
+    if (run.token != nullptr && run.token->is_cancelled()) {
+        run.cancelled = true;
+        run.stopped[node_idx] = 1;
+        return true;
+    }
+    for (auto source_idx = plan.source_offsets[node_idx]; source_idx < plan.source_offsets[node_idx + 1]; ++source_idx) {
+        const auto &source = plan.sources[source_idx];
+        if (!source.streaming && source.binding == BindingType::Binding && run.stopped[source.node_idx]) {
+            run.stopped[node_idx] = 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+static CancelScope node_scope(const RunState &run, uint32_t node_idx) {
+    CancelScope scope{};
+    scope.token = run.token;
+    if (const auto timeout = run.plan->timeouts[node_idx]; timeout != 0) {
+        scope.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    }
+    return scope;
+}
+
+// Outputs of a node that was cancelled, ran out of time or could not be evaluated are dropped,
+// returns whether they were.
+static bool drop_if_stopped(
+        RunState &run,
+        uint32_t node_idx,
+        const CancelScope &scope,
+        bool evaluated,
+        std::span<Value> outputs
+) {
+    if (scope.is_cancelled()) {
+        run.cancelled = true;
+    } else if (scope.is_expired()) {
+        run.timed_out = true;
+    } else if (!evaluated) {
+        run.invalid = true;
+    } else {
+        return false;
+    }
+    run.stopped[node_idx] = 1;
+    for (auto &output: outputs) {
+        output.reset();
+    }
+    return true;
+}
+
+static Value input_value(const GraphPlan &plan, const GraphInstance &instance, uint32_t source_idx) {
+    const auto &source = plan.sources[source_idx];
+    switch (source.binding) {
+        case BindingType::None:
+            return {};
+        case BindingType::Const:
+            return instance.const_value(source_idx);
+        case BindingType::Binding: {
+            const auto &produced = instance.outputs[source.node_idx];
+            return source.output_idx < produced.size() ? produced[source.output_idx] : Value{};
+        }
+    }
+    assert(false);
+}
+
+
+OutputCache::OutputCache(size_t capacity) : capacity(capacity) {}
+
+CacheLookup OutputCache::acquire(
+        const FuncId &func_id,
+        std::span<const Value> inputs,
+        uint64_t hash,
+        const NodeTask &task,
+        NodeOutputs &outputs,
+        Entry *&entry
+) {
+    std::lock_guard lock(mutex);
+
+    auto [begin, end] = index.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+        auto &candidate = *it->second;
+        if (candidate.func_id != func_id || !std::ranges::equal(candidate.inputs, inputs)) {
+            continue;
+        }
+
+        entries.splice(entries.begin(), entries, it->second);
+        if (!candidate.ready) {
+            candidate.waiters.push_back(task);
+            return CacheLookup::Pending;
+        }
+        ++hits;
+        outputs = candidate.outputs;
+        return CacheLookup::Hit;
+    }
+
+    ++misses;
+    auto &created = entries.emplace_front();
+    created.func_id = func_id;
+    created.inputs.assign(inputs.begin(), inputs.end());
+    created.hash = hash;
+    index.emplace(hash, entries.begin());
+    entry = &created;
+    return CacheLookup::Miss;
+}
+
+std::vector<NodeTask> OutputCache::publish(Entry *entry, const NodeOutputs &outputs) {
+    std::lock_guard lock(mutex);
+
+    entry->ready = true;
+    entry->outputs = outputs;
+    auto waiters = std::move(entry->waiters);
+    entry->waiters.clear();
+
+    // pending entries are never evicted, their producer still holds a pointer to them
+    while (entries.size() > capacity && entries.back().ready) {
+        auto [begin, end] = index.equal_range(entries.back().hash);
+        for (auto it = begin; it != end; ++it) {
+            if (&*it->second == &entries.back()) {
+                index.erase(it);
+                break;
+            }
+        }
+        entries.pop_back();
+    }
+
+    return waiters;
+}
+
+std::vector<NodeTask> OutputCache::discard(Entry *entry) {
+    std::lock_guard lock(mutex);
+
+    auto waiters = std::move(entry->waiters);
+    auto [begin, end] = index.equal_range(entry->hash);
+    for (auto it = begin; it != end; ++it) {
+        if (&*it->second == entry) {
+            entries.erase(it->second);
+            index.erase(it);
+            break;
+        }
+    }
+    return waiters;
+}
+
+void OutputCache::clear() {
+    std::lock_guard lock(mutex);
+
+    std::erase_if(index, [](const auto &item) { return item.second->ready; });
+    std::erase_if(entries, [](const Entry &entry) { return entry.ready; });
+}
+
+uint64_t hash_inputs(const FuncId &func_id, std::span<const Value> inputs) {
+    uint64_t hash = hash_uuid(func_id);
+    for (const auto &input: inputs) {
+        hash = hash_combine(hash, hash_value(input));
+    }
+    return hash;
+}
+
+
+Executor::Executor(const ExecutorConfig &config)
+        : cache(config.cache_capacity), chunk_bytes(config.chunk_bytes), stream_capacity(config.stream_capacity) {
+    auto thread_count = config.thread_count;
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(thread_count);
+    for (uint32_t i = 0; i < thread_count; ++i) {
+        workers.emplace_back([this] { worker_loop(); });
+    }
+}
+
+Executor::~Executor() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+TenantId Executor::add_tenant(const TenantQuota &quota) {
+    std::lock_guard lock(mutex);
+
+    auto &tenant = tenants.emplace_back();
+    tenant.quota = quota;
+    return static_cast<TenantId>(tenants.size() - 1);
+}
+
+void Executor::set_quota(TenantId tenant, const TenantQuota &quota) {
+    {
+        std::lock_guard lock(mutex);
+        assert(tenant < tenants.size());
+        tenants[tenant].quota = quota;
+    }
+    work_cv.notify_all();
+}
+
+RunResult Executor::run(TenantId tenant, GraphInstance &instance, const CancelToken *token) {
+    const auto &plan = *instance.plan;
+
+    RunState run{};
+    run.tenant = tenant;
+    run.plan = &plan;
+    run.instance = &instance;
+    run.pending = plan.producer_counts;
+    run.stopped.assign(plan.node_count, 0);
+    run.remaining = plan.evaluated_count;
+    run.token = token;
+
+    instance.outputs.assign(plan.node_count, {});
+    if (instance.trace != nullptr) {
+        instance.trace->begin_run(plan);
+    }
+
+    // nodes restored from a checkpoint count as finished before anything starts
+    std::vector<uint32_t> ready = plan.roots;
+    if (instance.checkpoint != nullptr) {
+        std::vector<uint8_t> restored;
+        instance.checkpoint->begin_run(instance, restored);
+        if (std::ranges::find(restored, 1) != restored.end()) {
+            for (uint32_t node_idx = 0; node_idx < plan.node_count; ++node_idx) {
+                if (!restored[node_idx]) {
+                    continue;
+                }
+                --run.remaining;
+                for (auto i = plan.consumer_offsets[node_idx]; i < plan.consumer_offsets[node_idx + 1]; ++i) {
+                    --run.pending[plan.consumers[i]];
+                }
+            }
+            ready.clear();
+            for (uint32_t node_idx = 0; node_idx < plan.node_count; ++node_idx) {
+                if (plan.funcs[node_idx] != nullptr && !restored[node_idx] && run.pending[node_idx] == 0) {
+                    ready.push_back(node_idx);
+                }
+            }
+        }
+    }
+
+    if (run.remaining != 0) {
+        run.channels.reserve(plan.streams.size());
+        for (const auto &stream: plan.streams) {
+            auto &channel = run.channels.emplace_back(std::make_unique<StreamChannel>(stream_capacity));
+            if (stream.binding == BindingType::Const) {
+                channel->push(instance.const_value(stream.source_idx));
+                channel->close();
+            }
+        }
+
+        std::unique_lock lock(mutex);
+        assert(tenant < tenants.size());
+        for (const auto node_idx: ready) {
+            tenants[tenant].ready.push_back(NodeTask{&run, node_idx});
+        }
+        work_cv.notify_all();
+        run.done_cv.wait(lock, [&run] { return run.remaining == 0; });
+
+        auto stages = std::move(run.stages);
+        lock.unlock();
+        for (auto &stage: stages) {
+            stage.join();
+        }
+    }
+
+    auto result = RunResult::Ok;
+    if (run.cancelled) {
+        result = RunResult::Cancelled;
+    } else if (run.timed_out) {
+        result = RunResult::TimedOut;
+    } else if (run.invalid) {
+        result = RunResult::InvalidInput;
+    }
+    if (instance.checkpoint != nullptr) {
+        instance.checkpoint->end_run(result);
+    }
+    return result;
+}
+
+RunResult Executor::run(
+        TenantId tenant,
+        const Graph &graph,
+        const FuncLib &lib,
+        std::vector<NodeOutputs> &outputs,
+        const CancelToken *token
+) {
+    auto plan = std::make_shared<GraphPlan>();
+    auto result = compile_plan(graph, lib, *plan);
+    if (result != RunResult::Ok) {
+        return result;
+    }
+
+    GraphInstance instance{std::move(plan)};
+    result = run(tenant, instance, token);
+    outputs = std::move(instance.outputs);
+    return result;
+}
+
+void Executor::worker_loop() {
+    std::unique_lock lock(mutex);
+    while (true) {
+        NodeTask task{};
+        while (!stopping && jobs.empty() && !pop_task(task)) {
+            work_cv.wait(lock);
+        }
+        if (stopping) {
+            return;
+        }
+
+        // chunks of a node that is already running go before new nodes
+        if (task.run == nullptr) {
+            auto *job = jobs.front();
+            if (job->next >= job->chunk_count) {
+                jobs.erase(jobs.begin());
+                continue;
+            }
+            ++job->helpers;
+            lock.unlock();
+            const auto processed = drain(*job);
+            lock.lock();
+            job->finished += processed;
+            --job->helpers;
+            job->done_cv.notify_all();
+            continue;
+        }
+
+        // the run may be gone once its last node finishes, keep what is needed afterwards
+        const auto tenant = task.run->tenant;
+        lock.unlock();
+        execute(task);
+        lock.lock();
+
+        --tenants[tenant].in_flight;
+        if (!tenants[tenant].ready.empty()) {
+            work_cv.notify_one();
+        }
+    }
+}
+
+bool Executor::pop_task(NodeTask &task) {
+    for (size_t scanned = 0; scanned < tenants.size(); ++scanned) {
+        auto &tenant = tenants[cursor];
+        if (!tenant.ready.empty() && tenant.in_flight < tenant.quota.max_in_flight) {
+            if (credit == 0) {
+                credit = std::max(1u, tenant.quota.weight);
+            }
+            task = tenant.ready.front();
+            tenant.ready.pop_front();
+            ++tenant.in_flight;
+            if (--credit == 0) {
+                cursor = (cursor + 1) % tenants.size();
+            }
+            return true;
+        }
+
+        credit = 0;
+        cursor = (cursor + 1) % tenants.size();
+    }
+    return false;
+}
+
+void Executor::execute(const NodeTask &task) {
+    auto &run = *task.run;
+    const auto &plan = *run.plan;
+    auto &node_outputs = run.instance->outputs;
+    const auto &func = *plan.funcs[task.node_idx];
+
+    if (func.is_streaming()) {
+        std::lock_guard lock(mutex);
+        run.stages.emplace_back([this, task] { run_stage(task); });
+        return;
+    }
+
+    // skipped nodes still finish, so the run drains without evaluating anything else
+    if (skip_node(run, task.node_idx)) {
+        finish(&run, task.node_idx, false);
+        return;
+    }
+
+    std::vector<Value> inputs;
+    const auto sources_begin = plan.source_offsets[task.node_idx];
+    const auto sources_end = plan.source_offsets[task.node_idx + 1];
+    inputs.reserve(sources_end - sources_begin);
+    for (auto source_idx = sources_begin; source_idx < sources_end; ++source_idx) {
+        inputs.push_back(input_value(plan, *run.instance, source_idx));
+    }
+
+    NodeOutputs outputs(func.output_count());
+    const auto scope = node_scope(run, task.node_idx);
+    CancelScopeGuard scope_guard(scope);
+
+    if (func.behavior == FuncBehavior::Impure) {
+        auto *trace = run.instance->trace;
+        bool produced = true;
+        if (trace == nullptr || trace->mode == TraceMode::Record) {
+            const auto evaluated = call_func(func, inputs, outputs);
+            produced = !drop_if_stopped(run, task.node_idx, scope, evaluated, outputs);
+            if (produced && trace != nullptr) {
+                trace->record(task.node_idx, outputs);
+            }
+        } else {
+            // a node missing from the trace fails like one that could not be evaluated
+            const auto replayed = trace->replay(task.node_idx, outputs);
+            produced = !drop_if_stopped(run, task.node_idx, scope, replayed, outputs);
+        }
+        node_outputs[task.node_idx] = std::move(outputs);
+        finish(&run, task.node_idx, produced);
+        return;
+    }
+
+    // element-wise funcs skip the cache, hashing their tensor inputs costs about as much as the func
+    if (func.elementwise.has_value()) {
+        const auto evaluated = call_func(func, inputs, outputs);
+        const auto produced = !drop_if_stopped(run, task.node_idx, scope, evaluated, outputs);
+        node_outputs[task.node_idx] = std::move(outputs);
+        finish(&run, task.node_idx, produced);
+        return;
+    }
+
+    OutputCache::Entry *entry = nullptr;
+    switch (cache.acquire(func.id, inputs, hash_inputs(func.id, inputs), task, outputs, entry)) {
+        case CacheLookup::Hit:
+            node_outputs[task.node_idx] = std::move(outputs);
+            finish(&run, task.node_idx, true);
+            return;
+
+        case CacheLookup::Pending:
+            // completed by whoever is computing the entry
+            return;
+
+        case CacheLookup::Miss:
+            break;
+    }
+
+    const auto evaluated = call_func(func, inputs, outputs);
+    if (drop_if_stopped(run, task.node_idx, scope, evaluated, outputs)) {
+        retry(cache.discard(entry));
+        node_outputs[task.node_idx] = std::move(outputs);
+        finish(&run, task.node_idx, false);
+        return;
+    }
+    for (const auto &waiter: cache.publish(entry, outputs)) {
+        waiter.run->instance->outputs[waiter.node_idx] = outputs;
+        finish(waiter.run, waiter.node_idx, true);
+    }
+    node_outputs[task.node_idx] = std::move(outputs);
+    finish(&run, task.node_idx, true);
+}
+
+void Executor::run_stage(const NodeTask &task) {
+    auto &run = *task.run;
+    const auto &plan = *run.plan;
+    const auto &func = *plan.funcs[task.node_idx];
+
+    std::vector<Value> inputs;
+    std::vector<StreamReader> readers;
+    for (auto source_idx = plan.source_offsets[task.node_idx]; source_idx < plan.source_offsets[task.node_idx + 1]; ++source_idx) {
+        const auto &source = plan.sources[source_idx];
+        if (!source.streaming) {
+            inputs.push_back(input_value(plan, *run.instance, source_idx));
+        } else if (source.binding == BindingType::None) {
+            readers.emplace_back();
+        } else {
+            readers.push_back(StreamReader{run.channels[source.stream_idx].get()});
+        }
+    }
+
+    const auto stream_outs_begin = plan.stream_out_offsets[task.node_idx];
+    const auto stream_outs_end = plan.stream_out_offsets[task.node_idx + 1];
+    std::vector<Value> values;
+    std::vector<StreamWriter> writers;
+    uint32_t output_idx = 0;
+    for (const auto &arg: func.args) {
+        if (arg.type != FuncArgType::Out) {
+            continue;
+        }
+        if (!arg.streaming) {
+            values.emplace_back();
+        } else {
+            auto &writer = writers.emplace_back();
+            for (auto i = stream_outs_begin; i < stream_outs_end; ++i) {
+                if (plan.streams[plan.stream_outs[i]].output_idx == output_idx) {
+                    writer.channels.push_back(run.channels[plan.stream_outs[i]].get());
+                }
+            }
+        }
+        ++output_idx;
+    }
+
+    // a skipped stage still closes its channels, so the stages around it finish
+    if (!skip_node(run, task.node_idx)) {
+        const auto scope = node_scope(run, task.node_idx);
+        {
+            CancelScopeGuard scope_guard(scope);
+            func.stream_lambda(inputs, readers, values, writers);
+        }
+        drop_if_stopped(run, task.node_idx, scope, true, values);
+    }
+
+    for (const auto &reader: readers) {
+        if (reader.channel != nullptr) {
+            reader.channel->abandon();
+        }
+    }
+    for (auto i = stream_outs_begin; i < stream_outs_end; ++i) {
+        run.channels[plan.stream_outs[i]]->close();
+    }
+
+    // streaming outputs stay empty, single values go to their position among all Out args
+    NodeOutputs outputs(func.output_count());
+    auto value = values.begin();
+    output_idx = 0;
+    for (const auto &arg: func.args) {
+        if (arg.type != FuncArgType::Out) {
+            continue;
+        }
+        if (!arg.streaming) {
+            outputs[output_idx] = std::move(*value++);
+        }
+        ++output_idx;
+    }
+    run.instance->outputs[task.node_idx] = std::move(outputs);
+    finish(&run, task.node_idx, false);
+}
+
+void Executor::retry(std::span<const NodeTask> tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+    {
+        std::lock_guard lock(mutex);
+        for (const auto &task: tasks) {
+            tenants[task.run->tenant].ready.push_back(task);
+        }
+    }
+    work_cv.notify_all();
+}
+
+bool Executor::call_func(const Func &func, std::span<const Value> inputs, std::span<Value> outputs) {
+    if (func.subgraph != nullptr) {
+        return run_subgraph(*func.subgraph, inputs, outputs);
+    }
+    if (func.elementwise.has_value() && func.elementwise->lambda) {
+        return run_elementwise(func, inputs, outputs);
+    }
+    if (func.fallible_lambda) {
+        return func.fallible_lambda(inputs, outputs);
+    }
+    func.lambda(inputs, outputs);
+    return true;
+}
+
+bool Executor::run_subgraph(const Subgraph &subgraph, std::span<const Value> inputs, std::span<Value> outputs) {
+    assert(subgraph.plan != nullptr);
+    const auto &plan = *subgraph.plan;
+
+    GraphInstance instance{subgraph.plan};
+    for (size_t i = 0; i < subgraph.input_sources.size() && i < inputs.size(); ++i) {
+        for (const auto source_idx: subgraph.input_sources[i]) {
+            instance.overrides.emplace_back(source_idx, inputs[i]);
+        }
+    }
+    std::ranges::sort(instance.overrides, {}, &std::pair<uint32_t, Value>::first);
+    instance.outputs.assign(plan.node_count, {});
+
+    // already on a worker, so the inner nodes run right here in topological order
+    std::vector<Value> node_inputs;
+    for (const auto node_idx: plan.order) {
+        if (stop_requested()) {
+            return true;
+        }
+        const auto &func = *plan.funcs[node_idx];
+        node_inputs.clear();
+        const auto sources_end = plan.source_offsets[node_idx + 1];
+        for (auto source_idx = plan.source_offsets[node_idx]; source_idx < sources_end; ++source_idx) {
+            node_inputs.push_back(input_value(plan, instance, source_idx));
+        }
+        instance.outputs[node_idx].resize(func.output_count());
+        if (!call_func(func, node_inputs, instance.outputs[node_idx])) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < subgraph.output_slots.size() && i < outputs.size(); ++i) {
+        const auto &[node_idx, output_idx] = subgraph.output_slots[i];
+        const auto &produced = instance.outputs[node_idx];
+        if (output_idx < produced.size()) {
+            outputs[i] = produced[output_idx];
+        }
+    }
+    return true;
+}
+
+bool Executor::run_elementwise(const Func &func, std::span<const Value> inputs, std::span<Value> outputs) {
+    const auto &elementwise = *func.elementwise;
+    assert(elementwise.output_elements.size() == outputs.size());
+    if (elementwise.input_elements.size() != inputs.size()) {
+        return false;
+    }
+
+    // every input of its declared element datatype, tensors of one shape
+    const Tensor *shape_source = nullptr;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (inputs[i].datatype != DatatypeTensor) {
+            if (inputs[i].datatype != elementwise.input_elements[i]) {
+                return false;
+            }
+            continue;
+        }
+        const auto &tensor = *static_cast<const Tensor *>(inputs[i].data());
+        if (tensor.element != elementwise.input_elements[i]) {
+            return false;
+        }
+        if (shape_source == nullptr) {
+            shape_source = &tensor;
+        } else if (tensor.shape != shape_source->shape) {
+            return false;
+        }
+    }
+    if (shape_source == nullptr) {
+        return false;
+    }
+    const auto count = shape_source->element_count();
+
+    // base pointer and stride per argument, broadcast inputs have a stride of 0
+    std::vector<const std::byte *> input_bases;
+    std::vector<size_t> input_strides;
+    size_t largest_element = 1;
+    for (const auto &input: inputs) {
+        if (input.datatype == DatatypeTensor) {
+            const auto &tensor = *static_cast<const Tensor *>(input.data());
+            input_bases.push_back(tensor.data());
+            input_strides.push_back(get_datatype(tensor.element).size);
+        } else {
+            input_bases.push_back(static_cast<const std::byte *>(input.data()));
+            input_strides.push_back(0);
+        }
+        largest_element = std::max(largest_element, input_strides.back());
+    }
+
+    std::vector<Tensor> results;
+    std::vector<size_t> output_strides;
+    for (const auto element: elementwise.output_elements) {
+        const auto &type = get_datatype(element);
+        results.push_back(type.trivial
+                          ? Tensor::uninitialized(element, shape_source->shape)
+                          : Tensor(element, shape_source->shape));
+        output_strides.push_back(type.size);
+        largest_element = std::max<size_t>(largest_element, type.size);
+    }
+
+    const auto chunk_elements = std::max<size_t>(1, chunk_bytes / largest_element);
+    const auto chunk_count = (count + chunk_elements - 1) / chunk_elements;
+
+    // chunks may run on helper threads, they check the scope of the node themselves
+    const auto *scope = current_cancel_scope();
+    std::function<void(size_t)> process = [&](size_t chunk) {
+        if (scope != nullptr && scope->stop_requested()) {
+            return;
+        }
+        const auto begin = chunk * chunk_elements;
+        const auto size = std::min(chunk_elements, count - begin);
+
+        std::vector<const void *> chunk_inputs(input_bases.size());
+        for (size_t i = 0; i < input_bases.size(); ++i) {
+            chunk_inputs[i] = input_bases[i] + begin * input_strides[i];
+        }
+        std::vector<void *> chunk_outputs(results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            chunk_outputs[i] = results[i].mutable_data() + begin * output_strides[i];
+        }
+        elementwise.lambda(chunk_inputs, chunk_outputs, size);
+    };
+
+    if (chunk_count <= 1) {
+        if (count > 0) {
+            process(0);
+        }
+    } else {
+        parallel_chunks(chunk_count, process);
+    }
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        outputs[i] = make_value(DatatypeTensor, std::move(results[i]));
+    }
+    return true;
+}
+
+void Executor::parallel_chunks(size_t chunk_count, const std::function<void(size_t)> &process) {
+    ChunkJob job{};
+    job.process = &process;
+    job.chunk_count = chunk_count;
+    {
+        std::lock_guard lock(mutex);
+        jobs.push_back(&job);
+    }
+    work_cv.notify_all();
+
+    const auto processed = drain(job);
+
+    std::unique_lock lock(mutex);
+    std::erase(jobs, &job);
+    job.finished += processed;
+    job.done_cv.wait(lock, [&job] { return job.finished == job.chunk_count && job.helpers == 0; });
+}
+
+size_t Executor::drain(ChunkJob &job) {
+    size_t processed = 0;
+    for (auto chunk = job.next.fetch_add(1); chunk < job.chunk_count; chunk = job.next.fetch_add(1)) {
+        (*job.process)(chunk);
+        ++processed;
+    }
+    return processed;
+}
+
+void Executor::finish(RunState *run, uint32_t node_idx, bool produced) {
+    if (produced && run->instance->checkpoint != nullptr) {
+        run->instance->checkpoint->complete(node_idx, run->instance->outputs[node_idx]);
+    }
+
+    std::lock_guard lock(mutex);
+
+    const auto &plan = *run->plan;
+    auto &tenant = tenants[run->tenant];
+    bool pushed = false;
+    for (auto i = plan.consumer_offsets[node_idx]; i < plan.consumer_offsets[node_idx + 1]; ++i) {
+        const auto consumer = plan.consumers[i];
+        if (--run->pending[consumer] == 0) {
+            tenant.ready.push_back(NodeTask{run, consumer});
+            pushed = true;
+        }
+    }
+    if (pushed) {
+        work_cv.notify_all();
+    }
+
+    if (--run->remaining == 0) {
+        run->done_cv.notify_all();
+    }
+}
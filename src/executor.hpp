@@ -0,0 +1,187 @@
+#pragma once
+
+#include "cancel.hpp"
+#include "func.hpp"
+#include "graph.hpp"
+#include "plan.hpp"
+#include "stream.hpp"
+#include "value.hpp"
+
+#include "utils/nocopy.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+using TenantId = uint32_t;
+
+struct TenantQuota {
+    uint32_t max_in_flight = 1; // nodes of the tenant executing at the same time
+    uint32_t weight = 1;        // consecutive dispatches the tenant gets per scheduling round
+};
+
+struct ExecutorConfig {
+    uint32_t thread_count = 0;    // 0 picks std::thread::hardware_concurrency()
+    size_t cache_capacity = 4096; // entries in the shared Pure output cache
+    size_t chunk_bytes = 64 * 1024; // per chunk of an element-wise func, sized to stay in L2
+    size_t stream_capacity = 16;    // chunks buffered per stream edge before the producer blocks
+};
+
+
+struct RunState;
+
+struct NodeTask {
+    RunState *run = nullptr;
+    uint32_t node_idx = 0;
+};
+
+enum class CacheLookup : uint8_t {
+    Hit, Pending, Miss
+};
+
+// Outputs of Pure funcs keyed by func id and input values, shared by all tenants of an executor.
+// A Miss makes the caller the producer of the entry; nodes that look up the same key meanwhile
+// are parked on the entry and completed by publish().
+struct OutputCache {
+    NOCOPY(OutputCache)
+
+    struct Entry {
+        FuncId func_id{};
+        std::vector<Value> inputs;
+        uint64_t hash = 0;
+        bool ready = false;
+        NodeOutputs outputs;
+        std::vector<NodeTask> waiters;
+    };
+
+    std::mutex mutex;
+    size_t capacity;
+    std::list<Entry> entries; // most recently used first
+    std::unordered_multimap<uint64_t, std::list<Entry>::iterator> index;
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    explicit OutputCache(size_t capacity);
+
+    CacheLookup acquire(
+            const FuncId &func_id,
+            std::span<const Value> inputs,
+            uint64_t hash,
+            const NodeTask &task,
+            NodeOutputs &outputs,
+            Entry *&entry
+    );
+
+    // Stores the outputs of an entry returned by a Miss and hands back the parked waiters.
+    std::vector<NodeTask> publish(Entry *entry, const NodeOutputs &outputs);
+
+    // Drops an entry returned by a Miss whose outputs were not produced, the parked waiters are
+    // handed back to look the key up again.
+    std::vector<NodeTask> discard(Entry *entry);
+
+    void clear();
+};
+
+uint64_t hash_inputs(const FuncId &func_id, std::span<const Value> inputs);
+
+
+// Chunks of one element-wise node, claimed by the worker running the node and by idle workers.
+struct ChunkJob {
+    const std::function<void(size_t)> *process = nullptr;
+    size_t chunk_count = 0;
+    std::atomic<size_t> next{0};
+    size_t finished = 0;  // guarded by Executor::mutex, like helpers
+    uint32_t helpers = 0;
+    std::condition_variable done_cv;
+};
+
+
+// One set of worker threads and one output cache for any number of graphs. Graphs are grouped
+// into tenants; ready nodes are dispatched round-robin across tenants, weighted by
+// TenantQuota::weight and capped by TenantQuota::max_in_flight. Nodes of streaming funcs block
+// on their channels for as long as the stream lasts, so they do not run on the workers: every run
+// starts one thread per stage, outside of thread_count and of the quota of its tenant. Stages of
+// a pipeline have to run at the same time for it to make progress at all, which a quota below the
+// length of the pipeline would prevent; callers that run many streaming graphs at once bound the
+// threads by the number of runs they start.
+struct Executor {
+    NOCOPY(Executor)
+
+    struct Tenant {
+        TenantQuota quota;
+        std::deque<NodeTask> ready;
+        uint32_t in_flight = 0;
+    };
+
+    OutputCache cache;
+    size_t chunk_bytes;
+    size_t stream_capacity;
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::vector<Tenant> tenants;
+    size_t cursor = 0;
+    uint32_t credit = 0;
+    std::vector<ChunkJob *> jobs;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    explicit Executor(const ExecutorConfig &config = {});
+
+    ~Executor();
+
+    TenantId add_tenant(const TenantQuota &quota = {});
+
+    void set_quota(TenantId tenant, const TenantQuota &quota);
+
+    // Evaluates the plan of the instance and leaves the results in instance.outputs. Blocks the
+    // caller; instances of any tenant may run concurrently, as long as each runs once at a time.
+    // Once token is cancelled the nodes not started yet are skipped and the run returns early.
+    RunResult run(TenantId tenant, GraphInstance &instance, const CancelToken *token = nullptr);
+
+    // Compiles the graph into a throwaway plan and runs it, outputs are indexed like graph.nodes.
+    RunResult run(
+            TenantId tenant,
+            const Graph &graph,
+            const FuncLib &lib,
+            std::vector<NodeOutputs> &outputs,
+            const CancelToken *token = nullptr
+    );
+
+    void worker_loop();
+
+    bool pop_task(NodeTask &task);
+
+    void execute(const NodeTask &task);
+
+    void run_stage(const NodeTask &task);
+
+    // puts tasks back into the ready queues of their tenants
+    void retry(std::span<const NodeTask> tasks);
+
+    // returns false if the func could not be evaluated on the inputs, outputs are left empty then
+    bool call_func(const Func &func, std::span<const Value> inputs, std::span<Value> outputs);
+
+    // evaluates a subgraph that was not inlined on the calling thread
+    bool run_subgraph(const Subgraph &subgraph, std::span<const Value> inputs, std::span<Value> outputs);
+
+    bool run_elementwise(const Func &func, std::span<const Value> inputs, std::span<Value> outputs);
+
+    // runs process for every chunk index, idle workers help and the call returns once all are done
+    void parallel_chunks(size_t chunk_count, const std::function<void(size_t)> &process);
+
+    size_t drain(ChunkJob &job);
+
+    // produced is false for nodes that were skipped or stopped, or that are not checkpointed
+    void finish(RunState *run, uint32_t node_idx, bool produced);
+};
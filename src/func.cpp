@@ -1,10 +1,12 @@
 #include "func.hpp"
 
 #include "utils/utils.hpp"
+#include "utils/uuid_text.hpp"
 
 
 #include <yaml-cpp/yaml.h>
 
+#include <algorithm>
 #include <cassert>
 
 
@@ -12,6 +14,52 @@ Func::Func() {
     id = generate_uuid();
 }
 
+Func::Func(const FuncId &id) : id(id) {}
+
+uint32_t Func::input_count() const {
+    uint32_t count = 0;
+    for (const auto &arg: args) {
+        count += arg.type == FuncArgType::In ? 1 : 0;
+    }
+    return count;
+}
+
+uint32_t Func::output_count() const {
+    return static_cast<uint32_t>(args.size()) - input_count();
+}
+
+bool Func::is_callable() const {
+    if (subgraph != nullptr) {
+        return true;
+    }
+    if (is_streaming()) {
+        return static_cast<bool>(stream_lambda);
+    }
+    return lambda || fallible_lambda || (elementwise.has_value() && elementwise->lambda);
+}
+
+bool Func::is_streaming() const {
+    return std::ranges::any_of(args, &FuncArg::streaming);
+}
+
+const FuncArg *Func::output_arg(uint32_t output_idx) const {
+    for (const auto &arg: args) {
+        if (arg.type == FuncArgType::Out && output_idx-- == 0) {
+            return &arg;
+        }
+    }
+    return nullptr;
+}
+
+const Func *FuncLib::find(const FuncId &id) const {
+    for (const auto &func: funcs) {
+        if (func.id == id) {
+            return &func;
+        }
+    }
+    return nullptr;
+}
+
 
 std::string to_string(const FuncBehavior &func_behavior) {
     switch (func_behavior) {
@@ -35,17 +83,20 @@ std::string to_string(const FuncArgType &arg_type) {
 
 YAML::Emitter &operator<<(YAML::Emitter &out, const Func &func) {
     out << YAML::BeginMap;
-    out << YAML::Key << "id" << YAML::Value << to_string(func.id);
-    out << YAML::Key << "name" << YAML::Value << func.name;
+    out << YAML::Key << "id" << YAML::Value << format_uuid(func.id);
+    out << YAML::Key << "name" << YAML::Value << func.name.str();
     out << YAML::Key << "behavior" << YAML::Value << to_string(func.behavior);
 
     out << YAML::Key << "args" << YAML::Value << YAML::BeginSeq;
     for (const auto &arg: func.args) {
         out << YAML::BeginMap;
-        out << YAML::Key << "name" << YAML::Value << arg.name;
+        out << YAML::Key << "name" << YAML::Value << arg.name.str();
         out << YAML::Key << "datatype" << YAML::Value << arg.datatype;
         out << YAML::Key << "required" << YAML::Value << arg.required;
         out << YAML::Key << "type" << YAML::Value << to_string(arg.type);
+        if (arg.streaming) {
+            out << YAML::Key << "streaming" << YAML::Value << true;
+        }
         out << YAML::EndMap;
     }
     out << YAML::EndSeq;
@@ -53,7 +104,7 @@ YAML::Emitter &operator<<(YAML::Emitter &out, const Func &func) {
     out << YAML::Key << "events" << YAML::Value << YAML::BeginSeq;
     for (const auto &event: func.events) {
         out << YAML::BeginMap;
-        out << YAML::Key << "name" << YAML::Value << event.name;
+        out << YAML::Key << "name" << YAML::Value << event.name.str();
         out << YAML::EndMap;
     }
     out << YAML::EndSeq;
@@ -1,31 +1,43 @@
 #pragma once
 
 
+#include "stream.hpp"
+#include "tensor.hpp"
+#include "value.hpp"
+
 #include "utils/nocopy.hpp"
+#include "utils/symbol.hpp"
 
 #include <uuid.h>
 #include <yaml-cpp/yaml.h>
 
 #include <string>
 #include <vector>
+#include <span>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <cstdint>
 
 
 using FuncId = uuids::uuid;
 
+struct Subgraph;
+
 enum class FuncArgType : uint8_t {
     In, Out
 };
 
 struct FuncArg {
-    std::string name;
+    Symbol name;
     uint32_t datatype = 1;
     bool required = true;
     FuncArgType type = FuncArgType::In;
+    bool streaming = false; // a sequence of chunks of datatype instead of a single value
 };
 
 struct FuncEvent {
-    std::string name;
+    Symbol name;
 };
 
 enum class FuncBehavior : uint8_t {
@@ -33,16 +45,45 @@ enum class FuncBehavior : uint8_t {
     Impure // may return different outputs for the same input
 };
 
+// inputs follow the In args and outputs follow the Out args, both in declaration order
+using FuncLambda = std::function<void(std::span<const Value> inputs, std::span<Value> outputs)>;
+
+// like FuncLambda, returns false if the outputs could not be produced; the executor drops them and
+// fails the run with RunResult::InvalidInput
+using FallibleFuncLambda = std::function<bool(std::span<const Value> inputs, std::span<Value> outputs)>;
+
 struct Func {
     FuncId id;
-    std::string name;
+    Symbol name;
     FuncBehavior behavior = FuncBehavior::Impure;
     std::vector<FuncArg> args;
     std::vector<FuncEvent> events;
 
+    FuncLambda lambda;
+    FallibleFuncLambda fallible_lambda;         // replaces lambda for funcs that can fail
+    std::optional<ElementwiseFunc> elementwise; // replaces lambda for Pure funcs over tensors
+    StreamLambda stream_lambda;                 // replaces lambda for funcs with streaming args
+    std::shared_ptr<Subgraph> subgraph;         // replaces lambda, see subgraph.hpp
+
     Func();
 
+    // for loaders that read the id along with the func
+    explicit Func(const FuncId &id);
+
+    [[nodiscard]] uint32_t input_count() const;
+    [[nodiscard]] uint32_t output_count() const;
+
+    [[nodiscard]] bool is_callable() const;
+
+    [[nodiscard]] bool is_streaming() const;
+
+    [[nodiscard]] const FuncArg *output_arg(uint32_t output_idx) const;
+};
+
+struct FuncLib {
+    std::vector<Func> funcs;
 
+    [[nodiscard]] const Func *find(const FuncId &id) const;
 };
 
 YAML::Emitter &operator<<(YAML::Emitter &out, const Func &func);
@@ -1,23 +1,21 @@
 #include "graph.hpp"
 
+#include "utils/thread_pool.hpp"
 #include "utils/utils.hpp"
+#include "utils/uuid_text.hpp"
 
 
+#include <algorithm>
 #include <cassert>
+#include <unordered_map>
 
 
-Node::Node(Func &func) {
+Node::Node(const Func &func) {
     id = generate_uuid();
     func_id = func.id;
     name = func.name;
-    for (const auto &arg: func.args) {
-        auto &input = inputs.emplace_back();
-        input.binding = BindingType::None;
-    }
-    for (const auto &event: func.events) {
-        auto &node_event = events.emplace_back();
-    }
-
+    inputs.resize(func.args.size());
+    events.resize(func.events.size());
 }
 
 std::string to_string(const BindingType &binding_type) {
@@ -33,13 +31,127 @@ std::string to_string(const BindingType &binding_type) {
 }
 
 
+// Iterative DFS over Binding inputs starting at the outputs, then at whatever is left, producers
+// are emitted before their consumers. reached is the number of nodes some output depends on.
+static std::vector<uint32_t> post_order(const Graph &graph, uint32_t &reached) {
+    const auto node_count = static_cast<uint32_t>(graph.nodes.size());
+    std::unordered_map<NodeId, uint32_t, UuidHash> node_indices;
+    node_indices.reserve(node_count);
+    for (uint32_t i = 0; i < node_count; ++i) {
+        node_indices.emplace(graph.nodes[i].id, i);
+    }
+
+    std::vector<uint32_t> order;
+    order.reserve(node_count);
+    std::vector<uint8_t> visited(node_count, 0);
+    std::vector<std::pair<uint32_t, uint32_t>> stack; // node, next input to look at
+
+    auto walk = [&](uint32_t start) {
+        if (visited[start]) {
+            return;
+        }
+        visited[start] = 1;
+        stack.emplace_back(start, 0);
+        while (!stack.empty()) {
+            auto &[node_idx, input_idx] = stack.back();
+            const auto &inputs = graph.nodes[node_idx].inputs;
+            if (input_idx == inputs.size()) {
+                order.push_back(node_idx);
+                stack.pop_back();
+                continue;
+            }
+
+            const auto &input = inputs[input_idx++];
+            if (input.binding != BindingType::Binding) {
+                continue;
+            }
+            auto it = node_indices.find(input.output_node_id);
+            if (it != node_indices.end() && !visited[it->second]) {
+                visited[it->second] = 1;
+                stack.emplace_back(it->second, 0);
+            }
+        }
+    };
+
+    for (uint32_t i = 0; i < node_count; ++i) {
+        if (graph.nodes[i].is_output) {
+            walk(i);
+        }
+    }
+    reached = static_cast<uint32_t>(order.size());
+    for (uint32_t i = 0; i < node_count; ++i) {
+        walk(i);
+    }
+    return order;
+}
+
+std::vector<uint32_t> reorder_nodes(Graph &graph, NodeOrder order) {
+    const auto node_count = static_cast<uint32_t>(graph.nodes.size());
+    uint32_t reached = 0;
+    auto permutation = post_order(graph, reached);
+
+    if (order == NodeOrder::Depth) {
+        std::vector<uint32_t> position(node_count);
+        for (uint32_t i = 0; i < node_count; ++i) {
+            position[permutation[i]] = i;
+        }
+        std::unordered_map<NodeId, uint32_t, UuidHash> node_indices;
+        node_indices.reserve(node_count);
+        for (uint32_t i = 0; i < node_count; ++i) {
+            node_indices.emplace(graph.nodes[i].id, i);
+        }
+
+        // post order visits producers first, except along cycles, which only ever lower a depth
+        std::vector<uint32_t> depth(node_count, 0);
+        for (const auto node_idx: permutation) {
+            for (const auto &input: graph.nodes[node_idx].inputs) {
+                if (input.binding != BindingType::Binding) {
+                    continue;
+                }
+                auto it = node_indices.find(input.output_node_id);
+                if (it != node_indices.end() && position[it->second] < position[node_idx]) {
+                    depth[node_idx] = std::max(depth[node_idx], depth[it->second] + 1);
+                }
+            }
+        }
+        auto by_depth = [&depth](uint32_t lhs, uint32_t rhs) { return depth[lhs] < depth[rhs]; };
+        std::stable_sort(permutation.begin(), permutation.begin() + reached, by_depth);
+        std::stable_sort(permutation.begin() + reached, permutation.end(), by_depth);
+    }
+
+    std::vector<Node> nodes;
+    nodes.reserve(node_count);
+    for (const auto node_idx: permutation) {
+        nodes.push_back(std::move(graph.nodes[node_idx]));
+    }
+    graph.nodes = std::move(nodes);
+
+    // all copies are allocated in node order before any of the old storage is freed
+    std::vector<std::pair<Value *, Value>> copies;
+    for (auto &node: graph.nodes) {
+        for (auto &input: node.inputs) {
+            if (input.value.has_value() && !input.value->empty()
+                && !Value::is_inline(get_datatype(input.value->datatype))) {
+                copies.emplace_back(&input.value.value(), *input.value);
+            }
+        }
+    }
+    for (auto &[value, copy]: copies) {
+        *value = std::move(copy);
+    }
+
+    return permutation;
+}
+
+
 YAML::Emitter &operator<<(YAML::Emitter &out, const Node &node) {
     out << YAML::BeginMap;
-    out << YAML::Key << "id" << YAML::Value << to_string(node.id);
-    out << YAML::Key << "func_id" << YAML::Value << to_string(node.func_id);
-    out << YAML::Key << "name" << YAML::Value << node.name;
+    out << YAML::Key << "id" << YAML::Value << format_uuid(node.id);
+    out << YAML::Key << "func_id" << YAML::Value << format_uuid(node.func_id);
+    out << YAML::Key << "name" << YAML::Value << node.name.str();
     out << YAML::Key << "is_output" << YAML::Value << node.is_output;
     out << YAML::Key << "cache_outputs" << YAML::Value << node.cache_outputs;
+    out << YAML::Key << "timeout_ms" << YAML::Value << node.timeout_ms;
 
     out << YAML::Key << "inputs" << YAML::Value << YAML::BeginSeq;
     for (const auto &input: node.inputs) {
@@ -51,11 +163,12 @@ YAML::Emitter &operator<<(YAML::Emitter &out, const Node &node) {
 
             case BindingType::Const:
                 assert(input.value.has_value());
-                assert(false);
+                out << YAML::Key << "value" << YAML::Value;
+                emit_value(out, input.value.value());
                 break;
 
             case BindingType::Binding:
-                out << YAML::Key << "output_node_id" << YAML::Value << to_string(input.output_node_id);
+                out << YAML::Key << "output_node_id" << YAML::Value << format_uuid(input.output_node_id);
                 out << YAML::Key << "output_idx" << YAML::Value << input.output_idx;
                 break;
         }
@@ -69,7 +182,7 @@ YAML::Emitter &operator<<(YAML::Emitter &out, const Node &node) {
         out << YAML::BeginMap;
         out << YAML::Key << "subscribers" << YAML::Value << YAML::BeginSeq;
         for (const auto &subscriber: event.subscribers) {
-            out << to_string(subscriber);
+            out << format_uuid(subscriber);
         }
         out << YAML::EndSeq;
         out << YAML::EndMap;
@@ -88,3 +201,43 @@ YAML::Emitter &operator<<(YAML::Emitter &out, const Graph &func) {
     out << YAML::EndSeq;
     return out;
 }
+
+std::string emit_graph_parallel(const Graph &graph, ThreadPool &pool) {
+    // an empty graph is a flow sequence, a single chunk is the serial case anyway
+    const size_t chunk_size = std::max<size_t>(256, graph.nodes.size() / (4 * (pool.thread_count() + 1)));
+    if (graph.nodes.size() <= chunk_size) {
+        YAML::Emitter out;
+        out << graph;
+        return out.c_str();
+    }
+
+    const auto chunk_count = (graph.nodes.size() + chunk_size - 1) / chunk_size;
+    std::vector<std::string> chunks(chunk_count);
+    pool.parallel_for(0, chunk_count, 1, [&](size_t begin, size_t end) {
+        for (auto chunk = begin; chunk < end; ++chunk) {
+            const auto first = chunk * chunk_size;
+            const auto last = std::min(graph.nodes.size(), first + chunk_size);
+            YAML::Emitter out;
+            out << YAML::BeginSeq;
+            for (auto i = first; i < last; ++i) {
+                out << graph.nodes[i];
+            }
+            out << YAML::EndSeq;
+            chunks[chunk] = out.c_str();
+        }
+    });
+
+    size_t size = chunk_count - 1;
+    for (const auto &chunk: chunks) {
+        size += chunk.size();
+    }
+    std::string result;
+    result.reserve(size);
+    for (const auto &chunk: chunks) {
+        if (!result.empty()) {
+            result += '\n';
+        }
+        result += chunk;
+    }
+    return result;
+}
@@ -8,6 +8,7 @@
 #include <yaml-cpp/yaml.h>
 
 #include <vector>
+#include <optional>
 #include <cstdint>
 
 using NodeId = uuids::uuid;
@@ -19,9 +20,9 @@ enum class BindingType : uint8_t {
 struct NodeInput {
 
     BindingType binding = BindingType::None;
-    std::optional<void *> value = std::nullopt;
+    std::optional<Value> value = std::nullopt;
     uuids::uuid output_node_id{};
-    uint32_t output_idx = 0;
+    uint32_t output_idx = 0; // index among the Out args of the producing func
 
     NodeInput() = default;
 
@@ -37,24 +38,51 @@ struct NodeEvent {
 struct Node {
     NodeId id{};
     FuncId func_id{};
-    std::string name;
+    Symbol name;
 
     bool is_output = false;
     bool cache_outputs = false;
+    uint32_t timeout_ms = 0; // cooperative, see stop_requested(); 0 for none
 
     std::vector<NodeInput> inputs;
     std::vector<NodeEvent> events;
 
-    explicit Node(Func &func);
+    Node() = default; // for loaders, which fill in every field themselves
+
+    explicit Node(const Func &func);
 };
 
 struct Graph {
     NOCOPY(Graph)
 
     std::vector<Node> nodes;
+
+    Graph() = default;
+
+    Graph(Graph &&) = default;
+
+    Graph &operator=(Graph &&) = default;
+};
+
+
+enum class NodeOrder : uint8_t {
+    PostOrder, // depth-first from the outputs, every node right after the producers it needs
+    Depth,     // by longest path from a node without producers, then by PostOrder
 };
 
+// Permutes graph.nodes so that producers sit next to their consumers, and copies heap-stored
+// Const values in the new order so their storage follows it too. Nodes no output depends on go
+// after all others. Returns the previous index of the node at each new position.
+std::vector<uint32_t> reorder_nodes(Graph &graph, NodeOrder order);
+
 
 YAML::Emitter &operator<<(YAML::Emitter &out, const Graph &func);
 
+struct ThreadPool;
+
+// Same bytes as emitting graph on its own into a fresh YAML::Emitter. Chunks of nodes are
+// emitted as sequences of their own on pool and joined, which works because the items of a
+// top-level block sequence do not depend on each other.
+std::string emit_graph_parallel(const Graph &graph, ThreadPool &pool);
+
 YAML::Emitter &operator<<(YAML::Emitter &out, const Node &node);
\ No newline at end of file
@@ -0,0 +1,410 @@
+#include "graph_file.hpp"
+
+#include "encoding.hpp"
+#include "loader.hpp"
+#include "yaml_writer.hpp"
+
+#include "utils/file_sync.hpp"
+
+#include <yaml-cpp/yaml.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+
+static_assert(sizeof(FileNode) == 64);
+static_assert(sizeof(FileInput) == 40);
+static_assert(sizeof(FileFunc) == 44);
+static_assert(sizeof(FileArg) == 16);
+
+
+static FileUuid to_file_uuid(const uuids::uuid &id) {
+    FileUuid result{};
+    const auto bytes = id.as_bytes();
+    std::memcpy(result.bytes, bytes.data(), sizeof(result.bytes));
+    return result;
+}
+
+uuids::uuid to_uuid(const FileUuid &id) {
+    std::array<uuids::uuid::value_type, 16> bytes{};
+    std::memcpy(bytes.data(), id.bytes, bytes.size());
+    return uuids::uuid(bytes);
+}
+
+// align_up() for offsets past 4 GiB
+static uint64_t align_offset(uint64_t offset) {
+    return (offset + EncodingAlignment - 1) & ~uint64_t{EncodingAlignment - 1};
+}
+
+template<typename T>
+static std::span<const T> sub_range(std::span<const T> records, FileRange range) {
+    if (range.first > records.size() || range.count > records.size() - range.first) {
+        return {};
+    }
+    return records.subspan(range.first, range.count);
+}
+
+
+std::string_view GraphFile::string(FileString string) const {
+    if (string.offset > strings.size() || string.size > strings.size() - string.offset) {
+        return {};
+    }
+    return {strings.data() + string.offset, string.size};
+}
+
+std::span<const FileInput> GraphFile::node_inputs(const FileNode &node) const {
+    return sub_range(inputs, node.inputs);
+}
+
+std::span<const FileNodeEvent> GraphFile::events_of(const FileNode &node) const {
+    return sub_range(node_events, node.events);
+}
+
+std::span<const FileUuid> GraphFile::subscribers_of(const FileNodeEvent &event) const {
+    return sub_range(subscribers, event.subscribers);
+}
+
+std::span<const FileArg> GraphFile::args_of(const FileFunc &func) const {
+    return sub_range(args, func.args);
+}
+
+std::span<const FileFuncEvent> GraphFile::events_of(const FileFunc &func) const {
+    return sub_range(func_events, func.events);
+}
+
+bool GraphFile::value(const FileInput &input, Value &value, bool borrow) const {
+    if (input.value_offset > values.size() || input.value_size > values.size() - input.value_offset) {
+        return false;
+    }
+    std::vector<Value> decoded;
+    if (!decode_values(values.subspan(input.value_offset, input.value_size), decoded, borrow) || decoded.size() != 1) {
+        return false;
+    }
+    value = std::move(decoded[0]);
+    return true;
+}
+
+bool GraphFile::to_graph(Graph &graph) const {
+    graph.nodes.reserve(graph.nodes.size() + nodes.size());
+    for (const auto &record: nodes) {
+        auto &node = graph.nodes.emplace_back();
+        node.id = to_uuid(record.id);
+        node.func_id = to_uuid(record.func_id);
+        node.name = string(record.name);
+        node.is_output = (record.flags & FileNodeIsOutput) != 0;
+        node.cache_outputs = (record.flags & FileNodeCacheOutputs) != 0;
+        node.timeout_ms = record.timeout_ms;
+
+        const auto input_records = node_inputs(record);
+        if (input_records.size() != record.inputs.count) {
+            return false;
+        }
+        node.inputs.resize(input_records.size());
+        for (size_t i = 0; i < input_records.size(); ++i) {
+            const auto &input_record = input_records[i];
+            auto &input = node.inputs[i];
+            input.binding = static_cast<BindingType>(input_record.binding);
+            switch (input.binding) {
+                case BindingType::None:
+                    break;
+                case BindingType::Const:
+                    if (!value(input_record, input.value.emplace(), false)) {
+                        return false;
+                    }
+                    break;
+                case BindingType::Binding:
+                    input.output_node_id = to_uuid(input_record.output_node_id);
+                    input.output_idx = input_record.output_idx;
+                    break;
+                default:
+                    return false;
+            }
+        }
+
+        for (const auto &event_record: events_of(record)) {
+            auto &event = node.events.emplace_back();
+            for (const auto &subscriber: subscribers_of(event_record)) {
+                event.subscribers.push_back(to_uuid(subscriber));
+            }
+        }
+    }
+    return true;
+}
+
+bool GraphFile::to_funcs(std::vector<Func> &result) const {
+    for (const auto &record: funcs) {
+        const auto arg_records = args_of(record);
+        const auto event_records = events_of(record);
+        if (record.behavior > static_cast<uint32_t>(FuncBehavior::Impure) || arg_records.size() != record.args.count
+            || event_records.size() != record.events.count) {
+            return false;
+        }
+
+        auto &func = result.emplace_back(to_uuid(record.id));
+        func.name = string(record.name);
+        func.behavior = static_cast<FuncBehavior>(record.behavior);
+        for (const auto &arg_record: arg_records) {
+            if (arg_record.type > static_cast<uint8_t>(FuncArgType::Out)) {
+                return false;
+            }
+            auto &arg = func.args.emplace_back();
+            arg.name = string(arg_record.name);
+            arg.datatype = arg_record.datatype;
+            arg.required = arg_record.required != 0;
+            arg.type = static_cast<FuncArgType>(arg_record.type);
+            arg.streaming = arg_record.streaming != 0;
+        }
+        for (const auto &event_record: event_records) {
+            func.events.push_back(FuncEvent{string(event_record.name)});
+        }
+    }
+    return true;
+}
+
+
+template<typename T>
+static bool section_records(
+        std::span<const std::byte> bytes,
+        const GraphFileHeader &header,
+        GraphFileSection section,
+        std::span<const T> &records
+) {
+    const auto &[offset, size] = header.sections[static_cast<size_t>(section)];
+    if (offset > bytes.size() || size > bytes.size() - offset || offset % EncodingAlignment != 0
+        || size % sizeof(T) != 0) {
+        return false;
+    }
+    records = {reinterpret_cast<const T *>(bytes.data() + offset), static_cast<size_t>(size / sizeof(T))};
+    return true;
+}
+
+bool view_graph_file(GraphFile *file, std::span<const std::byte> bytes) {
+    if (bytes.size() < sizeof(GraphFileHeader)
+        || reinterpret_cast<uintptr_t>(bytes.data()) % EncodingAlignment != 0) {
+        return false;
+    }
+    GraphFileHeader header{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != GraphFileMagic || header.version != GraphFileVersion) {
+        return false;
+    }
+
+    return section_records(bytes, header, GraphFileSection::Nodes, file->nodes)
+           && section_records(bytes, header, GraphFileSection::Inputs, file->inputs)
+           && section_records(bytes, header, GraphFileSection::NodeEvents, file->node_events)
+           && section_records(bytes, header, GraphFileSection::Subscribers, file->subscribers)
+           && section_records(bytes, header, GraphFileSection::Funcs, file->funcs)
+           && section_records(bytes, header, GraphFileSection::Args, file->args)
+           && section_records(bytes, header, GraphFileSection::FuncEvents, file->func_events)
+           && section_records(bytes, header, GraphFileSection::Strings, file->strings)
+           && section_records(bytes, header, GraphFileSection::Values, file->values);
+}
+
+bool open_graph_file(GraphFile *file, const std::string &path) {
+    MappedFile mapped{};
+    if (!map_file(&mapped, path)) {
+        return false;
+    }
+    *file = GraphFile{};
+    if (!view_graph_file(file, {mapped.data, mapped.size})) {
+        return false;
+    }
+    file->mapped = std::move(mapped);
+    return true;
+}
+
+
+// Collects the sections in memory, strings are interned as they come.
+struct GraphFileWriter {
+    std::vector<FileNode> nodes;
+    std::vector<FileInput> inputs;
+    std::vector<FileNodeEvent> node_events;
+    std::vector<FileUuid> subscribers;
+    std::vector<FileFunc> funcs;
+    std::vector<FileArg> args;
+    std::vector<FileFuncEvent> func_events;
+    std::vector<char> strings;
+    std::vector<std::byte> values;
+    std::unordered_map<std::string_view, FileString> interned; // views into the source graph
+
+    FileString intern(std::string_view string) {
+        auto [it, inserted] = interned.try_emplace(string);
+        if (inserted) {
+            it->second.offset = static_cast<uint32_t>(strings.size());
+            it->second.size = static_cast<uint32_t>(string.size());
+            strings.insert(strings.end(), string.begin(), string.end());
+        }
+        return it->second;
+    }
+
+    void add_value(FileInput &record, const Value &value) {
+        const std::span<const Value> list(&value, 1);
+        record.value_offset = align_offset(values.size());
+        record.value_size = encoded_size(list);
+        values.resize(record.value_offset + record.value_size);
+        encode_values(list, values.data() + record.value_offset);
+    }
+};
+
+template<typename T>
+static void append_section(std::vector<std::byte> &bytes, GraphFileHeader &header, GraphFileSection section,
+                           const std::vector<T> &records) {
+    auto &[offset, size] = header.sections[static_cast<size_t>(section)];
+    offset = align_offset(bytes.size());
+    size = records.size() * sizeof(T);
+    bytes.resize(offset + size);
+    if (size != 0) {
+        std::memcpy(bytes.data() + offset, records.data(), size);
+    }
+}
+
+bool encode_graph_file(
+        const Graph &graph,
+        std::span<const Func> funcs,
+        std::vector<std::byte> &bytes,
+        GraphFileError *error
+) {
+    bytes.clear();
+    GraphFileWriter writer{};
+    writer.nodes.reserve(graph.nodes.size());
+
+    for (const auto &node: graph.nodes) {
+        auto &record = writer.nodes.emplace_back();
+        record.id = to_file_uuid(node.id);
+        record.func_id = to_file_uuid(node.func_id);
+        record.name = writer.intern(node.name);
+        record.flags = (node.is_output ? FileNodeIsOutput : 0) | (node.cache_outputs ? FileNodeCacheOutputs : 0);
+        record.timeout_ms = node.timeout_ms;
+
+        record.inputs = {static_cast<uint32_t>(writer.inputs.size()), static_cast<uint32_t>(node.inputs.size())};
+        for (uint32_t arg_idx = 0; arg_idx < node.inputs.size(); ++arg_idx) {
+            const auto &input = node.inputs[arg_idx];
+            auto &input_record = writer.inputs.emplace_back();
+            input_record.binding = static_cast<uint8_t>(input.binding);
+            if (input.binding == BindingType::Binding) {
+                input_record.output_node_id = to_file_uuid(input.output_node_id);
+                input_record.output_idx = input.output_idx;
+            } else if (input.binding == BindingType::Const) {
+                const auto &value = input.value.has_value() ? *input.value : Value{};
+                if (!is_encodable(value)) {
+                    if (error != nullptr) {
+                        *error = GraphFileError{node.id, arg_idx};
+                    }
+                    return false;
+                }
+                writer.add_value(input_record, value);
+            }
+        }
+
+        record.events = {static_cast<uint32_t>(writer.node_events.size()), static_cast<uint32_t>(node.events.size())};
+        for (const auto &event: node.events) {
+            auto &event_record = writer.node_events.emplace_back();
+            event_record.subscribers = {
+                    static_cast<uint32_t>(writer.subscribers.size()), static_cast<uint32_t>(event.subscribers.size())
+            };
+            for (const auto &subscriber: event.subscribers) {
+                writer.subscribers.push_back(to_file_uuid(subscriber));
+            }
+        }
+    }
+
+    for (const auto &func: funcs) {
+        auto &record = writer.funcs.emplace_back();
+        record.id = to_file_uuid(func.id);
+        record.name = writer.intern(func.name);
+        record.behavior = static_cast<uint32_t>(func.behavior);
+        record.args = {static_cast<uint32_t>(writer.args.size()), static_cast<uint32_t>(func.args.size())};
+        for (const auto &arg: func.args) {
+            auto &arg_record = writer.args.emplace_back();
+            arg_record.name = writer.intern(arg.name);
+            arg_record.datatype = arg.datatype;
+            arg_record.required = arg.required;
+            arg_record.type = static_cast<uint8_t>(arg.type);
+            arg_record.streaming = arg.streaming;
+        }
+        record.events = {static_cast<uint32_t>(writer.func_events.size()), static_cast<uint32_t>(func.events.size())};
+        for (const auto &event: func.events) {
+            writer.func_events.push_back(FileFuncEvent{writer.intern(event.name)});
+        }
+    }
+
+    GraphFileHeader header{};
+    bytes.resize(sizeof(header));
+    append_section(bytes, header, GraphFileSection::Nodes, writer.nodes);
+    append_section(bytes, header, GraphFileSection::Inputs, writer.inputs);
+    append_section(bytes, header, GraphFileSection::NodeEvents, writer.node_events);
+    append_section(bytes, header, GraphFileSection::Subscribers, writer.subscribers);
+    append_section(bytes, header, GraphFileSection::Funcs, writer.funcs);
+    append_section(bytes, header, GraphFileSection::Args, writer.args);
+    append_section(bytes, header, GraphFileSection::FuncEvents, writer.func_events);
+    append_section(bytes, header, GraphFileSection::Strings, writer.strings);
+    append_section(bytes, header, GraphFileSection::Values, writer.values);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    return true;
+}
+
+bool save_graph_file(
+        const Graph &graph,
+        std::span<const Func> funcs,
+        const std::string &path,
+        GraphFileError *error
+) {
+    std::vector<std::byte> bytes;
+    if (!encode_graph_file(graph, funcs, bytes, error)) {
+        return false;
+    }
+
+    // written next to the file and renamed over it, mappings of the old file stay intact. The
+    // contents reach the disk before the rename and the rename before returning, so a crash
+    // leaves either file whole.
+    const auto temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file.good()) {
+            return false;
+        }
+    }
+    if (!sync_file(temporary)) {
+        return false;
+    }
+    std::error_code rename_error;
+    std::filesystem::rename(temporary, path, rename_error);
+    return !rename_error && sync_parent_directory(path);
+}
+
+
+bool yaml_to_graph_file(std::istream &graph_yaml, const FuncLib &lib, const std::string &path) {
+    Graph graph{};
+    if (!load_graph(graph_yaml, lib, graph)) {
+        return false;
+    }
+    return save_graph_file(graph, lib.funcs, path);
+}
+
+bool graph_file_to_yaml(const GraphFile &file, std::ostream &graph_yaml, std::ostream *funcs_yaml) {
+    Graph graph{};
+    if (!file.to_graph(graph)) {
+        return false;
+    }
+    std::string text;
+    write_yaml(text, graph);
+    graph_yaml << text;
+
+    if (funcs_yaml != nullptr) {
+        std::vector<Func> funcs;
+        if (!file.to_funcs(funcs)) {
+            return false;
+        }
+        YAML::Emitter funcs_out(*funcs_yaml);
+        funcs_out << YAML::BeginSeq;
+        for (const auto &func: funcs) {
+            funcs_out << func;
+        }
+        funcs_out << YAML::EndSeq;
+    }
+    return graph_yaml.good();
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "func.hpp"
+#include "graph.hpp"
+#include "value.hpp"
+
+#include "utils/mapped_file.hpp"
+#include "utils/nocopy.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// Binary graph file, meant to be mapped and read in place. A header lists the sections, each
+// an array of fixed-size records starting 16 byte aligned. Strings live once in a string table,
+// Const values are stored with encode_values(). Everything is in host byte order.
+
+constexpr uint32_t GraphFileMagic = 0x48505247; // "GRPH"
+constexpr uint32_t GraphFileVersion = 1;
+
+struct FileUuid {
+    uint8_t bytes[16];
+};
+
+struct FileString {
+    uint32_t offset = 0; // into the string table
+    uint32_t size = 0;
+};
+
+struct FileRange {
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+constexpr uint32_t FileNodeIsOutput = 1;
+constexpr uint32_t FileNodeCacheOutputs = 2;
+
+struct FileNode {
+    FileUuid id;
+    FileUuid func_id;
+    FileString name;
+    uint32_t flags = 0;
+    uint32_t timeout_ms = 0;
+    FileRange inputs; // into the inputs section
+    FileRange events; // into the node events section
+};
+
+// one per arg of the node's func, like Node::inputs
+struct FileInput {
+    FileUuid output_node_id;
+    uint8_t binding = 0;
+    uint8_t padding[3]{};
+    uint32_t output_idx = 0;
+    uint64_t value_offset = 0; // into the values section, for Const
+    uint64_t value_size = 0;
+};
+
+struct FileNodeEvent {
+    FileRange subscribers; // into the subscribers section
+};
+
+struct FileFunc {
+    FileUuid id;
+    FileString name;
+    uint32_t behavior = 0;
+    FileRange args;
+    FileRange events;
+};
+
+struct FileArg {
+    FileString name;
+    uint32_t datatype = 0;
+    uint8_t required = 0;
+    uint8_t type = 0;
+    uint8_t streaming = 0;
+    uint8_t padding = 0;
+};
+
+struct FileFuncEvent {
+    FileString name;
+};
+
+enum class GraphFileSection : uint32_t {
+    Nodes, Inputs, NodeEvents, Subscribers, Funcs, Args, FuncEvents, Strings, Values,
+    Count,
+};
+
+struct FileSection {
+    uint64_t offset = 0;
+    uint64_t size = 0; // in bytes
+};
+
+struct GraphFileHeader {
+    uint32_t magic = GraphFileMagic;
+    uint32_t version = GraphFileVersion;
+    FileSection sections[static_cast<size_t>(GraphFileSection::Count)];
+};
+
+
+// Read-only view of a graph file. Opening only checks the header, records are read where they
+// lie. Ranges and strings that point outside their section come back empty.
+struct GraphFile {
+    NOCOPY(GraphFile)
+
+    MappedFile mapped; // empty for views of bytes owned by someone else
+    std::span<const FileNode> nodes;
+    std::span<const FileInput> inputs;
+    std::span<const FileNodeEvent> node_events;
+    std::span<const FileUuid> subscribers;
+    std::span<const FileFunc> funcs;
+    std::span<const FileArg> args;
+    std::span<const FileFuncEvent> func_events;
+    std::span<const char> strings;
+    std::span<const std::byte> values;
+
+    GraphFile() = default;
+
+    GraphFile(GraphFile &&) = default;
+
+    GraphFile &operator=(GraphFile &&) = default;
+
+    [[nodiscard]] std::string_view string(FileString string) const;
+
+    [[nodiscard]] std::span<const FileInput> node_inputs(const FileNode &node) const;
+
+    [[nodiscard]] std::span<const FileNodeEvent> events_of(const FileNode &node) const;
+
+    [[nodiscard]] std::span<const FileUuid> subscribers_of(const FileNodeEvent &event) const;
+
+    [[nodiscard]] std::span<const FileArg> args_of(const FileFunc &func) const;
+
+    [[nodiscard]] std::span<const FileFuncEvent> events_of(const FileFunc &func) const;
+
+    // With borrow set, tensors point into the file and must not outlive it.
+    bool value(const FileInput &input, Value &value, bool borrow) const;
+
+    // Copy everything out, appending to graph and funcs. Return false for records with ranges
+    // outside their section or values out of range of their enum.
+    bool to_graph(Graph &graph) const;
+
+    bool to_funcs(std::vector<Func> &funcs) const;
+};
+
+uuids::uuid to_uuid(const FileUuid &id);
+
+bool open_graph_file(GraphFile *file, const std::string &path);
+
+// bytes have to be 16 byte aligned and outlive the view
+bool view_graph_file(GraphFile *file, std::span<const std::byte> bytes);
+
+// Const input encode_graph_file() could not store, its value has no encoding (see encoding.hpp).
+struct GraphFileError {
+    NodeId node_id{};
+    uint32_t arg_idx = 0; // into the inputs of the node
+};
+
+// Returns false if a Const value has no encoding, error then names the first such input and
+// bytes are left empty.
+bool encode_graph_file(
+        const Graph &graph,
+        std::span<const Func> funcs,
+        std::vector<std::byte> &bytes,
+        GraphFileError *error = nullptr
+);
+
+bool save_graph_file(
+        const Graph &graph,
+        std::span<const Func> funcs,
+        const std::string &path,
+        GraphFileError *error = nullptr
+);
+
+
+// Converters from and to the YAML of operator<<(YAML::Emitter &, const Graph &). The funcs of
+// lib are stored along with the graph, and emitted to funcs_yaml if given.
+bool yaml_to_graph_file(std::istream &graph_yaml, const FuncLib &lib, const std::string &path);
+
+bool graph_file_to_yaml(const GraphFile &file, std::ostream &graph_yaml, std::ostream *funcs_yaml = nullptr);
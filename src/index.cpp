@@ -0,0 +1,147 @@
+#include "index.hpp"
+
+#include <algorithm>
+
+
+// Order does not matter, so erasing is a move of the last element into slot. Returns the id
+// that now sits in slot, nullptr if slot was the last one.
+static const NodeId *erase_slot(std::vector<NodeId> &ids, uint32_t slot) {
+    ids[slot] = ids.back();
+    ids.pop_back();
+    return slot < ids.size() ? &ids[slot] : nullptr;
+}
+
+
+GraphIndex::GraphIndex(const Graph &graph) : graph(&graph) {
+    nodes.reserve(graph.nodes.size());
+    for (uint32_t i = 0; i < graph.nodes.size(); ++i) {
+        auto &entry = nodes[graph.nodes[i].id];
+        entry.index_hint = i;
+        add(graph.nodes[i], entry);
+    }
+    index_fresh = true;
+}
+
+void GraphIndex::touch(const NodeId &id) {
+    touch(std::span<const NodeId>(&id, 1));
+}
+
+void GraphIndex::touch(std::span<const NodeId> ids) {
+    // hints are checked again once per batch, not per node
+    index_fresh = false;
+
+    for (const auto &id: ids) {
+        const auto *node = locate(id);
+        auto it = nodes.find(id);
+        if (it != nodes.end() && it->second.indexed) {
+            remove(id, it->second);
+        }
+        if (node != nullptr) {
+            add(*node, nodes[id]);
+        } else if (it != nodes.end()) {
+            nodes.erase(it);
+        }
+    }
+}
+
+const Node *GraphIndex::find(const NodeId &id) {
+    return locate(id);
+}
+
+std::span<const NodeId> GraphIndex::nodes_of(const FuncId &func_id) const {
+    auto it = by_func.find(func_id);
+    return it != by_func.end() ? std::span<const NodeId>(it->second) : std::span<const NodeId>();
+}
+
+std::span<const NodeId> GraphIndex::consumers_of(const NodeId &id) const {
+    auto it = consumers.find(id);
+    return it != consumers.end() ? std::span<const NodeId>(it->second) : std::span<const NodeId>();
+}
+
+std::vector<NodeId> GraphIndex::with_name_prefix(std::string_view prefix, size_t limit) const {
+    std::vector<NodeId> result;
+    for (auto it = by_name.lower_bound({prefix, NodeId{}}); it != by_name.end(); ++it) {
+        if (result.size() == limit || !it->first.starts_with(prefix)) {
+            break;
+        }
+        result.push_back(it->second);
+    }
+    return result;
+}
+
+const Node *GraphIndex::locate(const NodeId &id) {
+    auto it = nodes.find(id);
+    if (it != nodes.end()) {
+        const auto hint = it->second.index_hint;
+        if (hint < graph->nodes.size() && graph->nodes[hint].id == id) {
+            return &graph->nodes[hint];
+        }
+    }
+
+    // nodes were inserted, removed or moved since the last lookup
+    if (index_fresh) {
+        return nullptr;
+    }
+    rebuild_hints();
+    return locate(id);
+}
+
+void GraphIndex::rebuild_hints() {
+    for (uint32_t i = 0; i < graph->nodes.size(); ++i) {
+        nodes[graph->nodes[i].id].index_hint = i;
+    }
+    index_fresh = true;
+}
+
+void GraphIndex::add(const Node &node, NodeEntry &entry) {
+    entry.indexed = true;
+    entry.func_id = node.func_id;
+    entry.name = node.name;
+    entry.producers.clear();
+    for (const auto &input: node.inputs) {
+        if (input.binding == BindingType::Binding
+            && std::find(entry.producers.begin(), entry.producers.end(), input.output_node_id) == entry.producers.end()) {
+            entry.producers.push_back(input.output_node_id);
+        }
+    }
+
+    auto &of_func = by_func[entry.func_id];
+    entry.func_slot = static_cast<uint32_t>(of_func.size());
+    of_func.push_back(node.id);
+    by_name.emplace(entry.name.view(), node.id);
+    entry.consumer_slots.clear();
+    for (const auto &producer: entry.producers) {
+        auto &of_producer = consumers[producer];
+        entry.consumer_slots.push_back(static_cast<uint32_t>(of_producer.size()));
+        of_producer.push_back(node.id);
+    }
+}
+
+void GraphIndex::remove(const NodeId &id, NodeEntry &entry) {
+    if (auto it = by_func.find(entry.func_id); it != by_func.end()) {
+        if (const auto *moved = erase_slot(it->second, entry.func_slot)) {
+            nodes.at(*moved).func_slot = entry.func_slot;
+        }
+        if (it->second.empty()) {
+            by_func.erase(it);
+        }
+    }
+    by_name.erase({entry.name.view(), id});
+    for (size_t i = 0; i < entry.producers.size(); ++i) {
+        auto it = consumers.find(entry.producers[i]);
+        if (it == consumers.end()) {
+            continue;
+        }
+        if (const auto *moved = erase_slot(it->second, entry.consumer_slots[i])) {
+            // producers of a node are few, finding this one among them is cheap
+            auto &moved_entry = nodes.at(*moved);
+            const auto producer_idx = std::find(moved_entry.producers.begin(), moved_entry.producers.end(),
+                                                entry.producers[i]) - moved_entry.producers.begin();
+            moved_entry.consumer_slots[producer_idx] = entry.consumer_slots[i];
+        }
+        if (it->second.empty()) {
+            consumers.erase(it);
+        }
+    }
+    entry.indexed = false;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "graph.hpp"
+
+#include "utils/nocopy.hpp"
+#include "utils/utils.hpp"
+
+#include <cstdint>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// Secondary indexes over a graph: nodes by func, by name and the consumers of each node.
+// Built in full once, afterwards kept up to date by reporting changed nodes through touch(),
+// the same way as for GraphValidator. Lists of node ids are in no particular order, entries
+// remember where they are in them so removing a node does not search the lists.
+struct GraphIndex {
+    NOCOPY(GraphIndex)
+
+    struct NodeEntry {
+        uint32_t index_hint = 0;
+        bool indexed = false;
+        FuncId func_id{};
+        uint32_t func_slot = 0; // in by_func[func_id]
+        Symbol name;
+        std::vector<NodeId> producers;        // distinct
+        std::vector<uint32_t> consumer_slots; // in consumers[producers[i]]
+    };
+
+    const Graph *graph;
+
+    std::unordered_map<NodeId, NodeEntry, UuidHash> nodes;
+    std::unordered_map<FuncId, std::vector<NodeId>, UuidHash> by_func;
+    std::set<std::pair<std::string_view, NodeId>> by_name; // views of the interned names
+    std::unordered_map<NodeId, std::vector<NodeId>, UuidHash> consumers; // also of missing producers
+    bool index_fresh = false;
+
+    explicit GraphIndex(const Graph &graph);
+
+    // node was added, edited or removed
+    void touch(const NodeId &id);
+
+    void touch(std::span<const NodeId> ids);
+
+    [[nodiscard]] const Node *find(const NodeId &id);
+
+    [[nodiscard]] std::span<const NodeId> nodes_of(const FuncId &func_id) const;
+
+    [[nodiscard]] std::span<const NodeId> consumers_of(const NodeId &id) const;
+
+    // in name order, at most limit of them
+    [[nodiscard]] std::vector<NodeId> with_name_prefix(std::string_view prefix, size_t limit = SIZE_MAX) const;
+
+    const Node *locate(const NodeId &id);
+
+    void rebuild_hints();
+
+    void add(const Node &node, NodeEntry &entry);
+
+    void remove(const NodeId &id, NodeEntry &entry);
+};
@@ -0,0 +1,252 @@
+#include "journal.hpp"
+
+#include "encoding.hpp"
+#include "graph_file.hpp"
+
+#include "utils/file_sync.hpp"
+#include "utils/utils.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+
+
+static constexpr uint32_t JournalHeaderSize = 16;
+static constexpr uint32_t RecordHeaderSize = 16; // kind, payload size, checksum of the payload
+
+
+static std::string log_path(const std::string &path) {
+    return path + ".journal";
+}
+
+static std::string old_log_path(const std::string &path) {
+    return path + ".journal.old";
+}
+
+// Applies records to graph. Removed nodes are only marked while replaying and erased at the
+// end. Returns the size of the valid prefix of the log, 0 if it is not a journal at all.
+static uint64_t replay_log(const std::string &path, Graph &graph) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return 0;
+    }
+    std::vector<std::byte> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file || bytes.size() < JournalHeaderSize || load_u32(bytes.data()) != JournalMagic
+        || load_u32(bytes.data() + 4) != JournalVersion) {
+        return 0;
+    }
+
+    std::unordered_map<NodeId, size_t, UuidHash> positions;
+    positions.reserve(graph.nodes.size());
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        positions.emplace(graph.nodes[i].id, i);
+    }
+    std::vector<uint8_t> removed(graph.nodes.size(), 0);
+
+    // decode_values() wants its input aligned, copies of the payloads are
+    std::vector<std::byte> payload;
+    uint64_t offset = JournalHeaderSize;
+    while (bytes.size() - offset >= RecordHeaderSize) {
+        const auto kind = static_cast<JournalRecord>(load_u32(bytes.data() + offset));
+        const auto size = load_u32(bytes.data() + offset + 4);
+        uint64_t checksum;
+        std::memcpy(&checksum, bytes.data() + offset + 8, sizeof(checksum));
+        if (size > bytes.size() - offset - RecordHeaderSize) {
+            break;
+        }
+        const auto *data = bytes.data() + offset + RecordHeaderSize;
+        if (hash_bytes(data, size) != checksum) {
+            break;
+        }
+        payload.assign(data, data + size);
+
+        if (kind == JournalRecord::Upsert) {
+            GraphFile file{};
+            Graph single{};
+            if (!view_graph_file(&file, payload) || !file.to_graph(single) || single.nodes.size() != 1) {
+                break;
+            }
+            auto &node = single.nodes[0];
+            auto it = positions.find(node.id);
+            if (it != positions.end() && !removed[it->second]) {
+                graph.nodes[it->second] = std::move(node);
+            } else {
+                positions[node.id] = graph.nodes.size();
+                graph.nodes.push_back(std::move(node));
+                removed.push_back(0);
+            }
+        } else if (kind == JournalRecord::Remove && size == sizeof(FileUuid)) {
+            FileUuid id{};
+            std::memcpy(&id, payload.data(), sizeof(id));
+            if (auto it = positions.find(to_uuid(id)); it != positions.end()) {
+                removed[it->second] = 1;
+                positions.erase(it);
+            }
+        } else {
+            break;
+        }
+        offset += RecordHeaderSize + size;
+    }
+
+    size_t i = 0;
+    std::erase_if(graph.nodes, [&](const Node &) { return removed[i++] != 0; });
+    return offset;
+}
+
+static bool load_snapshot(const std::string &path, Graph &graph, std::vector<Func> &funcs) {
+    if (!std::filesystem::exists(path)) {
+        return true;
+    }
+    GraphFile file{};
+    return open_graph_file(&file, path) && file.to_graph(graph) && file.to_funcs(funcs);
+}
+
+
+Journal::~Journal() {
+    wait_compaction();
+}
+
+bool Journal::upsert(const Node &node) {
+    Graph single{};
+    single.nodes.push_back(node);
+    std::vector<std::byte> payload;
+    return encode_graph_file(single, {}, payload) && append(JournalRecord::Upsert, payload);
+}
+
+bool Journal::remove(const NodeId &id) {
+    const auto bytes = id.as_bytes();
+    return append(JournalRecord::Remove, bytes);
+}
+
+bool Journal::snapshot(const Graph &graph, std::span<const Func> funcs) {
+    while (true) {
+        wait_compaction();
+        std::lock_guard lock(mutex);
+        if (compacting) {
+            // an append started another one in between, it would overwrite this snapshot
+            continue;
+        }
+        if (!save_graph_file(graph, funcs, path)) {
+            return false;
+        }
+        // records left in the logs now only repeat what the snapshot holds
+        std::filesystem::remove(old_log_path(path));
+        return start_log();
+    }
+}
+
+bool Journal::compact() {
+    std::lock_guard lock(mutex);
+    if (compacting.exchange(true)) {
+        return false;
+    }
+    if (compactor.joinable()) {
+        compactor.join();
+    }
+
+    log.close();
+    std::error_code error;
+    std::filesystem::rename(log_path(path), old_log_path(path), error);
+    if (error || !start_log()) {
+        compacting = false;
+        return false;
+    }
+
+    compactor = std::thread([this] {
+        Graph graph{};
+        std::vector<Func> funcs;
+        bool ok = load_snapshot(path, graph, funcs);
+        ok = ok && replay_log(old_log_path(path), graph) != 0;
+        ok = ok && save_graph_file(graph, funcs, path);
+        if (ok) {
+            std::filesystem::remove(old_log_path(path));
+        }
+        // a failed compaction leaves the old log, the next open folds it in
+        compact_failed = !ok;
+        compacting = false;
+    });
+    return true;
+}
+
+bool Journal::wait_compaction() {
+    std::lock_guard lock(mutex);
+    if (compactor.joinable()) {
+        compactor.join();
+    }
+    return !compact_failed;
+}
+
+bool Journal::append(JournalRecord kind, std::span<const std::byte> payload) {
+    bool start_compaction = false;
+    {
+        std::lock_guard lock(mutex);
+        std::byte header[RecordHeaderSize];
+        store_u32(header, static_cast<uint32_t>(kind));
+        store_u32(header + 4, static_cast<uint32_t>(payload.size()));
+        const auto checksum = hash_bytes(payload.data(), payload.size());
+        std::memcpy(header + 8, &checksum, sizeof(checksum));
+
+        log.write(reinterpret_cast<const char *>(header), sizeof(header));
+        log.write(reinterpret_cast<const char *>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        log.flush();
+        if (!log.good() || (sync_appends && !sync_file(log_path(path)))) {
+            return false;
+        }
+        log_size += sizeof(header) + payload.size();
+        start_compaction = log_size >= compact_size && !compacting;
+    }
+    if (start_compaction) {
+        compact();
+    }
+    return true;
+}
+
+bool Journal::start_log() {
+    log.close();
+    log.open(log_path(path), std::ios::binary | std::ios::trunc);
+    std::byte header[JournalHeaderSize]{};
+    store_u32(header, JournalMagic);
+    store_u32(header + 4, JournalVersion);
+    log.write(reinterpret_cast<const char *>(header), sizeof(header));
+    log.flush();
+    log_size = sizeof(header);
+    return log.good() && sync_file(log_path(path)) && sync_parent_directory(path);
+}
+
+
+bool open_journal(Journal *journal, const std::string &path, Graph &graph, std::vector<Func> &funcs) {
+    journal->wait_compaction();
+    journal->path = path;
+    if (!load_snapshot(path, graph, funcs)) {
+        return false;
+    }
+
+    const auto old_log = old_log_path(path);
+    const bool unfinished = std::filesystem::exists(old_log);
+    if (unfinished) {
+        replay_log(old_log, graph);
+    }
+    const auto log = log_path(path);
+    const auto valid_size = replay_log(log, graph);
+    if (unfinished) {
+        return journal->snapshot(graph, funcs);
+    }
+    if (valid_size == 0) {
+        std::lock_guard lock(journal->mutex);
+        return journal->start_log();
+    }
+
+    // a torn record at the end is cut off, new records go right after the last complete one
+    std::error_code error;
+    std::filesystem::resize_file(log, valid_size, error);
+    if (error) {
+        return false;
+    }
+    std::lock_guard lock(journal->mutex);
+    journal->log.close();
+    journal->log.open(log, std::ios::binary | std::ios::app);
+    journal->log_size = valid_size;
+    return journal->log.good();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "func.hpp"
+#include "graph.hpp"
+
+#include "utils/nocopy.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+constexpr uint32_t JournalMagic = 0x4e524a47; // "GJRN"
+constexpr uint32_t JournalVersion = 1;
+
+enum class JournalRecord : uint32_t {
+    Upsert = 1, // payload is a graph file holding the node
+    Remove = 2, // payload is the node id
+};
+
+// Edits of a graph saved as a base snapshot at path (a graph file, see graph_file.hpp) plus an
+// append-only log at path + ".journal". Every record carries a checksum, so a record torn by a
+// crash ends the replay and is cut off when the journal is opened again. Records set the state
+// of a node rather than change it, which makes replaying one twice harmless. Appends return once
+// the record is on disk unless sync_appends is off, then a crash of the machine rather than of the
+// process may lose the latest records; snapshots and new logs are synced either way.
+//
+// Compaction renames the log to path + ".journal.old", starts a new one and folds the old log
+// into a new snapshot on a thread of its own. It never looks at the graph being edited, so
+// appends carry on meanwhile.
+struct Journal {
+    NOCOPY(Journal)
+
+    std::string path;
+    std::mutex mutex;
+    std::ofstream log;
+    uint64_t log_size = 0;
+    uint64_t compact_size = 64ull << 20; // log bytes after which appends start a compaction
+    bool sync_appends = true;
+    std::thread compactor;
+    std::atomic<bool> compacting{false};
+    bool compact_failed = false;
+
+    Journal() = default;
+
+    ~Journal();
+
+    // Returns false and appends nothing if a Const input of node has no encoding.
+    bool upsert(const Node &node);
+
+    bool remove(const NodeId &id);
+
+    // Replaces the snapshot with graph and empties the log, waits for a running compaction.
+    bool snapshot(const Graph &graph, std::span<const Func> funcs);
+
+    // Starts a background compaction, returns false if one is running already.
+    bool compact();
+
+    // returns whether the last compaction succeeded
+    bool wait_compaction();
+
+    bool append(JournalRecord kind, std::span<const std::byte> payload);
+
+    bool start_log();
+};
+
+// Loads the snapshot and replays the journal into graph and funcs. A missing snapshot gives an
+// empty graph. Leftovers of a compaction that did not finish are folded in by a new snapshot.
+bool open_journal(Journal *journal, const std::string &path, Graph &graph, std::vector<Func> &funcs);
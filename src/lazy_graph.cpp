@@ -0,0 +1,170 @@
+#include "lazy_graph.hpp"
+
+#include "loader.hpp"
+
+#include "utils/uuid_text.hpp"
+
+#include <cstring>
+#include <spanstream>
+#include <string_view>
+
+
+// id of the node in text, read from its "id:" key without parsing anything else
+static bool read_id(std::string_view text, NodeId &id) {
+    size_t start = 0;
+    if (text.starts_with("- id:")) {
+        start = 5;
+    } else {
+        start = text.find("\n  id:");
+        if (start == std::string_view::npos) {
+            return false;
+        }
+        start += 6;
+    }
+
+    auto value = text.substr(start, text.find('\n', start) - start);
+    while (!value.empty() && value.front() == ' ') {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\r')) {
+        value.remove_suffix(1);
+    }
+    if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front()) {
+        value = value.substr(1, value.size() - 2);
+    }
+
+    return parse_uuid(value, id);
+}
+
+
+bool LazyGraph::load(uint32_t position) {
+    auto &entry = entries[position];
+    if (entry.node_idx != UINT32_MAX) {
+        return true;
+    }
+
+    // a single node is a sequence of its own
+    const auto *text = reinterpret_cast<const char *>(file.data) + entry.offset;
+    std::ispanstream input(std::span<const char>(text, entry.size));
+    const auto node_count = graph.nodes.size();
+    if (!load_graph(input, *lib, graph) || graph.nodes.size() != node_count + 1
+        || graph.nodes.back().id != entry.id) {
+        graph.nodes.resize(node_count);
+        return false;
+    }
+    entry.node_idx = static_cast<uint32_t>(node_count);
+    return true;
+}
+
+const Node *LazyGraph::node(uint32_t position) {
+    if (position >= entries.size() || !load(position)) {
+        return nullptr;
+    }
+    return &graph.nodes[entries[position].node_idx];
+}
+
+const Node *LazyGraph::find(const NodeId &id) {
+    auto it = positions.find(id);
+    return it == positions.end() ? nullptr : node(it->second);
+}
+
+bool LazyGraph::load_range(uint32_t begin, uint32_t end) {
+    end = std::min(end, static_cast<uint32_t>(entries.size()));
+    for (auto position = begin; position < end; ++position) {
+        if (!load(position)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LazyGraph::load_reachable(std::span<const NodeId> outputs) {
+    std::vector<uint32_t> stack;
+    auto visit = [&](const NodeId &id) {
+        auto it = positions.find(id);
+        if (it != positions.end() && entries[it->second].node_idx == UINT32_MAX) {
+            stack.push_back(it->second);
+        }
+    };
+    for (const auto &id: outputs) {
+        visit(id);
+    }
+
+    while (!stack.empty()) {
+        const auto position = stack.back();
+        stack.pop_back();
+        if (entries[position].node_idx != UINT32_MAX) {
+            continue;
+        }
+        if (!load(position)) {
+            return false;
+        }
+        // by index, visiting does not load but the node may move with the next one
+        const auto node_idx = entries[position].node_idx;
+        for (const auto &input: graph.nodes[node_idx].inputs) {
+            if (input.binding == BindingType::Binding) {
+                visit(input.output_node_id);
+            }
+        }
+    }
+    return true;
+}
+
+
+bool open_lazy_graph(LazyGraph *graph, const std::string &path, const FuncLib &lib) {
+    if (!map_file(&graph->file, path)) {
+        return false;
+    }
+    graph->lib = &lib;
+    graph->entries.clear();
+    graph->positions.clear();
+    graph->graph.nodes.clear();
+
+    const auto *data = reinterpret_cast<const char *>(graph->file.data);
+    const auto size = graph->file.size;
+
+    // lines before the first node may only be a document start, comments or the empty "[]"
+    size_t line = 0;
+    while (line < size) {
+        const auto *newline = static_cast<const char *>(std::memchr(data + line, '\n', size - line));
+        const auto line_end = newline == nullptr ? size : static_cast<size_t>(newline - data);
+        const auto text = std::string_view(data + line, line_end - line);
+        if (text.starts_with("- ") || text == "-") {
+            break;
+        }
+        if (!text.empty() && text != "---" && text != "[]" && !text.starts_with('#')) {
+            return false;
+        }
+        line = line_end + 1;
+    }
+
+    std::vector<size_t> starts;
+    while (line < size) {
+        starts.push_back(line);
+        for (;;) {
+            const auto *newline = static_cast<const char *>(std::memchr(data + line, '\n', size - line));
+            if (newline == nullptr) {
+                line = size;
+                break;
+            }
+            line = static_cast<size_t>(newline - data) + 1;
+            if (line < size && data[line] == '-' && (line + 1 == size || data[line + 1] == ' ' || data[line + 1] == '\n')) {
+                break;
+            }
+        }
+    }
+    starts.push_back(size);
+
+    graph->entries.resize(starts.size() - 1);
+    graph->positions.reserve(graph->entries.size());
+    for (uint32_t position = 0; position < graph->entries.size(); ++position) {
+        auto &entry = graph->entries[position];
+        entry.offset = starts[position];
+        entry.size = starts[position + 1] - starts[position];
+        if (!read_id(std::string_view(data + entry.offset, entry.size), entry.id)) {
+            return false;
+        }
+        graph->positions.emplace(entry.id, position);
+    }
+    return true;
+}
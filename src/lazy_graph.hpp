@@ -0,0 +1,60 @@
+#pragma once
+
+#include "func.hpp"
+#include "graph.hpp"
+
+#include "utils/mapped_file.hpp"
+#include "utils/nocopy.hpp"
+#include "utils/utils.hpp"
+
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// A graph saved as YAML whose nodes are parsed on first access. Opening maps the file and only
+// indexes it: every node of the top-level block sequence starts with a "- " at column 0, which
+// nothing inside a node written by operator<< or write_yaml() does, and its id is read from
+// there without parsing the rest.
+struct LazyGraph {
+    NOCOPY(LazyGraph)
+
+    struct Entry {
+        NodeId id{};
+        size_t offset = 0;             // of the "- " starting the node
+        size_t size = 0;
+        uint32_t node_idx = UINT32_MAX; // in graph.nodes once loaded
+    };
+
+    MappedFile file;
+    const FuncLib *lib = nullptr;
+    std::vector<Entry> entries;                               // in file order
+    std::unordered_map<NodeId, uint32_t, UuidHash> positions; // entry of every id
+    Graph graph;                                              // loaded nodes, in the order they were loaded
+
+    LazyGraph() = default;
+
+    [[nodiscard]] size_t size() const {
+        return entries.size();
+    }
+
+    // Loads the node at position in the file on first access, nullptr if it does not parse.
+    // Loading further nodes invalidates the pointer like appending to a vector would.
+    const Node *node(uint32_t position);
+
+    // nullptr for ids that are not in the file
+    const Node *find(const NodeId &id);
+
+    // the nodes at positions [begin, end), e.g. what an editor viewport shows
+    bool load_range(uint32_t begin, uint32_t end);
+
+    // Outputs and every node they depend on through Binding inputs, which is all graph needs to
+    // run them. Producers that are not in the file are left to the validator.
+    bool load_reachable(std::span<const NodeId> outputs);
+
+    bool load(uint32_t position);
+};
+
+// Fails for files that are not a block sequence of nodes, an empty graph is "[]".
+bool open_lazy_graph(LazyGraph *graph, const std::string &path, const FuncLib &lib);
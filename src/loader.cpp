@@ -0,0 +1,384 @@
+#include "loader.hpp"
+
+#include "utils/uuid_text.hpp"
+
+#include <yaml-cpp/eventhandler.h>
+#include <yaml-cpp/yaml.h>
+
+#include <charconv>
+#include <optional>
+#include <string>
+#include <string_view>
+
+
+enum class LoadContext : uint8_t {
+    Document,
+    Nodes, Node, Inputs, Input, NodeEvents, NodeEvent, Subscribers,
+    Funcs, Func, Args, Arg, FuncEvents, FuncEvent,
+    Skip,
+};
+
+struct LoadFrame {
+    LoadContext context = LoadContext::Skip;
+    bool is_map = false;
+    bool expect_key = true;
+    std::string key;
+};
+
+
+static bool parse_bool(std::string_view scalar, bool &value) {
+    // what YAML::Emitter writes, plus the other spellings of YAML 1.1 it reads back
+    if (scalar == "true" || scalar == "True" || scalar == "TRUE" || scalar == "yes" || scalar == "on") {
+        value = true;
+        return true;
+    }
+    if (scalar == "false" || scalar == "False" || scalar == "FALSE" || scalar == "no" || scalar == "off") {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+static bool parse_uint32(std::string_view scalar, uint32_t &value) {
+    const auto *end = scalar.data() + scalar.size();
+    auto [ptr, error] = std::from_chars(scalar.data(), end, value);
+    return error == std::errc{} && ptr == end;
+}
+
+
+// Turns parse events into Nodes or Funcs. Frames mirror the open maps and sequences, scalars in
+// maps alternate between keys and values. Const values are collected into YAML::Nodes: scalars
+// on their own, containers by a stack of their own that is closed bottom-up so children are
+// complete when they are added.
+class LoadHandler final : public YAML::EventHandler {
+public:
+    const FuncLib *lib = nullptr;
+    Graph *graph = nullptr;
+    std::vector<Func> *funcs = nullptr;
+    bool failed = false;
+
+    void OnDocumentStart(const YAML::Mark &) override {
+        frames.push_back(LoadFrame{LoadContext::Document, false, true, {}});
+    }
+
+    void OnDocumentEnd() override {
+        frames.clear();
+    }
+
+    void OnNull(const YAML::Mark &, YAML::anchor_t) override {
+        if (!captured.empty()) {
+            add_captured(YAML::Node(YAML::NodeType::Null));
+            return;
+        }
+        scalar(nullptr);
+    }
+
+    void OnAlias(const YAML::Mark &, YAML::anchor_t) override {
+        // never written by the emitters
+        failed = true;
+    }
+
+    void OnScalar(const YAML::Mark &, const std::string &tag, YAML::anchor_t, const std::string &value) override {
+        if (!captured.empty()) {
+            YAML::Node node(value);
+            node.SetTag(tag);
+            add_captured(std::move(node));
+            return;
+        }
+        scalar(&value);
+    }
+
+    void OnSequenceStart(const YAML::Mark &, const std::string &, YAML::anchor_t, YAML::EmitterStyle::value) override {
+        start(YAML::NodeType::Sequence);
+    }
+
+    void OnSequenceEnd() override {
+        end();
+    }
+
+    void OnMapStart(const YAML::Mark &, const std::string &, YAML::anchor_t, YAML::EmitterStyle::value) override {
+        start(YAML::NodeType::Map);
+    }
+
+    void OnMapEnd() override {
+        end();
+    }
+
+private:
+    std::vector<LoadFrame> frames;
+    Node node;
+    const Func *node_func = nullptr;
+    Func func;
+
+    std::vector<YAML::Node> captured;             // open containers of a Const value
+    std::vector<std::optional<std::string>> keys; // pending key per open captured map
+
+    // value is null for a YAML null
+    void scalar(const std::string *value) {
+        auto &frame = frames.back();
+        if (frame.is_map && frame.expect_key) {
+            frame.key = value != nullptr ? *value : std::string();
+            frame.expect_key = false;
+            return;
+        }
+        if (frame.is_map && frame.context == LoadContext::Input && frame.key == "value") {
+            parse_const(value != nullptr ? YAML::Node(*value) : YAML::Node(YAML::NodeType::Null));
+        } else if (value != nullptr) {
+            set_field(frame, *value);
+        }
+        frame.expect_key = true;
+    }
+
+    void start(YAML::NodeType::value type) {
+        if (!captured.empty()) {
+            captured.emplace_back(type);
+            keys.emplace_back();
+            return;
+        }
+
+        const auto &parent = frames.back();
+        if (parent.is_map && parent.context == LoadContext::Input && parent.key == "value") {
+            captured.emplace_back(type);
+            keys.emplace_back();
+            return;
+        }
+        const auto context = child_context(parent, type == YAML::NodeType::Map);
+
+        switch (context) {
+            case LoadContext::Node:
+                node = Node{};
+                node_func = nullptr;
+                break;
+            case LoadContext::Input:
+                node.inputs.emplace_back();
+                break;
+            case LoadContext::NodeEvent:
+                node.events.emplace_back();
+                break;
+            case LoadContext::Func:
+                func = Func{};
+                break;
+            case LoadContext::Arg:
+                func.args.emplace_back();
+                break;
+            case LoadContext::FuncEvent:
+                func.events.emplace_back();
+                break;
+            default:
+                break;
+        }
+        frames.push_back(LoadFrame{context, type == YAML::NodeType::Map, true, {}});
+    }
+
+    void end() {
+        if (!captured.empty()) {
+            auto done = std::move(captured.back());
+            captured.pop_back();
+            keys.pop_back();
+            if (captured.empty()) {
+                parse_const(done);
+                frames.back().expect_key = true;
+            } else {
+                add_captured(std::move(done));
+            }
+            return;
+        }
+
+        const auto context = frames.back().context;
+        frames.pop_back();
+        if (context == LoadContext::Node && graph != nullptr) {
+            graph->nodes.push_back(std::move(node));
+        } else if (context == LoadContext::Func && funcs != nullptr) {
+            funcs->push_back(std::move(func));
+        }
+        if (!frames.empty()) {
+            frames.back().expect_key = true;
+        }
+    }
+
+    [[nodiscard]] LoadContext child_context(const LoadFrame &parent, bool is_map) const {
+        const auto &key = parent.key;
+        switch (parent.context) {
+            case LoadContext::Document:
+                if (graph != nullptr) {
+                    return is_map ? LoadContext::Skip : LoadContext::Nodes;
+                }
+                return is_map ? LoadContext::Func : LoadContext::Funcs;
+            case LoadContext::Nodes:
+                return is_map ? LoadContext::Node : LoadContext::Skip;
+            case LoadContext::Node:
+                if (!is_map && key == "inputs") {
+                    return LoadContext::Inputs;
+                }
+                return !is_map && key == "events" ? LoadContext::NodeEvents : LoadContext::Skip;
+            case LoadContext::Inputs:
+                return is_map ? LoadContext::Input : LoadContext::Skip;
+            case LoadContext::NodeEvents:
+                return is_map ? LoadContext::NodeEvent : LoadContext::Skip;
+            case LoadContext::NodeEvent:
+                return !is_map && key == "subscribers" ? LoadContext::Subscribers : LoadContext::Skip;
+            case LoadContext::Funcs:
+                return is_map ? LoadContext::Func : LoadContext::Skip;
+            case LoadContext::Func:
+                if (!is_map && key == "args") {
+                    return LoadContext::Args;
+                }
+                return !is_map && key == "events" ? LoadContext::FuncEvents : LoadContext::Skip;
+            case LoadContext::Args:
+                return is_map ? LoadContext::Arg : LoadContext::Skip;
+            case LoadContext::FuncEvents:
+                return is_map ? LoadContext::FuncEvent : LoadContext::Skip;
+            default:
+                return LoadContext::Skip;
+        }
+    }
+
+    void set_field(const LoadFrame &frame, const std::string &value) {
+        const auto &key = frame.key;
+        bool ok = true;
+        switch (frame.context) {
+            case LoadContext::Node:
+                if (key == "id") {
+                    ok = parse_uuid(value, node.id);
+                } else if (key == "func_id") {
+                    ok = parse_uuid(value, node.func_id);
+                    node_func = lib != nullptr ? lib->find(node.func_id) : nullptr;
+                } else if (key == "name") {
+                    node.name = value;
+                } else if (key == "is_output") {
+                    ok = parse_bool(value, node.is_output);
+                } else if (key == "cache_outputs") {
+                    ok = parse_bool(value, node.cache_outputs);
+                } else if (key == "timeout_ms") {
+                    ok = parse_uint32(value, node.timeout_ms);
+                }
+                break;
+
+            case LoadContext::Input: {
+                auto &input = node.inputs.back();
+                if (key == "binding") {
+                    if (value == "None") {
+                        input.binding = BindingType::None;
+                    } else if (value == "Const") {
+                        input.binding = BindingType::Const;
+                    } else if (value == "Binding") {
+                        input.binding = BindingType::Binding;
+                    } else {
+                        ok = false;
+                    }
+                } else if (key == "output_node_id") {
+                    ok = parse_uuid(value, input.output_node_id);
+                } else if (key == "output_idx") {
+                    ok = parse_uint32(value, input.output_idx);
+                }
+                break;
+            }
+
+            case LoadContext::Subscribers: {
+                auto &subscriber = node.events.back().subscribers.emplace_back();
+                ok = parse_uuid(value, subscriber);
+                break;
+            }
+
+            case LoadContext::Func:
+                if (key == "id") {
+                    ok = parse_uuid(value, func.id);
+                } else if (key == "name") {
+                    func.name = value;
+                } else if (key == "behavior") {
+                    if (value == "Pure") {
+                        func.behavior = FuncBehavior::Pure;
+                    } else if (value == "Impure") {
+                        func.behavior = FuncBehavior::Impure;
+                    } else {
+                        ok = false;
+                    }
+                }
+                break;
+
+            case LoadContext::Arg: {
+                auto &arg = func.args.back();
+                if (key == "name") {
+                    arg.name = value;
+                } else if (key == "datatype") {
+                    ok = parse_uint32(value, arg.datatype);
+                } else if (key == "required") {
+                    ok = parse_bool(value, arg.required);
+                } else if (key == "type") {
+                    if (value == "In") {
+                        arg.type = FuncArgType::In;
+                    } else if (value == "Out") {
+                        arg.type = FuncArgType::Out;
+                    } else {
+                        ok = false;
+                    }
+                } else if (key == "streaming") {
+                    ok = parse_bool(value, arg.streaming);
+                }
+                break;
+            }
+
+            case LoadContext::FuncEvent:
+                if (key == "name") {
+                    func.events.back().name = value;
+                }
+                break;
+
+            default:
+                break;
+        }
+        failed |= !ok;
+    }
+
+    void add_captured(YAML::Node child) {
+        auto &parent = captured.back();
+        if (parent.IsSequence()) {
+            parent.push_back(child);
+            return;
+        }
+        auto &key = keys.back();
+        if (key.has_value()) {
+            parent[*key] = child;
+            key.reset();
+        } else {
+            key = child.Scalar();
+        }
+    }
+
+    void parse_const(const YAML::Node &value) {
+        const auto input_idx = node.inputs.size() - 1;
+        if (node_func == nullptr || input_idx >= node_func->args.size()) {
+            failed = true;
+            return;
+        }
+        auto &input = node.inputs.back();
+        input.value.emplace();
+        failed |= !parse_value(value, node_func->args[input_idx].datatype, *input.value);
+    }
+};
+
+
+static bool load(std::istream &input, LoadHandler &handler) {
+    try {
+        YAML::Parser parser(input);
+        if (!parser.HandleNextDocument(handler)) {
+            return false;
+        }
+    } catch (const YAML::Exception &) {
+        return false;
+    }
+    return !handler.failed;
+}
+
+bool load_graph(std::istream &input, const FuncLib &lib, Graph &graph) {
+    LoadHandler handler{};
+    handler.lib = &lib;
+    handler.graph = &graph;
+    return load(input, handler);
+}
+
+bool load_funcs(std::istream &input, std::vector<Func> &funcs) {
+    LoadHandler handler{};
+    handler.funcs = &funcs;
+    return load(input, handler);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "func.hpp"
+#include "graph.hpp"
+
+#include <istream>
+#include <vector>
+
+
+// Loaders for what the YAML operator<<s of Graph and Func write. They consume parse events as
+// they come and build nodes and funcs directly, only Const values that are maps or sequences
+// (tensors) are collected into a YAML::Node before they are parsed. Unknown keys are skipped.
+// On failure the output holds whatever was read before the error.
+
+// Const values are parsed as the datatype of the arg they are bound to, so the func of every
+// node has to be in lib. Nodes are appended to graph.
+bool load_graph(std::istream &input, const FuncLib &lib, Graph &graph);
+
+// Reads a single func or a sequence of them and appends them to funcs. Funcs are only
+// declarations, lambdas have to be attached afterwards.
+bool load_funcs(std::istream &input, std::vector<Func> &funcs);
@@ -0,0 +1,337 @@
+#include "plan.hpp"
+
+#include "subgraph.hpp"
+
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+
+std::string to_string(const RunResult &run_result) {
+    switch (run_result) {
+        case RunResult::Ok:
+            return "Ok";
+        case RunResult::MissingFunc:
+            return "MissingFunc";
+        case RunResult::UnboundInput:
+            return "UnboundInput";
+        case RunResult::Cycle:
+            return "Cycle";
+        case RunResult::StreamMismatch:
+            return "StreamMismatch";
+        case RunResult::StreamDeadlock:
+            return "StreamDeadlock";
+        case RunResult::Cancelled:
+            return "Cancelled";
+        case RunResult::TimedOut:
+            return "TimedOut";
+        case RunResult::InvalidInput:
+            return "InvalidInput";
+        case RunResult::RecursiveSubgraph:
+            return "RecursiveSubgraph";
+    }
+    assert(false);
+}
+
+
+// Stages start once their single-value inputs are there. A stage waiting for a value that is only
+// there once a stage streaming into it, directly or through other stages, has finished never
+// starts, and the stage streaming into it blocks on the full channel. Such a stage C has a
+// producer P upstream of it through stream edges only, and a path from P to C with a single-value
+// edge; rejected even if a stage on the way would stop reading early. Tracked in topological order
+// with bitsets over the producers of streams: ancestors, those upstream through stream edges only
+// and those with a single-value edge on the way.
+static bool has_stream_deadlock(
+        std::span<const uint32_t> order,
+        std::span<const std::vector<uint32_t>> consumers,
+        std::span<const std::vector<uint32_t>> stream_outs,
+        std::span<const uint32_t> stream_consumers
+) {
+    const auto node_count = stream_outs.size();
+    std::vector<uint32_t> producer_bits(node_count, UINT32_MAX);
+    uint32_t producer_count = 0;
+    for (size_t i = 0; i < node_count; ++i) {
+        if (!stream_outs[i].empty()) {
+            producer_bits[i] = producer_count++;
+        }
+    }
+    if (producer_count == 0) {
+        return false;
+    }
+
+    const size_t words = (producer_count + 63) / 64;
+    std::vector<uint64_t> ancestors(node_count * words, 0);
+    std::vector<uint64_t> upstream(node_count * words, 0);
+    std::vector<uint64_t> waits(node_count * words, 0);
+    std::vector<uint64_t> self(words);
+    for (const auto node_idx: order) {
+        const auto node = node_idx * words;
+        for (size_t w = 0; w < words; ++w) {
+            if ((upstream[node + w] & waits[node + w]) != 0) {
+                return true;
+            }
+        }
+        std::fill(self.begin(), self.end(), 0);
+        if (producer_bits[node_idx] != UINT32_MAX) {
+            self[producer_bits[node_idx] / 64] = uint64_t{1} << (producer_bits[node_idx] % 64);
+        }
+        for (const auto consumer: consumers[node_idx]) {
+            for (size_t w = 0; w < words; ++w) {
+                ancestors[consumer * words + w] |= ancestors[node + w] | self[w];
+                waits[consumer * words + w] |= ancestors[node + w] | self[w];
+            }
+        }
+        for (const auto stream_idx: stream_outs[node_idx]) {
+            const auto consumer = stream_consumers[stream_idx];
+            for (size_t w = 0; w < words; ++w) {
+                ancestors[consumer * words + w] |= ancestors[node + w] | self[w];
+                upstream[consumer * words + w] |= upstream[node + w] | self[w];
+                waits[consumer * words + w] |= waits[node + w];
+            }
+        }
+    }
+    return false;
+}
+
+// forwards overrides the func of a node, for calls to inlined subgraphs
+static RunResult compile_nodes(
+        const Graph &graph,
+        const FuncLib &lib,
+        std::span<const Func *const> forwards,
+        const CompileOptions &options,
+        GraphPlan &plan
+) {
+    const auto node_count = static_cast<uint32_t>(graph.nodes.size());
+    auto resolve = [&](uint32_t node_idx) {
+        if (node_idx < forwards.size() && forwards[node_idx] != nullptr) {
+            return forwards[node_idx];
+        }
+        return lib.find(graph.nodes[node_idx].func_id);
+    };
+
+    std::unordered_map<NodeId, uint32_t, UuidHash> node_indices;
+    node_indices.reserve(node_count);
+    for (uint32_t i = 0; i < node_count; ++i) {
+        node_indices.emplace(graph.nodes[i].id, i);
+    }
+
+    std::vector<const Func *> funcs(node_count, nullptr);
+    std::vector<std::vector<InputSource>> sources(node_count);
+    std::vector<std::vector<uint32_t>> consumers(node_count);
+    std::vector<uint32_t> producer_counts(node_count, 0);
+    std::vector<Value> consts;
+    std::vector<StreamEdge> streams;
+    std::vector<uint32_t> stream_consumers; // per stream
+    std::vector<std::vector<uint32_t>> stream_outs(node_count);
+    std::vector<uint32_t> stream_producer_counts(node_count, 0);
+
+    std::vector<uint32_t> stack;
+    for (uint32_t i = 0; i < node_count; ++i) {
+        if (graph.nodes[i].is_output) {
+            stack.push_back(i);
+        }
+    }
+
+    uint32_t evaluated_count = 0;
+    while (!stack.empty()) {
+        const auto node_idx = stack.back();
+        stack.pop_back();
+        if (funcs[node_idx] != nullptr) {
+            continue;
+        }
+
+        const auto &node = graph.nodes[node_idx];
+        const auto *func = resolve(node_idx);
+        if (func == nullptr || !func->is_callable()) {
+            return RunResult::MissingFunc;
+        }
+        if (func->subgraph != nullptr) {
+            const auto result = prepare_subgraph(*func->subgraph, lib, options);
+            if (result != RunResult::Ok) {
+                return result;
+            }
+        }
+        funcs[node_idx] = func;
+        ++evaluated_count;
+
+        for (size_t arg_idx = 0; arg_idx < func->args.size(); ++arg_idx) {
+            const auto &arg = func->args[arg_idx];
+            if (arg.type != FuncArgType::In) {
+                continue;
+            }
+
+            auto &source = sources[node_idx].emplace_back();
+            const NodeInput *input = arg_idx < node.inputs.size() ? &node.inputs[arg_idx] : nullptr;
+            source.binding = input != nullptr ? input->binding : BindingType::None;
+            source.streaming = arg.streaming;
+
+            switch (source.binding) {
+                case BindingType::None:
+                    if (arg.required) {
+                        return RunResult::UnboundInput;
+                    }
+                    break;
+
+                case BindingType::Const:
+                    if (!input->value.has_value()) {
+                        return RunResult::UnboundInput;
+                    }
+                    source.const_idx = static_cast<uint32_t>(consts.size());
+                    consts.push_back(input->value.value());
+                    if (source.streaming) {
+                        source.stream_idx = static_cast<uint32_t>(streams.size());
+                        streams.push_back(StreamEdge{BindingType::Const, 0, 0, 0});
+                        stream_consumers.push_back(node_idx);
+                    }
+                    break;
+
+                case BindingType::Binding: {
+                    auto it = node_indices.find(input->output_node_id);
+                    if (it == node_indices.end()) {
+                        return RunResult::UnboundInput;
+                    }
+                    source.node_idx = it->second;
+                    source.output_idx = input->output_idx;
+                    stack.push_back(source.node_idx);
+
+                    const auto *producer = resolve(source.node_idx);
+                    const auto *output = producer != nullptr ? producer->output_arg(source.output_idx) : nullptr;
+                    if (output != nullptr && output->streaming != source.streaming) {
+                        return RunResult::StreamMismatch;
+                    }
+                    if (source.streaming) {
+                        source.stream_idx = static_cast<uint32_t>(streams.size());
+                        streams.push_back(StreamEdge{BindingType::Binding, source.node_idx, source.output_idx, 0});
+                        stream_consumers.push_back(node_idx);
+                        stream_outs[source.node_idx].push_back(source.stream_idx);
+                        ++stream_producer_counts[node_idx];
+                    } else {
+                        consumers[source.node_idx].push_back(node_idx);
+                        ++producer_counts[node_idx];
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // Kahn's algorithm over the evaluated nodes and both kinds of edges, anything left unsorted
+    // sits on a cycle
+    std::vector<uint32_t> roots;
+    std::vector<uint32_t> in_degree(node_count, 0);
+    for (uint32_t i = 0; i < node_count; ++i) {
+        if (funcs[i] != nullptr && producer_counts[i] == 0) {
+            roots.push_back(i);
+        }
+        in_degree[i] = producer_counts[i] + stream_producer_counts[i];
+        if (funcs[i] != nullptr && in_degree[i] == 0) {
+            stack.push_back(i);
+        }
+    }
+    std::vector<uint32_t> order;
+    order.reserve(evaluated_count);
+    auto release = [&](uint32_t consumer) {
+        if (--in_degree[consumer] == 0) {
+            stack.push_back(consumer);
+        }
+    };
+    while (!stack.empty()) {
+        const auto node_idx = stack.back();
+        stack.pop_back();
+        order.push_back(node_idx);
+        for (const auto consumer: consumers[node_idx]) {
+            release(consumer);
+        }
+        for (const auto stream_idx: stream_outs[node_idx]) {
+            release(stream_consumers[stream_idx]);
+        }
+    }
+    if (order.size() != evaluated_count) {
+        return RunResult::Cycle;
+    }
+    if (has_stream_deadlock(order, consumers, stream_outs, stream_consumers)) {
+        return RunResult::StreamDeadlock;
+    }
+
+    plan.node_count = node_count;
+    plan.evaluated_count = evaluated_count;
+    plan.funcs = std::move(funcs);
+    plan.order = std::move(order);
+    plan.timeouts.resize(node_count);
+    for (uint32_t i = 0; i < node_count; ++i) {
+        plan.timeouts[i] = graph.nodes[i].timeout_ms;
+    }
+    plan.producer_counts = std::move(producer_counts);
+    plan.roots = std::move(roots);
+    plan.consts = std::move(consts);
+    plan.streams = std::move(streams);
+
+    plan.source_offsets.assign(node_count + 1, 0);
+    plan.consumer_offsets.assign(node_count + 1, 0);
+    plan.stream_out_offsets.assign(node_count + 1, 0);
+    plan.sources.clear();
+    plan.consumers.clear();
+    plan.stream_outs.clear();
+    for (uint32_t i = 0; i < node_count; ++i) {
+        plan.source_offsets[i] = static_cast<uint32_t>(plan.sources.size());
+        plan.consumer_offsets[i] = static_cast<uint32_t>(plan.consumers.size());
+        plan.stream_out_offsets[i] = static_cast<uint32_t>(plan.stream_outs.size());
+        for (const auto &source: sources[i]) {
+            if (source.streaming && source.binding != BindingType::None) {
+                plan.streams[source.stream_idx].source_idx = static_cast<uint32_t>(plan.sources.size());
+            }
+            plan.sources.push_back(source);
+        }
+        plan.consumers.insert(plan.consumers.end(), consumers[i].begin(), consumers[i].end());
+        plan.stream_outs.insert(plan.stream_outs.end(), stream_outs[i].begin(), stream_outs[i].end());
+    }
+    plan.source_offsets[node_count] = static_cast<uint32_t>(plan.sources.size());
+    plan.consumer_offsets[node_count] = static_cast<uint32_t>(plan.consumers.size());
+    plan.stream_out_offsets[node_count] = static_cast<uint32_t>(plan.stream_outs.size());
+
+    return RunResult::Ok;
+}
+
+RunResult compile_plan(const Graph &graph, const FuncLib &lib, GraphPlan &plan, const CompileOptions &options) {
+    Graph flat{};
+    std::vector<const Func *> forwards;
+    if (inline_subgraphs(graph, lib, options, flat, forwards)) {
+        return compile_nodes(flat, lib, forwards, options, plan);
+    }
+    return compile_nodes(graph, lib, {}, options, plan);
+}
+
+
+GraphInstance::GraphInstance(std::shared_ptr<const GraphPlan> plan) : plan(std::move(plan)) {}
+
+void GraphInstance::set_const(uint32_t node_idx, uint32_t input_idx, Value value) {
+    const auto source_idx = plan->source_offsets[node_idx] + input_idx;
+    assert(source_idx < plan->source_offsets[node_idx + 1]);
+    assert(plan->sources[source_idx].binding == BindingType::Const);
+
+    auto it = std::ranges::lower_bound(overrides, source_idx, {}, &std::pair<uint32_t, Value>::first);
+    if (it != overrides.end() && it->first == source_idx) {
+        it->second = std::move(value);
+    } else {
+        overrides.emplace(it, source_idx, std::move(value));
+    }
+}
+
+void GraphInstance::clear_const(uint32_t node_idx, uint32_t input_idx) {
+    const auto source_idx = plan->source_offsets[node_idx] + input_idx;
+
+    auto it = std::ranges::lower_bound(overrides, source_idx, {}, &std::pair<uint32_t, Value>::first);
+    if (it != overrides.end() && it->first == source_idx) {
+        overrides.erase(it);
+    }
+}
+
+const Value &GraphInstance::const_value(uint32_t source_idx) const {
+    auto it = std::ranges::lower_bound(overrides, source_idx, {}, &std::pair<uint32_t, Value>::first);
+    if (it != overrides.end() && it->first == source_idx) {
+        return it->second;
+    }
+    return plan->consts[plan->sources[source_idx].const_idx];
+}
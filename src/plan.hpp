@@ -0,0 +1,113 @@
+#pragma once
+
+#include "func.hpp"
+#include "graph.hpp"
+#include "value.hpp"
+
+#include "utils/nocopy.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+enum class RunResult : uint8_t {
+    Ok,
+    MissingFunc,  // node refers to a func that is not in the lib or has nothing to call
+    UnboundInput, // required input is not bound, or bound to a node that does not exist
+    Cycle,
+    StreamMismatch, // streaming output bound to a single-value input or the other way round
+    StreamDeadlock, // a stage waits for a single value that depends on a stage streaming into it
+    Cancelled,      // the run was cancelled, skipped nodes have no outputs
+    TimedOut,       // a node ran past its timeout, its outputs were dropped
+    InvalidInput,   // a node could not be evaluated on its inputs, its outputs were dropped
+    RecursiveSubgraph, // a subgraph func calls itself, directly or through other subgraphs
+};
+
+std::string to_string(const RunResult &run_result);
+
+
+struct InputSource {
+    BindingType binding = BindingType::None;
+    uint32_t node_idx = 0;   // producer for Binding
+    uint32_t output_idx = 0; // producer output for Binding
+    uint32_t const_idx = 0;  // into GraphPlan::consts for Const
+    bool streaming = false;
+    uint32_t stream_idx = 0; // into GraphPlan::streams for streaming args
+};
+
+// Stream of chunks into a streaming input, from a producer output or from a Const input that
+// becomes a stream of one chunk.
+struct StreamEdge {
+    BindingType binding = BindingType::Binding;
+    uint32_t node_idx = 0;   // producer for Binding
+    uint32_t output_idx = 0; // producer output for Binding
+    uint32_t source_idx = 0; // the streaming input
+};
+
+// Immutable part of a graph: which nodes are evaluated, their funcs and how they are wired.
+// Adjacency is stored flat, node i owns [offsets[i], offsets[i + 1]) of the matching array.
+// Stream edges are not counted as producers: both ends run at the same time as a pipeline.
+// Any number of GraphInstances may share one plan and run concurrently.
+struct GraphPlan {
+    NOCOPY(GraphPlan)
+
+    uint32_t node_count = 0;
+    uint32_t evaluated_count = 0;
+
+    std::vector<const Func *> funcs; // per node, null for nodes no output depends on
+    std::vector<uint32_t> order;     // evaluated nodes, producers before consumers
+    std::vector<uint32_t> timeouts;  // per node in milliseconds, 0 for none
+    std::vector<uint32_t> source_offsets;
+    std::vector<InputSource> sources; // one per In arg of each evaluated node
+    std::vector<uint32_t> consumer_offsets;
+    std::vector<uint32_t> consumers;
+    std::vector<uint32_t> producer_counts;
+    std::vector<uint32_t> roots; // evaluated nodes without producers
+    std::vector<Value> consts;   // defaults of Const inputs
+    std::vector<StreamEdge> streams;
+    std::vector<uint32_t> stream_out_offsets;
+    std::vector<uint32_t> stream_outs; // streams written by each node
+
+    GraphPlan() = default;
+};
+
+struct CompileOptions {
+    uint32_t max_inline_nodes = 16; // calls to subgraphs up to this size are inlined
+};
+
+// Compiles the output nodes of the graph and everything they depend on. Func pointers
+// refer into lib, which has to outlive the plan; the graph itself may change afterwards.
+// Nodes of inlined subgraphs are appended after the nodes of the graph, so node indices of the
+// graph stay valid for the plan and its instances.
+RunResult compile_plan(const Graph &graph, const FuncLib &lib, GraphPlan &plan, const CompileOptions &options = {});
+
+
+struct Checkpoint;
+struct Trace;
+
+// Mutable per-instance state: overrides of Const inputs and the outputs of the last run.
+struct GraphInstance {
+    NOCOPY(GraphInstance)
+
+    std::shared_ptr<const GraphPlan> plan;
+    std::vector<std::pair<uint32_t, Value>> overrides; // by source index, sorted
+    std::vector<NodeOutputs> outputs;                  // indexed like Graph::nodes
+    Trace *trace = nullptr;                            // records or replays Impure outputs
+    Checkpoint *checkpoint = nullptr;                  // saves completed outputs to resume from
+
+    explicit GraphInstance(std::shared_ptr<const GraphPlan> plan);
+
+    GraphInstance(GraphInstance &&) = default;
+
+    GraphInstance &operator=(GraphInstance &&) = default;
+
+    // input_idx counts In args only, like the inputs passed to FuncLambda
+    void set_const(uint32_t node_idx, uint32_t input_idx, Value value);
+
+    void clear_const(uint32_t node_idx, uint32_t input_idx);
+
+    [[nodiscard]] const Value &const_value(uint32_t source_idx) const;
+};
@@ -0,0 +1,271 @@
+#include "remote.hpp"
+
+#include "encoding.hpp"
+
+#include "utils/futex.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <new>
+
+
+static constexpr uint32_t ChannelMagic = 0x52504d53; // "SMPR"
+static constexpr uint32_t RecordAlignment = 16;
+static constexpr uint32_t RecordHeaderSize = 16;
+static constexpr uint32_t PaddingRecord = 0xffffffff;
+
+static std::chrono::milliseconds remaining(std::chrono::steady_clock::time_point deadline) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    return std::max(left, std::chrono::milliseconds(1));
+}
+
+
+uint32_t ShmRing::max_message_size() const {
+    return header->capacity / 2 - RecordHeaderSize;
+}
+
+std::byte *ShmRing::begin_write(uint32_t size, std::chrono::milliseconds timeout) {
+    assert(size <= max_message_size());
+    const auto capacity = header->capacity;
+    const auto needed = align_up(RecordHeaderSize + size, RecordAlignment);
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true) {
+        const auto head = header->head.load(std::memory_order_relaxed);
+        const auto tail = header->tail.load(std::memory_order_acquire);
+        const auto offset = head & (capacity - 1);
+        const auto contiguous = capacity - offset;
+        const auto total = needed <= contiguous ? needed : contiguous + needed;
+
+        if (capacity - (head - tail) >= total) {
+            auto record = bytes + offset;
+            if (needed > contiguous) {
+                store_u32(record, PaddingRecord);
+                record = bytes;
+            }
+            store_u32(record, size);
+            next_head = head + total;
+            return record + RecordHeaderSize;
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return nullptr;
+        }
+        futex_wait(header->tail, tail, remaining(deadline));
+    }
+}
+
+void ShmRing::end_write() {
+    header->head.store(next_head, std::memory_order_release);
+    futex_wake_all(header->head);
+}
+
+std::span<const std::byte> ShmRing::begin_read(std::chrono::milliseconds timeout) {
+    const auto capacity = header->capacity;
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true) {
+        auto tail = header->tail.load(std::memory_order_relaxed);
+        const auto head = header->head.load(std::memory_order_acquire);
+        if (head == tail) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return {};
+            }
+            futex_wait(header->head, head, remaining(deadline));
+            continue;
+        }
+
+        auto offset = tail & (capacity - 1);
+        auto size = load_u32(bytes + offset);
+        if (size == PaddingRecord) {
+            tail += capacity - offset;
+            offset = 0;
+            size = load_u32(bytes);
+        }
+
+        next_tail = tail + align_up(RecordHeaderSize + size, RecordAlignment);
+        return {bytes + offset + RecordHeaderSize, size};
+    }
+}
+
+void ShmRing::end_read() {
+    header->tail.store(next_tail, std::memory_order_release);
+    futex_wake_all(header->tail);
+}
+
+
+static size_t channel_size(uint32_t ring_capacity) {
+    return align_up(sizeof(ShmChannelHeader), 64) + 2 * static_cast<size_t>(ring_capacity);
+}
+
+static void attach_rings(ShmChannel *channel) {
+    auto header = reinterpret_cast<ShmChannelHeader *>(channel->memory.data);
+    auto rings = channel->memory.data + align_up(sizeof(ShmChannelHeader), 64);
+
+    channel->header = header;
+    channel->requests.header = &header->requests;
+    channel->requests.bytes = rings;
+    channel->responses.header = &header->responses;
+    channel->responses.bytes = rings + header->requests.capacity;
+}
+
+bool create_channel(ShmChannel *channel, const std::string &name, uint32_t ring_capacity) {
+    ring_capacity = std::bit_ceil(std::max(ring_capacity, 4 * RecordAlignment));
+    if (!create_shared_memory(&channel->memory, name, channel_size(ring_capacity))) {
+        return false;
+    }
+
+    auto header = new(channel->memory.data) ShmChannelHeader{};
+    header->state.store(static_cast<uint32_t>(ChannelState::Idle));
+    header->requests.capacity = ring_capacity;
+    header->responses.capacity = ring_capacity;
+    attach_rings(channel);
+
+    header->magic.store(ChannelMagic, std::memory_order_release);
+    return true;
+}
+
+bool open_channel(ShmChannel *channel, const std::string &name, uint32_t ring_capacity) {
+    ring_capacity = std::bit_ceil(std::max(ring_capacity, 4 * RecordAlignment));
+    if (!open_shared_memory(&channel->memory, name, channel_size(ring_capacity))) {
+        return false;
+    }
+
+    auto header = reinterpret_cast<ShmChannelHeader *>(channel->memory.data);
+    if (header->magic.load(std::memory_order_acquire) != ChannelMagic || header->requests.capacity != ring_capacity) {
+        channel->memory = SharedMemory{};
+        return false;
+    }
+    attach_rings(channel);
+    return true;
+}
+
+
+RemoteWorker::~RemoteWorker() {
+    stop();
+}
+
+bool RemoteWorker::call(const FuncId &func_id, std::span<const Value> inputs, std::span<Value> outputs) {
+    std::lock_guard lock(mutex);
+    if (!alive || !std::ranges::all_of(inputs, is_encodable)) {
+        return false;
+    }
+
+    const auto request_size = RecordAlignment + encoded_size(inputs);
+    if (request_size > channel.requests.max_message_size()) {
+        return false;
+    }
+    auto request = channel.requests.begin_write(static_cast<uint32_t>(request_size), timeout);
+    if (request == nullptr) {
+        alive = false;
+        return false;
+    }
+    std::memcpy(request, func_id.as_bytes().data(), 16);
+    encode_values(inputs, request + RecordAlignment);
+    channel.requests.end_write();
+
+    auto response = channel.responses.begin_read(timeout);
+    if (response.empty()) {
+        alive = false;
+        return false;
+    }
+
+    std::vector<Value> values;
+    const bool ok = load_u32(response.data()) != 0 && decode_values(response.subspan(RecordAlignment), values, false);
+    channel.responses.end_read();
+    if (!ok || values.size() != outputs.size()) {
+        return false;
+    }
+    std::ranges::move(values, outputs.begin());
+    return true;
+}
+
+void RemoteWorker::stop() {
+    if (channel.header == nullptr) {
+        return;
+    }
+    channel.header->state.store(static_cast<uint32_t>(ChannelState::Stopping), std::memory_order_release);
+    futex_wake_all(channel.header->requests.head);
+}
+
+bool create_remote_worker(RemoteWorker *worker, const std::string &name, uint32_t ring_capacity) {
+    return create_channel(&worker->channel, name, ring_capacity);
+}
+
+void serve_remote_worker(ShmChannel &channel, const FuncLib &lib) {
+    const auto poll = std::chrono::milliseconds(100);
+    auto stopping = [&channel] {
+        return channel.header->state.load(std::memory_order_acquire) == static_cast<uint32_t>(ChannelState::Stopping);
+    };
+
+    channel.header->state.store(static_cast<uint32_t>(ChannelState::Running), std::memory_order_release);
+    while (!stopping()) {
+        auto request = channel.requests.begin_read(poll);
+        if (request.empty()) {
+            continue;
+        }
+
+        // inputs stay in the request ring and tensors point straight into it until end_read()
+        const auto bytes = reinterpret_cast<const uint8_t *>(request.data());
+        const FuncId func_id{bytes, bytes + 16};
+        std::vector<Value> inputs;
+        const auto *func = lib.find(func_id);
+        bool ok = func != nullptr && (func->lambda || func->fallible_lambda)
+                  && decode_values(request.subspan(RecordAlignment), inputs, true);
+
+        NodeOutputs outputs(func != nullptr ? func->output_count() : 0);
+        if (ok && func->fallible_lambda) {
+            ok = func->fallible_lambda(inputs, outputs);
+        } else if (ok) {
+            func->lambda(inputs, outputs);
+        }
+
+        // outputs that cannot be encoded would arrive as empty values, fail the call instead
+        auto response_size = RecordAlignment + encoded_size(outputs);
+        if (!ok || !std::ranges::all_of(outputs, is_encodable) || response_size > channel.responses.max_message_size()) {
+            ok = false;
+            outputs.clear();
+            response_size = RecordAlignment + encoded_size(outputs);
+        }
+
+        std::byte *response = nullptr;
+        while (response == nullptr && !stopping()) {
+            response = channel.responses.begin_write(static_cast<uint32_t>(response_size), poll);
+        }
+        if (response != nullptr) {
+            std::memset(response, 0, RecordAlignment);
+            store_u32(response, ok ? 1 : 0);
+            encode_values(outputs, response + RecordAlignment);
+            channel.responses.end_write();
+        }
+
+        outputs.clear();
+        inputs.clear();
+        channel.requests.end_read();
+    }
+}
+
+bool offload_funcs(FuncLib &lib, std::span<const FuncId> func_ids, RemoteWorker &worker) {
+    auto offloaded = [&func_ids](const Func &func) {
+        return func.behavior == FuncBehavior::Impure && std::ranges::find(func_ids, func.id) != func_ids.end();
+    };
+    for (const auto &func: lib.funcs) {
+        if (offloaded(func) && (func.is_streaming() || func.subgraph != nullptr
+                                || !std::ranges::all_of(func.args, is_encodable_datatype, &FuncArg::datatype))) {
+            return false;
+        }
+    }
+
+    for (auto &func: lib.funcs) {
+        if (!offloaded(func)) {
+            continue;
+        }
+        func.lambda = {};
+        func.fallible_lambda = [&worker, id = func.id](std::span<const Value> inputs, std::span<Value> outputs) {
+            return worker.call(id, inputs, outputs);
+        };
+    }
+    return true;
+}
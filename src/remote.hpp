@@ -0,0 +1,110 @@
+#pragma once
+
+#include "func.hpp"
+#include "value.hpp"
+
+#include "utils/nocopy.hpp"
+#include "utils/shared_memory.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+
+// Single-producer single-consumer ring of length-prefixed messages inside shared memory.
+// head and tail count bytes ever written and consumed; both double as futex words, the
+// consumer sleeps on head and the producer on tail. Messages never wrap: when one does not
+// fit before the end a padding record sends both sides back to offset 0, so a message is
+// always contiguous and can be read in place.
+struct ShmRingHeader {
+    alignas(64) std::atomic<uint32_t> head;
+    alignas(64) std::atomic<uint32_t> tail;
+    uint32_t capacity;
+};
+
+struct ShmRing {
+    ShmRingHeader *header = nullptr;
+    std::byte *bytes = nullptr;
+    uint32_t next_head = 0; // published by end_write()
+    uint32_t next_tail = 0; // published by end_read()
+
+    // largest message that is guaranteed to fit
+    [[nodiscard]] uint32_t max_message_size() const;
+
+    // Reserves size contiguous bytes, blocking while the ring is full. Returns nullptr on timeout.
+    std::byte *begin_write(uint32_t size, std::chrono::milliseconds timeout);
+
+    void end_write();
+
+    // Blocks until a message is available. Returns an empty span on timeout; the span stays valid
+    // until end_read().
+    std::span<const std::byte> begin_read(std::chrono::milliseconds timeout);
+
+    void end_read();
+};
+
+
+enum class ChannelState : uint32_t {
+    Idle, Running, Stopping
+};
+
+struct ShmChannelHeader {
+    std::atomic<uint32_t> magic;
+    std::atomic<uint32_t> state;
+    ShmRingHeader requests;
+    ShmRingHeader responses;
+};
+
+// Request and response rings laid out in one shared memory region.
+struct ShmChannel {
+    SharedMemory memory;
+    ShmChannelHeader *header = nullptr;
+    ShmRing requests;
+    ShmRing responses;
+};
+
+// ring_capacity is rounded up to a power of two
+bool create_channel(ShmChannel *channel, const std::string &name, uint32_t ring_capacity);
+
+bool open_channel(ShmChannel *channel, const std::string &name, uint32_t ring_capacity);
+
+
+// Host side of a worker running the real func lambdas on the other end of a channel. One call
+// is in flight at a time; run several workers to execute funcs in parallel.
+struct RemoteWorker {
+    NOCOPY(RemoteWorker)
+
+    ShmChannel channel;
+    std::mutex mutex;
+    std::chrono::milliseconds timeout{5000};
+    bool alive = true;
+
+    RemoteWorker() = default;
+
+    ~RemoteWorker();
+
+    // Returns false if the worker did not answer in time, the worker is then considered dead
+    // and every later call fails immediately.
+    bool call(const FuncId &func_id, std::span<const Value> inputs, std::span<Value> outputs);
+
+    void stop();
+};
+
+// creates the channel the worker process opens with open_channel() under the same name
+bool create_remote_worker(RemoteWorker *worker, const std::string &name, uint32_t ring_capacity);
+
+// Serves requests on the channel with the lambdas from lib until the host calls stop().
+// This is the main loop of a worker process, or of a thread standing in for one.
+void serve_remote_worker(ShmChannel &channel, const FuncLib &lib);
+
+// Routes the lambdas of the listed Impure funcs in lib through the worker, which has to
+// outlive every run using lib. The worker side needs its own lib with the real lambdas. A call
+// that fails, or whose values turn out not to be encodable, fails its node with
+// RunResult::InvalidInput. Returns false and changes nothing if a listed func streams, is a
+// subgraph or has an arg of a datatype without an encoding (see encoding.hpp).
+bool offload_funcs(FuncLib &lib, std::span<const FuncId> func_ids, RemoteWorker &worker);
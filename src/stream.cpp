@@ -0,0 +1,66 @@
+#include "stream.hpp"
+
+#include <algorithm>
+
+
+StreamChannel::StreamChannel(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+bool StreamChannel::push(Value chunk) {
+    std::unique_lock lock(mutex);
+    writable.wait(lock, [this] { return abandoned || chunks.size() < capacity; });
+    if (abandoned) {
+        return false;
+    }
+    chunks.push_back(std::move(chunk));
+    lock.unlock();
+    readable.notify_one();
+    return true;
+}
+
+bool StreamChannel::pop(Value &chunk) {
+    std::unique_lock lock(mutex);
+    readable.wait(lock, [this] { return closed || !chunks.empty(); });
+    if (chunks.empty()) {
+        return false;
+    }
+    chunk = std::move(chunks.front());
+    chunks.pop_front();
+    lock.unlock();
+    writable.notify_one();
+    return true;
+}
+
+void StreamChannel::close() {
+    {
+        std::lock_guard lock(mutex);
+        closed = true;
+    }
+    readable.notify_all();
+}
+
+void StreamChannel::abandon() {
+    {
+        std::lock_guard lock(mutex);
+        abandoned = true;
+        chunks.clear();
+    }
+    writable.notify_all();
+}
+
+
+bool StreamReader::next(Value &chunk) {
+    return channel != nullptr && channel->pop(chunk);
+}
+
+
+bool StreamWriter::write(const Value &chunk) {
+    bool listened = false;
+    for (auto &channel: channels) {
+        if (channel != nullptr && channel->push(chunk)) {
+            listened = true;
+        } else {
+            channel = nullptr;
+        }
+    }
+    return listened;
+}
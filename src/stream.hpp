@@ -0,0 +1,66 @@
+#pragma once
+
+#include "value.hpp"
+
+#include "utils/nocopy.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <vector>
+
+
+// Bounded queue of chunks between one writer and one reader. A full channel blocks the writer,
+// which is what keeps a fast producer from running ahead of a slow consumer.
+struct StreamChannel {
+    NOCOPY(StreamChannel)
+
+    std::mutex mutex;
+    std::condition_variable readable;
+    std::condition_variable writable;
+    std::deque<Value> chunks;
+    size_t capacity;
+    bool closed = false;    // the writer is done
+    bool abandoned = false; // the reader is done, further chunks are dropped
+
+    explicit StreamChannel(size_t capacity);
+
+    // blocks while the channel is full, returns false once the reader is gone
+    bool push(Value chunk);
+
+    // blocks while the channel is empty, returns false once it is closed and drained
+    bool pop(Value &chunk);
+
+    void close();
+
+    void abandon();
+};
+
+
+// Reading end of a streaming In arg, an unbound arg reads as an empty stream.
+struct StreamReader {
+    StreamChannel *channel = nullptr;
+
+    bool next(Value &chunk);
+};
+
+// Writing end of a streaming Out arg, every chunk goes to each consumer of the arg.
+struct StreamWriter {
+    std::vector<StreamChannel *> channels;
+
+    // returns false once no consumer reads anymore, the stage may stop producing then
+    bool write(const Value &chunk);
+};
+
+
+// inputs and outputs follow the non-streaming In and Out args, readers and writers the streaming
+// ones, each in declaration order. Streams are closed when the lambda returns.
+using StreamLambda = std::function<void(
+        std::span<const Value> inputs,
+        std::span<StreamReader> readers,
+        std::span<Value> outputs,
+        std::span<StreamWriter> writers
+)>;
@@ -0,0 +1,235 @@
+#include "subgraph.hpp"
+
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+
+// nesting deeper than this is left to separate compilation, see prepare_subgraph() for recursion
+static constexpr uint32_t MaxInlineDepth = 16;
+
+
+// Whether a subgraph called from subgraph, or subgraph itself, calls one that is already on path.
+// Funcs are looked up in lib like compile_plan() does, done holds subgraphs known to be free of
+// recursion.
+static bool reaches_recursion(
+        const Subgraph &subgraph,
+        const FuncLib &lib,
+        std::vector<const Subgraph *> &path,
+        std::vector<const Subgraph *> &done
+) {
+    if (std::ranges::find(path, &subgraph) != path.end()) {
+        return true;
+    }
+    if (std::ranges::find(done, &subgraph) != done.end()) {
+        return false;
+    }
+    path.push_back(&subgraph);
+    for (const auto &node: subgraph.graph.nodes) {
+        const auto *func = lib.find(node.func_id);
+        if (func != nullptr && func->subgraph != nullptr && reaches_recursion(*func->subgraph, lib, path, done)) {
+            return true;
+        }
+    }
+    path.pop_back();
+    done.push_back(&subgraph);
+    return false;
+}
+
+
+Func make_subgraph_func(
+        std::string name,
+        Graph graph,
+        std::vector<FuncArg> args,
+        std::vector<std::vector<SubgraphInput>> inputs,
+        std::vector<SubgraphOutput> outputs
+) {
+    auto subgraph = std::make_shared<Subgraph>();
+
+    for (const auto &ports: inputs) {
+        for (const auto &port: ports) {
+            for (auto &node: graph.nodes) {
+                if (node.id == port.node_id && port.arg_idx < node.inputs.size()) {
+                    node.inputs[port.arg_idx].binding = BindingType::Const;
+                    node.inputs[port.arg_idx].value = Value{};
+                }
+            }
+        }
+    }
+    for (const auto &port: outputs) {
+        for (auto &node: graph.nodes) {
+            if (node.id == port.node_id) {
+                node.is_output = true;
+            }
+        }
+    }
+
+    subgraph->forward.name = name + ".forward";
+    subgraph->forward.behavior = FuncBehavior::Pure;
+    for (const auto &arg: args) {
+        if (arg.type == FuncArgType::Out) {
+            subgraph->forward.args.push_back(FuncArg{arg.name, arg.datatype, false, FuncArgType::In});
+        }
+    }
+    for (const auto &arg: args) {
+        if (arg.type == FuncArgType::Out) {
+            subgraph->forward.args.push_back(arg);
+        }
+    }
+    subgraph->forward.lambda = [](std::span<const Value> inputs, std::span<Value> outputs) {
+        std::ranges::copy(inputs, outputs.begin());
+    };
+
+    subgraph->graph = std::move(graph);
+    subgraph->inputs = std::move(inputs);
+    subgraph->outputs = std::move(outputs);
+
+    Func func{};
+    func.name = std::move(name);
+    func.args = std::move(args);
+    func.subgraph = std::move(subgraph);
+    return func;
+}
+
+RunResult prepare_subgraph(Subgraph &subgraph, const FuncLib &lib, const CompileOptions &options) {
+    std::call_once(subgraph.compile_once, [&] {
+        // compiling a recursive subgraph would come back here for the same flag, checking the
+        // calls up front keeps compile_plan() from ever re-entering call_once
+        std::vector<const Subgraph *> path;
+        std::vector<const Subgraph *> done;
+        if (reaches_recursion(subgraph, lib, path, done)) {
+            subgraph.compile_result = RunResult::RecursiveSubgraph;
+            return;
+        }
+
+        auto plan = std::make_shared<GraphPlan>();
+        subgraph.compile_result = compile_plan(subgraph.graph, lib, *plan, options);
+        if (subgraph.compile_result != RunResult::Ok) {
+            return;
+        }
+
+        // streams need every stage running at once, which only the caller's plan can provide
+        for (const auto *func: plan->funcs) {
+            if (func != nullptr && func->is_streaming()) {
+                subgraph.compile_result = RunResult::StreamMismatch;
+                return;
+            }
+        }
+
+        std::unordered_map<NodeId, uint32_t, UuidHash> node_indices;
+        for (uint32_t i = 0; i < subgraph.graph.nodes.size(); ++i) {
+            node_indices.emplace(subgraph.graph.nodes[i].id, i);
+        }
+
+        for (const auto &ports: subgraph.inputs) {
+            auto &sources = subgraph.input_sources.emplace_back();
+            for (const auto &port: ports) {
+                auto it = node_indices.find(port.node_id);
+                if (it == node_indices.end() || plan->funcs[it->second] == nullptr) {
+                    continue;
+                }
+                // the port is the n-th In arg of the node, sources follow In args
+                const auto &args = plan->funcs[it->second]->args;
+                const auto in_idx = std::count_if(args.begin(), args.begin() + port.arg_idx, [](const FuncArg &arg) {
+                    return arg.type == FuncArgType::In;
+                });
+                sources.push_back(plan->source_offsets[it->second] + static_cast<uint32_t>(in_idx));
+            }
+        }
+
+        for (const auto &port: subgraph.outputs) {
+            auto it = node_indices.find(port.node_id);
+            if (it == node_indices.end()) {
+                subgraph.compile_result = RunResult::UnboundInput;
+                return;
+            }
+            subgraph.output_slots.emplace_back(it->second, port.output_idx);
+        }
+
+        subgraph.plan = std::move(plan);
+    });
+    return subgraph.compile_result;
+}
+
+bool inline_subgraphs(
+        const Graph &graph,
+        const FuncLib &lib,
+        const CompileOptions &options,
+        Graph &flat,
+        std::vector<const Func *> &forwards
+) {
+    auto inlinable = [&](const Func *func) {
+        return func != nullptr && func->subgraph != nullptr
+               && func->subgraph->graph.nodes.size() <= options.max_inline_nodes;
+    };
+    if (std::ranges::none_of(graph.nodes, [&](const Node &node) { return inlinable(lib.find(node.func_id)); })) {
+        return false;
+    }
+
+    flat.nodes = graph.nodes;
+    forwards.assign(flat.nodes.size(), nullptr);
+    std::vector<uint32_t> depths(flat.nodes.size(), 0);
+
+    // inlined nodes are appended, so the loop reaches nested calls as well
+    for (size_t call_idx = 0; call_idx < flat.nodes.size(); ++call_idx) {
+        const auto *func = lib.find(flat.nodes[call_idx].func_id);
+        if (!inlinable(func) || depths[call_idx] >= MaxInlineDepth) {
+            continue;
+        }
+        const auto &subgraph = *func->subgraph;
+        const auto call = flat.nodes[call_idx];
+
+        std::unordered_map<NodeId, NodeId, UuidHash> renamed;
+        for (const auto &inner: subgraph.graph.nodes) {
+            renamed.emplace(inner.id, generate_uuid());
+        }
+
+        const auto first_inner = flat.nodes.size();
+        for (const auto &inner: subgraph.graph.nodes) {
+            auto &node = flat.nodes.emplace_back(inner);
+            node.id = renamed.at(inner.id);
+            node.is_output = false;
+            for (auto &input: node.inputs) {
+                if (input.binding != BindingType::Binding) {
+                    continue;
+                }
+                if (auto it = renamed.find(input.output_node_id); it != renamed.end()) {
+                    input.output_node_id = it->second;
+                }
+            }
+        }
+        forwards.resize(flat.nodes.size(), nullptr);
+        depths.resize(flat.nodes.size(), depths[call_idx] + 1);
+
+        // ports take over whatever the call had bound to the In arg
+        uint32_t in_idx = 0;
+        for (size_t arg_idx = 0; arg_idx < func->args.size(); ++arg_idx) {
+            if (func->args[arg_idx].type != FuncArgType::In) {
+                continue;
+            }
+            const auto &binding = arg_idx < call.inputs.size() ? call.inputs[arg_idx] : NodeInput{};
+            for (const auto &port: subgraph.inputs[in_idx]) {
+                for (auto i = first_inner; i < flat.nodes.size(); ++i) {
+                    if (flat.nodes[i].id == renamed.at(port.node_id)) {
+                        flat.nodes[i].inputs[port.arg_idx] = binding;
+                    }
+                }
+            }
+            ++in_idx;
+        }
+
+        // the call itself forwards the exposed outputs, consumers of the call stay as they are
+        auto &forward_node = flat.nodes[call_idx];
+        forward_node.func_id = subgraph.forward.id;
+        forward_node.inputs.assign(subgraph.forward.args.size(), NodeInput{});
+        for (size_t i = 0; i < subgraph.outputs.size(); ++i) {
+            auto &input = forward_node.inputs[i];
+            input.binding = BindingType::Binding;
+            input.output_node_id = renamed.at(subgraph.outputs[i].node_id);
+            input.output_idx = subgraph.outputs[i].output_idx;
+        }
+        forwards[call_idx] = &subgraph.forward;
+    }
+    return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "func.hpp"
+#include "graph.hpp"
+#include "plan.hpp"
+
+#include "utils/nocopy.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// Inner node input an In arg of a subgraph func feeds. The node has to be of a plain func, not
+// of another subgraph func.
+struct SubgraphInput {
+    NodeId node_id{};
+    uint32_t arg_idx = 0; // into the inputs of the inner node, like NodeInput
+};
+
+// Inner node output an Out arg of a subgraph func exposes.
+struct SubgraphOutput {
+    NodeId node_id{};
+    uint32_t output_idx = 0;
+};
+
+// Graph behind a subgraph func. compile_plan() inlines calls to small subgraphs into the caller's
+// plan, so the optimizer and the scheduler see through them; larger ones are compiled once into
+// a plan shared by every call site and evaluated by the worker that runs the call. Inner funcs
+// are looked up in the lib the caller is compiled with.
+struct Subgraph {
+    NOCOPY(Subgraph)
+
+    Graph graph;
+    std::vector<std::vector<SubgraphInput>> inputs; // per In arg of the func
+    std::vector<SubgraphOutput> outputs;            // per Out arg of the func
+
+    // identity from the exposed outputs to the outputs of the call, stands in for inlined calls
+    Func forward;
+
+    // separate compilation, done by the first compile_plan() that needs it
+    std::once_flag compile_once;
+    RunResult compile_result = RunResult::Ok;
+    std::shared_ptr<GraphPlan> plan;
+    std::vector<std::vector<uint32_t>> input_sources;           // per In arg, plan source indices
+    std::vector<std::pair<uint32_t, uint32_t>> output_slots;    // per Out arg, node and output
+
+    Subgraph() = default;
+};
+
+// Builds a func that evaluates graph. args declare the func like any other, inputs and outputs
+// follow its In and Out args. Port inputs are rebound to Const placeholders and port nodes marked
+// as outputs of the graph. Behavior stays Impure unless the caller knows every inner func is Pure.
+Func make_subgraph_func(
+        std::string name,
+        Graph graph,
+        std::vector<FuncArg> args,
+        std::vector<std::vector<SubgraphInput>> inputs,
+        std::vector<SubgraphOutput> outputs
+);
+
+// Compiles the shared plan of a subgraph that is not inlined, once. Called by compile_plan().
+RunResult prepare_subgraph(Subgraph &subgraph, const FuncLib &lib, const CompileOptions &options);
+
+// Copies graph with every call to a subgraph of at most options.max_inline_nodes nodes expanded
+// in place, recursively. Calls keep their index but become forward nodes, listed in forwards by
+// node index; the inlined nodes are appended. Inputs of a call move to the port inputs they feed,
+// so Const overrides of an inlined call go to the inner nodes. Returns false if there was nothing
+// to inline.
+bool inline_subgraphs(
+        const Graph &graph,
+        const FuncLib &lib,
+        const CompileOptions &options,
+        Graph &flat,
+        std::vector<const Func *> &forwards
+);
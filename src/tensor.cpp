@@ -0,0 +1,167 @@
+#include "tensor.hpp"
+
+#include "utils/utils.hpp"
+
+#include <cstring>
+#include <new>
+
+
+static std::shared_ptr<std::byte> allocate_elements(const Datatype &type, size_t count, bool construct) {
+    auto alignment = std::align_val_t{type.alignment};
+    auto data = static_cast<std::byte *>(::operator new(std::max<size_t>(1, count * type.size), alignment));
+
+    if (construct) {
+        for (size_t i = 0; i < count; ++i) {
+            type.ops.construct(data + i * type.size);
+        }
+    }
+
+    return {data, [&type, count, alignment](std::byte *elements) {
+        if (!type.trivial) {
+            for (size_t i = 0; i < count; ++i) {
+                type.ops.destroy(elements + i * type.size);
+            }
+        }
+        ::operator delete(elements, alignment);
+    }};
+}
+
+
+Tensor::Tensor(DatatypeId element, std::vector<uint32_t> shape) : element(element), shape(std::move(shape)) {
+    storage = allocate_elements(get_datatype(element), element_count(), true);
+}
+
+Tensor Tensor::uninitialized(DatatypeId element, std::vector<uint32_t> shape) {
+    const auto &type = get_datatype(element);
+    assert(type.trivial);
+
+    Tensor tensor{};
+    tensor.element = element;
+    tensor.shape = std::move(shape);
+    tensor.storage = allocate_elements(type, tensor.element_count(), false);
+    return tensor;
+}
+
+size_t Tensor::element_count() const {
+    if (element == DatatypeNone) {
+        return 0;
+    }
+    size_t count = 1;
+    for (const auto extent: shape) {
+        count *= extent;
+    }
+    return count;
+}
+
+size_t Tensor::byte_size() const {
+    return element_count() * get_datatype(element).size;
+}
+
+
+bool operator==(const Tensor &lhs, const Tensor &rhs) {
+    if (lhs.element != rhs.element || lhs.shape != rhs.shape) {
+        return false;
+    }
+    if (lhs.storage == rhs.storage) {
+        return true;
+    }
+
+    const auto &type = get_datatype(lhs.element);
+    if (type.trivial) {
+        return std::memcmp(lhs.data(), rhs.data(), lhs.byte_size()) == 0;
+    }
+    const auto count = lhs.element_count();
+    for (size_t i = 0; i < count; ++i) {
+        if (!type.ops.equal(lhs.data() + i * type.size, rhs.data() + i * type.size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t hash_tensor(const Tensor &tensor) {
+    uint64_t hash = hash_combine(0xcbf29ce484222325ull, tensor.element);
+    for (const auto extent: tensor.shape) {
+        hash = hash_combine(hash, extent);
+    }
+    if (tensor.element == DatatypeNone) {
+        return hash;
+    }
+
+    const auto &type = get_datatype(tensor.element);
+    const auto count = tensor.element_count();
+    constexpr size_t batch = 256;
+    uint64_t hashes[batch];
+    for (size_t begin = 0; begin < count; begin += batch) {
+        const auto size = std::min(batch, count - begin);
+        hash_values(type, tensor.data() + begin * type.size, size, hashes);
+        for (size_t i = 0; i < size; ++i) {
+            hash = hash_combine(hash, hashes[i]);
+        }
+    }
+    return hash;
+}
+
+YAML::Emitter &operator<<(YAML::Emitter &out, const Tensor &tensor) {
+    out << YAML::BeginMap;
+    out << YAML::Key << "element" << YAML::Value << tensor.element;
+    out << YAML::Key << "shape" << YAML::Value << YAML::Flow << tensor.shape;
+
+    out << YAML::Key << "data" << YAML::Value;
+    const auto &type = get_datatype(tensor.element);
+    if (type.ops.emit != nullptr) {
+        out << YAML::Flow << YAML::BeginSeq;
+        for (size_t i = 0; i < tensor.element_count(); ++i) {
+            type.ops.emit(out, tensor.data() + i * type.size);
+        }
+        out << YAML::EndSeq;
+    } else {
+        assert(type.trivial);
+        out << YAML::Binary(reinterpret_cast<const unsigned char *>(tensor.data()), tensor.byte_size());
+    }
+
+    out << YAML::EndMap;
+    return out;
+}
+
+bool parse_tensor(const YAML::Node &node, Tensor &tensor) {
+    if (!node.IsMap() || !node["element"] || !node["shape"] || !node["data"]) {
+        return false;
+    }
+    const auto element = node["element"].as<DatatypeId>(DatatypeNone);
+    if (element == DatatypeNone || !datatype_registry().contains(element) || !node["shape"].IsSequence()) {
+        return false;
+    }
+    const auto shape = node["shape"].as<std::vector<uint32_t>>();
+    const auto &type = get_datatype(element);
+    const auto &data = node["data"];
+
+    if (data.IsSequence()) {
+        if (type.ops.parse == nullptr) {
+            return false;
+        }
+        Tensor parsed{element, shape};
+        if (data.size() != parsed.element_count()) {
+            return false;
+        }
+        for (size_t i = 0; i < data.size(); ++i) {
+            if (!type.ops.parse(data[i], parsed.mutable_data() + i * type.size)) {
+                return false;
+            }
+        }
+        tensor = std::move(parsed);
+        return true;
+    }
+
+    if (!type.trivial || !data.IsScalar()) {
+        return false;
+    }
+    auto parsed = Tensor::uninitialized(element, shape);
+    const auto bytes = YAML::DecodeBase64(data.Scalar());
+    if (bytes.size() != parsed.byte_size()) {
+        return false;
+    }
+    std::memcpy(parsed.mutable_data(), bytes.data(), bytes.size());
+    tensor = std::move(parsed);
+    return true;
+}
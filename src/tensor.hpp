@@ -0,0 +1,103 @@
+#pragma once
+
+#include "datatype.hpp"
+
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+
+// Dense row-major array of values of a registered element datatype, arrays are 1-D tensors.
+// Copies share the element buffer, so passing a tensor along graph edges never copies the data;
+// writes through mutable_data() are only allowed before the tensor is handed to anyone else.
+struct Tensor {
+    DatatypeId element = DatatypeNone;
+    std::vector<uint32_t> shape;
+    std::shared_ptr<std::byte> storage;
+
+    Tensor() = default;
+
+    // elements are default constructed
+    Tensor(DatatypeId element, std::vector<uint32_t> shape);
+
+    // trivial element datatypes only, elements are left uninitialized
+    static Tensor uninitialized(DatatypeId element, std::vector<uint32_t> shape);
+
+    [[nodiscard]] size_t element_count() const;
+
+    [[nodiscard]] size_t byte_size() const;
+
+    [[nodiscard]] const std::byte *data() const { return storage.get(); }
+
+    [[nodiscard]] std::byte *mutable_data() { return storage.get(); }
+
+    template<typename T>
+    [[nodiscard]] std::span<const T> as() const {
+        assert(get_datatype(element).size == sizeof(T));
+        return {reinterpret_cast<const T *>(data()), element_count()};
+    }
+
+    template<typename T>
+    [[nodiscard]] std::span<T> as_mutable() {
+        assert(get_datatype(element).size == sizeof(T));
+        return {reinterpret_cast<T *>(mutable_data()), element_count()};
+    }
+};
+
+template<typename T>
+Tensor make_array(DatatypeId element, std::span<const T> values) {
+    auto tensor = Tensor{element, {static_cast<uint32_t>(values.size())}};
+    std::ranges::copy(values, tensor.as_mutable<T>().begin());
+    return tensor;
+}
+
+bool operator==(const Tensor &lhs, const Tensor &rhs);
+
+uint64_t hash_tensor(const Tensor &tensor);
+
+YAML::Emitter &operator<<(YAML::Emitter &out, const Tensor &tensor);
+
+// reads what operator<< wrote, so Tensor values can be parsed like any other datatype
+bool parse_tensor(const YAML::Node &node, Tensor &tensor);
+
+template<>
+struct YAML::convert<Tensor> {
+    static bool decode(const Node &node, Tensor &tensor) {
+        return parse_tensor(node, tensor);
+    }
+};
+
+template<>
+struct std::hash<Tensor> {
+    size_t operator()(const Tensor &tensor) const noexcept {
+        return static_cast<size_t>(hash_tensor(tensor));
+    }
+};
+
+
+// Processes count consecutive elements of one chunk. inputs[i] points at the first element of
+// In arg i within the chunk, or at the value itself for non-tensor inputs, which are broadcast.
+// outputs[i] points at the first element of Out arg i within the chunk and trivial elements
+// start uninitialized, every element has to be written.
+using ElementwiseLambda = std::function<void(
+        std::span<const void *const> inputs,
+        std::span<void *const> outputs,
+        size_t count
+)>;
+
+// A Pure func declaring itself element-wise is run over chunks of its tensor inputs in parallel.
+// At least one input has to be a tensor and all tensor inputs must share one shape, outputs are
+// tensors of that shape. A node whose inputs do not match the declaration fails the run with
+// RunResult::InvalidInput. Outputs are not cached, hashing the tensors costs about as much as
+// running the func.
+struct ElementwiseFunc {
+    ElementwiseLambda lambda;
+    std::vector<DatatypeId> input_elements;  // per In arg, element datatype of the tensor or of the broadcast value
+    std::vector<DatatypeId> output_elements; // element datatype per Out arg
+};
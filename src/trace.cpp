@@ -0,0 +1,153 @@
+#include "trace.hpp"
+
+#include "encoding.hpp"
+
+#include "utils/utils.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+
+static constexpr uint32_t TraceMagic = 0x45435254; // "TRCE"
+static constexpr uint32_t TraceVersion = 2;
+static constexpr uint32_t TraceHeaderSize = 32;
+static constexpr uint32_t RecordHeaderSize = 16;
+
+
+void Trace::begin_run(const GraphPlan &plan) {
+    if (mode == TraceMode::Replay) {
+        // a trace of a different graph replays nothing
+        const bool same = plan.node_count == node_count && plan_fingerprint(plan) == fingerprint;
+        run = same ? replayed++ : run_count;
+        return;
+    }
+
+    if (bytes.empty()) {
+        node_count = plan.node_count;
+        fingerprint = plan_fingerprint(plan);
+        bytes.resize(TraceHeaderSize);
+        std::memset(bytes.data(), 0, TraceHeaderSize);
+        store_u32(bytes.data(), TraceMagic);
+        store_u32(bytes.data() + 4, TraceVersion);
+        store_u32(bytes.data() + 8, node_count);
+        std::memcpy(bytes.data() + 16, &fingerprint, sizeof(fingerprint));
+    }
+    run = run_count++;
+}
+
+void Trace::record(uint32_t node_idx, std::span<const Value> outputs) {
+    // encoded as empty they would replay as if the node had produced nothing, records store
+    // their size in 32 bits
+    if (!std::ranges::all_of(outputs, is_encodable)) {
+        ++unrecorded;
+        return;
+    }
+
+    const auto payload_size = encoded_size(outputs);
+    if (payload_size > std::numeric_limits<uint32_t>::max()) {
+        ++unrecorded;
+        return;
+    }
+
+    std::lock_guard lock(mutex);
+    const auto offset = bytes.size();
+    bytes.resize(offset + RecordHeaderSize + payload_size);
+    auto record = bytes.data() + offset;
+    std::memset(record, 0, RecordHeaderSize);
+    store_u32(record, run);
+    store_u32(record + 4, node_idx);
+    store_u32(record + 8, static_cast<uint32_t>(payload_size));
+    encode_values(outputs, record + RecordHeaderSize);
+}
+
+bool Trace::replay(uint32_t node_idx, std::span<Value> outputs) {
+    const auto index = static_cast<size_t>(run) * node_count + node_idx;
+    if (run >= run_count || node_idx >= node_count || offsets[index] == 0) {
+        ++misses;
+        return false;
+    }
+
+    const auto record = bytes.data() + offsets[index];
+    const auto payload = std::span<const std::byte>(record + RecordHeaderSize, load_u32(record + 8));
+    std::vector<Value> values;
+    if (!decode_values(payload, values, false) || values.size() != outputs.size()) {
+        ++misses;
+        return false;
+    }
+    std::ranges::move(values, outputs.begin());
+    return true;
+}
+
+
+uint64_t plan_fingerprint(const GraphPlan &plan) {
+    uint64_t hash = hash_combine(0, plan.node_count);
+    for (uint32_t node_idx = 0; node_idx < plan.node_count; ++node_idx) {
+        const auto *func = plan.funcs[node_idx];
+        hash = hash_combine(hash, func != nullptr ? hash_uuid(func->id) : 0);
+        for (auto source_idx = plan.source_offsets[node_idx]; source_idx < plan.source_offsets[node_idx + 1]; ++source_idx) {
+            const auto &source = plan.sources[source_idx];
+            hash = hash_combine(hash, static_cast<uint64_t>(source.binding));
+            if (source.binding == BindingType::Binding) {
+                hash = hash_combine(hash, (static_cast<uint64_t>(source.node_idx) << 32) | source.output_idx);
+            }
+        }
+    }
+    return hash;
+}
+
+
+bool save_trace(const Trace &trace, const std::string &path) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(trace.bytes.data()), static_cast<std::streamsize>(trace.bytes.size()));
+    return file.good();
+}
+
+bool load_trace(Trace *trace, const std::string &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    std::vector<std::byte> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file || bytes.size() < TraceHeaderSize
+        || load_u32(bytes.data()) != TraceMagic || load_u32(bytes.data() + 4) != TraceVersion) {
+        return false;
+    }
+    const auto node_count = load_u32(bytes.data() + 8);
+    uint64_t fingerprint = 0;
+    std::memcpy(&fingerprint, bytes.data() + 16, sizeof(fingerprint));
+
+    // records are in completion order, index them by run and node
+    uint32_t run_count = 0;
+    std::vector<size_t> offsets;
+    for (size_t offset = TraceHeaderSize; offset < bytes.size();) {
+        if (offset + RecordHeaderSize > bytes.size()) {
+            return false;
+        }
+        const auto run = load_u32(bytes.data() + offset);
+        const auto node_idx = load_u32(bytes.data() + offset + 4);
+        const auto payload_size = load_u32(bytes.data() + offset + 8);
+        if (node_idx >= node_count || offset + RecordHeaderSize + payload_size > bytes.size()) {
+            return false;
+        }
+        if (run >= run_count) {
+            run_count = run + 1;
+            offsets.resize(static_cast<size_t>(run_count) * node_count, 0);
+        }
+        offsets[static_cast<size_t>(run) * node_count + node_idx] = offset;
+        offset += RecordHeaderSize + payload_size;
+    }
+
+    trace->mode = TraceMode::Replay;
+    trace->node_count = node_count;
+    trace->fingerprint = fingerprint;
+    trace->run_count = run_count;
+    trace->replayed = 0;
+    trace->run = 0;
+    trace->bytes = std::move(bytes);
+    trace->offsets = std::move(offsets);
+    trace->misses = 0;
+    return true;
+}
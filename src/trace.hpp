@@ -0,0 +1,67 @@
+#pragma once
+
+#include "plan.hpp"
+#include "value.hpp"
+
+#include "utils/nocopy.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+
+enum class TraceMode : uint8_t {
+    Record, // Impure funcs are called and their outputs appended to the trace
+    Replay, // Impure funcs are not called, their outputs come from the trace
+};
+
+// Outputs of the Impure nodes of one GraphInstance over a sequence of runs. Attached to an
+// instance, every run of it records or replays the next run of the trace; Pure nodes are always
+// evaluated, so replay reproduces them bit-exactly from the recorded inputs. Only nodes that
+// produced their outputs are recorded. Outputs of streaming nodes are not part of a trace, and
+// neither are outputs that have no encoding (see encoding.hpp): such a node is left out of its
+// run. A trace only replays into plans with the fingerprint it was recorded with, anything else
+// misses every node. A node that misses on replay fails the run with RunResult::InvalidInput
+// and its consumers are skipped.
+//
+// Stored as a 32 byte header (magic, version, node count, padding, fingerprint, padding)
+// followed by one record per node and run: run, node index, payload size, padding, then the
+// outputs in the encoding of encoding.hpp.
+struct Trace {
+    NOCOPY(Trace)
+
+    TraceMode mode = TraceMode::Record;
+    uint32_t node_count = 0;
+    uint64_t fingerprint = 0;  // of the plan recorded
+    uint32_t run_count = 0;    // recorded so far, or available for replay
+    uint32_t replayed = 0;     // runs started in Replay mode
+    uint32_t run = 0;          // run currently recorded or replayed
+
+    std::mutex mutex; // guards bytes while recording
+    std::vector<std::byte> bytes;
+    std::vector<size_t> offsets; // replay, record of a node and run at run * node_count + node, 0 if none
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> unrecorded{0}; // nodes left out of a run for outputs without an encoding
+
+    Trace() = default;
+
+    // called by the executor before each run of the instance
+    void begin_run(const GraphPlan &plan);
+
+    void record(uint32_t node_idx, std::span<const Value> outputs);
+
+    // returns false if the node was not recorded in this run, the outputs are left empty then
+    bool replay(uint32_t node_idx, std::span<Value> outputs);
+};
+
+// hash of the funcs and wiring of a plan, Const inputs may differ between record and replay
+uint64_t plan_fingerprint(const GraphPlan &plan);
+
+bool save_trace(const Trace &trace, const std::string &path);
+
+// the loaded trace is in Replay mode and starts with its first run
+bool load_trace(Trace *trace, const std::string &path);
@@ -0,0 +1,62 @@
+#include "file_sync.hpp"
+
+#include <filesystem>
+
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#include <windows.h>
+
+#else
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#endif
+
+
+#ifdef _WIN32
+
+bool sync_file(const std::string &path) {
+    HANDLE handle = CreateFileA(
+            path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    const bool flushed = FlushFileBuffers(handle);
+    CloseHandle(handle);
+    return flushed;
+}
+
+bool sync_parent_directory(const std::string &) {
+    return true;
+}
+
+#else
+
+static bool sync_path(const std::string &path, int flags) {
+    const int fd = open(path.c_str(), flags);
+    if (fd < 0) {
+        return false;
+    }
+    const bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+bool sync_file(const std::string &path) {
+    return sync_path(path, O_WRONLY);
+}
+
+bool sync_parent_directory(const std::string &path) {
+    std::error_code error;
+    const auto parent = std::filesystem::absolute(path, error).parent_path();
+    return !error && sync_path(parent.string(), O_RDONLY | O_DIRECTORY);
+}
+
+#endif
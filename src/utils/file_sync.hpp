@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+
+// Flushes what was written to the file at path to the disk, through a handle of its own, so
+// writes made through a stream count once the stream was flushed.
+bool sync_file(const std::string &path);
+
+// Flushes the directory holding path, which makes a rename or a new file in it durable. Windows
+// has no handle for that, renames there are made durable by NTFS itself.
+bool sync_parent_directory(const std::string &path);
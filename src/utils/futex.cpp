@@ -0,0 +1,50 @@
+#include "futex.hpp"
+
+#include <thread>
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+#ifdef __linux__
+
+bool futex_wait(std::atomic<uint32_t> &word, uint32_t expected, std::chrono::milliseconds timeout) {
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    ts.tv_nsec = static_cast<long>((timeout.count() % 1000) * 1000000);
+
+    auto result = syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+    return result == 0 || errno != ETIMEDOUT;
+}
+
+void futex_wake_all(std::atomic<uint32_t> &word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+#else
+
+bool futex_wait(std::atomic<uint32_t> &word, uint32_t expected, std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (word.load(std::memory_order_acquire) == expected) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    return true;
+}
+
+void futex_wake_all(std::atomic<uint32_t> &word) {
+}
+
+#endif
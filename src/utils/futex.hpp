@@ -0,0 +1,15 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+
+// Wait/wake on a 32-bit word that may live in memory shared between processes. Linux uses the
+// futex syscall without FUTEX_PRIVATE_FLAG, elsewhere waits fall back to polling with short
+// sleeps, which is enough for the in-process stand-in.
+
+// returns false on timeout, spurious wakeups return true like the syscall does
+bool futex_wait(std::atomic<uint32_t> &word, uint32_t expected, std::chrono::milliseconds timeout);
+
+void futex_wake_all(std::atomic<uint32_t> &word);
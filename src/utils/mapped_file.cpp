@@ -0,0 +1,111 @@
+#include "mapped_file.hpp"
+
+#include <new>
+#include <utility>
+
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#include <windows.h>
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#endif
+
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+        : data(std::exchange(other.data, nullptr)),
+          size(std::exchange(other.size, 0)),
+          handle(std::exchange(other.handle, nullptr)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        this->~MappedFile();
+        new(this) MappedFile(std::move(other));
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+MappedFile::~MappedFile() {
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (handle != nullptr) {
+        CloseHandle(static_cast<HANDLE>(handle));
+    }
+}
+
+bool map_file(MappedFile *file, const std::string &path) {
+    HANDLE handle = CreateFileA(
+            path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        CloseHandle(handle);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (mapping == nullptr) {
+        return false;
+    }
+    auto data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    *file = MappedFile{};
+    file->data = static_cast<const std::byte *>(data);
+    file->size = static_cast<size_t>(size.QuadPart);
+    file->handle = mapping;
+    return true;
+}
+
+#else
+
+MappedFile::~MappedFile() {
+    if (data != nullptr) {
+        munmap(const_cast<std::byte *>(data), size);
+    }
+}
+
+bool map_file(MappedFile *file, const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    const auto size = static_cast<size_t>(info.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    *file = MappedFile{};
+    file->data = static_cast<const std::byte *>(data);
+    file->size = size;
+    return true;
+}
+
+#endif
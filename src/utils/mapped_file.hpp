@@ -0,0 +1,27 @@
+#pragma once
+
+#include "nocopy.hpp"
+
+#include <cstddef>
+#include <string>
+
+
+// Read-only mapping of a whole file, pages are read in on first access.
+struct MappedFile {
+    NOCOPY(MappedFile)
+
+    const std::byte *data = nullptr;
+    size_t size = 0;
+    void *handle = nullptr;
+
+    MappedFile() = default;
+
+    MappedFile(MappedFile &&other) noexcept;
+
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    ~MappedFile();
+};
+
+// empty files fail, there is nothing to map
+bool map_file(MappedFile *file, const std::string &path);
@@ -0,0 +1,130 @@
+#include "shared_memory.hpp"
+
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#include <windows.h>
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#endif
+
+
+SharedMemory::SharedMemory(SharedMemory &&other) noexcept
+        : name(std::move(other.name)),
+          data(std::exchange(other.data, nullptr)),
+          size(std::exchange(other.size, 0)),
+          owner(std::exchange(other.owner, false)),
+          handle(std::exchange(other.handle, nullptr)) {}
+
+SharedMemory &SharedMemory::operator=(SharedMemory &&other) noexcept {
+    if (this != &other) {
+        this->~SharedMemory();
+        new(this) SharedMemory(std::move(other));
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+SharedMemory::~SharedMemory() {
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (handle != nullptr) {
+        CloseHandle(static_cast<HANDLE>(handle));
+    }
+}
+
+static bool map_shared_memory(SharedMemory *memory, const std::string &name, size_t size, bool create) {
+    HANDLE handle;
+    if (create) {
+        handle = CreateFileMappingA(
+                INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size),
+                name.empty() ? nullptr : name.c_str()
+        );
+    } else {
+        handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    }
+    if (handle == nullptr) {
+        return false;
+    }
+
+    auto data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (data == nullptr) {
+        CloseHandle(handle);
+        return false;
+    }
+
+    memory->name = name;
+    memory->data = static_cast<std::byte *>(data);
+    memory->size = size;
+    memory->owner = create;
+    memory->handle = handle;
+    return true;
+}
+
+#else
+
+SharedMemory::~SharedMemory() {
+    if (data != nullptr) {
+        munmap(data, size);
+    }
+    if (owner && !name.empty()) {
+        shm_unlink(name.c_str());
+    }
+}
+
+static bool map_shared_memory(SharedMemory *memory, const std::string &name, size_t size, bool create) {
+    void *data;
+    if (name.empty()) {
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    } else {
+        const int flags = create ? O_RDWR | O_CREAT | O_EXCL : O_RDWR;
+        const int fd = shm_open(name.c_str(), flags, 0600);
+        if (fd < 0) {
+            return false;
+        }
+        if (create && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            shm_unlink(name.c_str());
+            return false;
+        }
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if (data == MAP_FAILED) {
+        if (create && !name.empty()) {
+            shm_unlink(name.c_str());
+        }
+        return false;
+    }
+
+    memory->name = name;
+    memory->data = static_cast<std::byte *>(data);
+    memory->size = size;
+    memory->owner = create;
+    return true;
+}
+
+#endif
+
+bool create_shared_memory(SharedMemory *memory, const std::string &name, size_t size) {
+    return map_shared_memory(memory, name, size, true);
+}
+
+bool open_shared_memory(SharedMemory *memory, const std::string &name, size_t size) {
+    return map_shared_memory(memory, name, size, false);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "nocopy.hpp"
+
+#include <cstddef>
+#include <string>
+
+
+// Memory mapping that other processes can open by name. An empty name gives a private
+// anonymous mapping, used when both sides run in the same process.
+struct SharedMemory {
+    NOCOPY(SharedMemory)
+
+    std::string name;
+    std::byte *data = nullptr;
+    size_t size = 0;
+    bool owner = false; // created the mapping and removes the name on destruction
+    void *handle = nullptr;
+
+    SharedMemory() = default;
+
+    SharedMemory(SharedMemory &&other) noexcept;
+
+    SharedMemory &operator=(SharedMemory &&other) noexcept;
+
+    ~SharedMemory();
+};
+
+// contents start zeroed
+bool create_shared_memory(SharedMemory *memory, const std::string &name, size_t size);
+
+bool open_shared_memory(SharedMemory *memory, const std::string &name, size_t size);
@@ -0,0 +1,87 @@
+#include "symbol.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+static constexpr uint32_t BlockBits = 12;
+static constexpr uint32_t BlockSize = 1u << BlockBits;
+static constexpr uint32_t MaxBlocks = 1u << 16;
+static constexpr size_t ChunkSize = 64 * 1024;
+
+// Texts live in chunks of an arena, the views of them in blocks that are published once
+// filled in and never move, so readers only need the block pointer.
+struct SymbolTable {
+    std::mutex mutex;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::atomic<std::string_view *> blocks[MaxBlocks]{};
+    uint32_t count = 1;
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char *free = nullptr;
+    size_t free_size = 0;
+
+    std::string_view store(std::string_view text) {
+        if (text.size() > free_size) {
+            const auto size = std::max(ChunkSize, text.size());
+            free = chunks.emplace_back(std::make_unique<char[]>(size)).get();
+            free_size = size;
+        }
+        std::copy(text.begin(), text.end(), free);
+        std::string_view stored(free, text.size());
+        free += text.size();
+        free_size -= text.size();
+        return stored;
+    }
+};
+
+// leaked on purpose, names can be read by destructors of other statics
+static SymbolTable &symbol_table() {
+    static auto *table = new SymbolTable{};
+    return *table;
+}
+
+
+Symbol::Symbol(std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    auto &table = symbol_table();
+    std::lock_guard lock(table.mutex);
+    auto it = table.ids.find(text);
+    if (it != table.ids.end()) {
+        id = it->second;
+        return;
+    }
+
+    id = table.count;
+    assert(id / BlockSize < MaxBlocks);
+    auto *block = table.blocks[id / BlockSize].load(std::memory_order_relaxed);
+    if (block == nullptr) {
+        block = new std::string_view[BlockSize];
+        table.blocks[id / BlockSize].store(block, std::memory_order_release);
+    }
+    block[id % BlockSize] = table.store(text);
+    table.ids.emplace(block[id % BlockSize], id);
+    ++table.count;
+}
+
+std::string_view Symbol::view() const {
+    if (id == 0) {
+        return {};
+    }
+    // whoever handed out this Symbol synchronized with its interning, the block is published
+    const auto *block = symbol_table().blocks[id / BlockSize].load(std::memory_order_acquire);
+    return block[id % BlockSize];
+}
+
+uint32_t symbol_count() {
+    auto &table = symbol_table();
+    std::lock_guard lock(table.mutex);
+    return table.count;
+}
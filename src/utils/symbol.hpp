@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+// Interned string for the names of nodes, funcs, args and events. Every distinct text is stored
+// once in a process-wide table that is never freed and a Symbol is its 4 byte index there, so
+// copying or comparing two Symbols does not touch the text. Symbol{} is the empty string.
+// Interning takes a lock, reading the text of a Symbol does not.
+struct Symbol {
+    uint32_t id = 0;
+
+    Symbol() = default;
+
+    // implicit, names are assigned and initialized like the strings they used to be
+    Symbol(std::string_view text);
+
+    Symbol(const std::string &text) : Symbol(std::string_view(text)) {}
+
+    Symbol(const char *text) : Symbol(std::string_view(text)) {}
+
+    [[nodiscard]] std::string_view view() const;
+
+    [[nodiscard]] std::string str() const {
+        return std::string(view());
+    }
+
+    [[nodiscard]] bool empty() const {
+        return id == 0;
+    }
+
+    operator std::string_view() const {
+        return view();
+    }
+
+    friend bool operator==(Symbol lhs, Symbol rhs) {
+        return lhs.id == rhs.id;
+    }
+
+    // comparing with text does not intern it
+    friend bool operator==(Symbol lhs, std::string_view rhs) {
+        return lhs.view() == rhs;
+    }
+
+    friend bool operator==(Symbol lhs, const std::string &rhs) {
+        return lhs.view() == rhs;
+    }
+
+    friend bool operator==(Symbol lhs, const char *rhs) {
+        return lhs.view() == rhs;
+    }
+};
+
+// number of distinct texts interned so far, including the empty one
+uint32_t symbol_count();
@@ -0,0 +1,223 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#include <windows.h>
+
+#elif defined(__linux__)
+
+#include <pthread.h>
+#include <sched.h>
+
+#endif
+
+
+static thread_local uint32_t thread_index = UINT32_MAX;
+
+static void pin_to_core(uint32_t core) {
+#ifdef _WIN32
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << (core % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+
+ThreadPool::ThreadPool(const ThreadPoolConfig &config) {
+    auto count = config.thread_count;
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const auto cores = std::max(1u, std::thread::hardware_concurrency());
+
+    workers.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        workers.emplace_back([this, i, pin = config.pin_threads, cores] {
+            if (pin) {
+                pin_to_core(i % cores);
+            }
+            worker_loop(i);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+uint32_t ThreadPool::thread_count() const {
+    return static_cast<uint32_t>(workers.size());
+}
+
+void ThreadPool::submit(Task task) {
+    {
+        std::lock_guard lock(mutex);
+        queue.push_back(std::move(task));
+    }
+    work_cv.notify_one();
+}
+
+bool ThreadPool::run_one() {
+    Task task;
+    {
+        std::lock_guard lock(mutex);
+        if (queue.empty()) {
+            return false;
+        }
+        task = std::move(queue.front());
+        queue.pop_front();
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &body) {
+    if (begin >= end) {
+        return;
+    }
+    if (grain == 0) {
+        grain = std::max<size_t>(1, (end - begin) / (4 * (thread_count() + 1)));
+    }
+    const auto chunk_count = (end - begin + grain - 1) / grain;
+    if (chunk_count == 1) {
+        body(begin, end);
+        return;
+    }
+
+    // chunks are claimed from a shared counter, so a helper that starts late takes what is left
+    std::atomic<size_t> next_chunk{0};
+    auto process = [&] {
+        for (auto chunk = next_chunk++; chunk < chunk_count; chunk = next_chunk++) {
+            const auto chunk_begin = begin + chunk * grain;
+            body(chunk_begin, std::min(end, chunk_begin + grain));
+        }
+    };
+
+    TaskGroup group{*this};
+    const auto helpers = std::min<size_t>(thread_count(), chunk_count - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        group.run(process);
+    }
+    process();
+    group.wait();
+}
+
+uint32_t ThreadPool::current_thread_index() {
+    return thread_index;
+}
+
+void ThreadPool::worker_loop(uint32_t thread_idx) {
+    thread_index = thread_idx;
+
+    std::unique_lock lock(mutex);
+    while (true) {
+        work_cv.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+        auto task = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+
+TaskGroup::TaskGroup(ThreadPool &pool) : pool(&pool) {}
+
+TaskGroup::~TaskGroup() {
+    wait();
+}
+
+void TaskGroup::run(Task task) {
+    {
+        std::lock_guard lock(mutex);
+        ++pending;
+    }
+    pool->submit([this, task = std::move(task)] {
+        task();
+        finish();
+    });
+}
+
+void TaskGroup::then(Task continuation) {
+    {
+        std::lock_guard lock(mutex);
+        if (pending != 0) {
+            continuations.push_back(std::move(continuation));
+            return;
+        }
+    }
+    run(std::move(continuation));
+}
+
+void TaskGroup::wait() {
+    while (true) {
+        {
+            // also makes sure the finish() that emptied the group is done with it
+            std::lock_guard lock(mutex);
+            if (pending == 0) {
+                return;
+            }
+        }
+        if (pool->run_one()) {
+            continue;
+        }
+
+        // whatever is left is running on other threads, which may still queue more
+        std::unique_lock pool_lock(pool->mutex);
+        ++sleepers;
+        pool->work_cv.wait(pool_lock, [this] { return !pool->queue.empty() || pending == 0; });
+        --sleepers;
+        if (pending == 0 && !pool->queue.empty()) {
+            // the wakeup may have been meant for a worker to take the task, pass it on
+            pool->work_cv.notify_one();
+        }
+    }
+}
+
+void TaskGroup::finish() {
+    std::vector<Task> ready;
+    {
+        std::lock_guard lock(mutex);
+        if (pending == 1 && !continuations.empty()) {
+            // the continuations take over the count of the task that just finished
+            ready = std::move(continuations);
+            continuations.clear();
+            pending += static_cast<uint32_t>(ready.size()) - 1;
+        } else if (--pending == 0) {
+            // sleeping waiters share the condition variable of the workers, so they wake for new
+            // tasks as well
+            std::lock_guard pool_lock(pool->mutex);
+            if (sleepers != 0) {
+                pool->work_cv.notify_all();
+            }
+            return;
+        } else {
+            return;
+        }
+    }
+    for (auto &continuation: ready) {
+        pool->submit([this, continuation = std::move(continuation)] {
+            continuation();
+            finish();
+        });
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "nocopy.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+using Task = std::function<void()>;
+
+struct ThreadPoolConfig {
+    uint32_t thread_count = 0; // 0 picks std::thread::hardware_concurrency()
+    bool pin_threads = false;  // worker i runs on core i modulo the core count, where supported
+};
+
+// Fixed set of worker threads over one FIFO queue. Threads that wait on a TaskGroup or run a
+// parallel_for take queued tasks themselves, so tasks may wait on groups of their own.
+struct ThreadPool {
+    NOCOPY(ThreadPool)
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::deque<Task> queue;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+
+    explicit ThreadPool(const ThreadPoolConfig &config = {});
+
+    ~ThreadPool();
+
+    [[nodiscard]] uint32_t thread_count() const;
+
+    void submit(Task task);
+
+    // Runs a queued task on the calling thread, returns false if there was none.
+    bool run_one();
+
+    // Calls body(chunk_begin, chunk_end) over [begin, end) in chunks of at most grain indices and
+    // returns once all are done. A grain of 0 splits into a few chunks per thread.
+    void parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &body);
+
+    // index of the pool worker running the caller, UINT32_MAX on any other thread
+    static uint32_t current_thread_index();
+
+    void worker_loop(uint32_t thread_idx);
+};
+
+// Tasks that are waited on together. Continuations added with then() run on the pool once the
+// group has no other task left, which includes tasks added after them, and count as tasks of
+// the group themselves.
+struct TaskGroup {
+    NOCOPY(TaskGroup)
+
+    ThreadPool *pool;
+    std::mutex mutex;
+    std::atomic<uint32_t> pending{0}; // changed under mutex, read by waiters under pool->mutex
+    uint32_t sleepers = 0;            // threads in wait() on pool->work_cv, under pool->mutex
+    std::vector<Task> continuations;
+
+    explicit TaskGroup(ThreadPool &pool);
+
+    ~TaskGroup();
+
+    void run(Task task);
+
+    void then(Task continuation);
+
+    // Helps with queued tasks of any group while waiting. With nothing queued it sleeps until
+    // either a task is submitted or the last one of the group finishes.
+    void wait();
+
+    void finish();
+};
+
+// One T per pool worker plus one shared by every thread outside the pool, each on its own
+// cache line. Meant for scratch buffers reused across tasks of that pool.
+template<typename T>
+struct PerThread {
+    struct alignas(64) Slot {
+        T value{};
+    };
+
+    std::vector<Slot> slots;
+
+    explicit PerThread(const ThreadPool &pool) : slots(pool.thread_count() + 1) {}
+
+    T &local() {
+        return slots[std::min<size_t>(ThreadPool::current_thread_index(), slots.size() - 1)].value;
+    }
+
+    template<typename F>
+    void for_each(F &&f) {
+        for (auto &slot: slots) {
+            f(slot.value);
+        }
+    }
+};
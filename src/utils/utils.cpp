@@ -1,17 +1,131 @@
 #include "utils.hpp"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <random>
 
-uuids::uuid_random_generator create_uuid_random_generator() {
-    std::random_device rd;
-    auto seed_data = std::array<int, std::mt19937::state_size>{};
-    std::generate(std::begin(seed_data), std::end(seed_data), std::ref(rd));
-    std::seed_seq seq(std::begin(seed_data), std::end(seed_data));
-    std::mt19937 generator(seq);
-    uuids::uuid_random_generator gen{generator};
-    return gen;
+
+static uint64_t splitmix64(uint64_t &state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static std::atomic<UuidVersion> uuid_version{UuidVersion::Random};
+
+// xoshiro256**, one per thread so ids are generated without any synchronization
+struct UuidGenerator {
+    uint64_t s[4];
+    uint64_t last_ms = 0; // of the last time ordered id
+    uint64_t counter = 0;
+
+    UuidGenerator() {
+        // random_device alone may be deterministic on some platforms, the counter keeps the
+        // threads of a process apart even then
+        static std::atomic<uint64_t> thread_counter{0};
+        std::random_device device;
+        uint64_t state = (static_cast<uint64_t>(device()) << 32 | device()) ^ (++thread_counter * 0xd1b54a32d192ed03ull)
+                         ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        for (auto &word: s) {
+            word = splitmix64(state) ^ (static_cast<uint64_t>(device()) << 32 | device());
+        }
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Version 7: 48 bits of Unix time in ms, then a 42 bit counter split around the version and
+    // variant bits, then 32 random bits. The counter starts at a random value below 2^41 in
+    // every ms and takes the time one ms ahead when it runs out, so the ids of a thread keep
+    // increasing even when the clock stalls or goes back.
+    uuids::uuid time_ordered() {
+        const auto now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        if (now > last_ms) {
+            last_ms = now;
+            counter = next() >> 23;
+        } else if (++counter >> 42 != 0) {
+            ++last_ms;
+            counter = next() >> 23;
+        }
+
+        std::array<uint8_t, 16> bytes{};
+        for (int i = 0; i < 6; ++i) {
+            bytes[i] = static_cast<uint8_t>(last_ms >> (40 - 8 * i));
+        }
+        bytes[6] = static_cast<uint8_t>(0x70 | (counter >> 38));
+        bytes[7] = static_cast<uint8_t>(counter >> 30);
+        bytes[8] = static_cast<uint8_t>(0x80 | ((counter >> 24) & 0x3f));
+        bytes[9] = static_cast<uint8_t>(counter >> 16);
+        bytes[10] = static_cast<uint8_t>(counter >> 8);
+        bytes[11] = static_cast<uint8_t>(counter);
+        const auto random = static_cast<uint32_t>(next() >> 32);
+        std::memcpy(bytes.data() + 12, &random, sizeof(random));
+        return uuids::uuid(bytes);
+    }
+
+    uuids::uuid operator()() {
+        if (uuid_version.load(std::memory_order_relaxed) == UuidVersion::TimeOrdered) {
+            return time_ordered();
+        }
+        std::array<uint8_t, 16> bytes{};
+        const uint64_t halves[2] = {next(), next()};
+        std::memcpy(bytes.data(), halves, bytes.size());
+        bytes[6] = static_cast<uint8_t>((bytes[6] & 0x0f) | 0x40); // version 4
+        bytes[8] = static_cast<uint8_t>((bytes[8] & 0x3f) | 0x80); // RFC 4122 variant
+        return uuids::uuid(bytes);
+    }
+};
+
+static UuidGenerator &thread_generator() {
+    thread_local UuidGenerator generator;
+    return generator;
 }
 
 uuids::uuid generate_uuid() {
-    static uuids::uuid_random_generator gen = create_uuid_random_generator();
-    return gen();
-}
\ No newline at end of file
+    return thread_generator()();
+}
+
+void set_uuid_version(UuidVersion version) {
+    uuid_version.store(version, std::memory_order_relaxed);
+}
+
+void generate_uuids(std::span<uuids::uuid> ids) {
+    auto &generator = thread_generator();
+    for (auto &id: ids) {
+        id = generator();
+    }
+}
+
+
+uint64_t hash_bytes(const void *data, size_t size, uint64_t seed) {
+    // FNV-1a
+    auto bytes = static_cast<const uint8_t *>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t hash_uuid(const uuids::uuid &id) {
+    auto bytes = id.as_bytes();
+    return hash_bytes(bytes.data(), bytes.size());
+}
@@ -2,7 +2,37 @@
 
 #include <uuid.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <span>
 
 
+enum class UuidVersion : uint8_t {
+    Random,      // version 4
+    TimeOrdered, // version 7, ids made together sort together and those of a thread increase
+};
 
-uuids::uuid generate_uuid() ;
\ No newline at end of file
+// for generate_uuid() and generate_uuids() on all threads, Random by default
+void set_uuid_version(UuidVersion version);
+
+// uuid of the version set, from a generator of the calling thread, safe to call from any thread
+uuids::uuid generate_uuid();
+
+// Fills ids like as many generate_uuid() calls, looking up the thread's generator only once
+void generate_uuids(std::span<uuids::uuid> ids);
+
+
+uint64_t hash_bytes(const void *data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+
+inline uint64_t hash_combine(uint64_t seed, uint64_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+uint64_t hash_uuid(const uuids::uuid &id);
+
+// std::hash<uuids::uuid> goes through to_string, this one hashes the raw bytes
+struct UuidHash {
+    size_t operator()(const uuids::uuid &id) const noexcept {
+        return static_cast<size_t>(hash_uuid(id));
+    }
+};
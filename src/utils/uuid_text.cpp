@@ -0,0 +1,173 @@
+#include "uuid_text.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UUID_TEXT_SSE2
+#endif
+
+
+// offsets of the 5 groups in the text and their sizes in hex digits
+static constexpr size_t GroupOffsets[] = {0, 9, 14, 19, 24};
+static constexpr size_t GroupSizes[] = {8, 4, 4, 4, 12};
+
+// 32 hex digits to the grouped text
+static void insert_dashes(const char *digits, char *out) {
+    for (size_t group = 0, digit = 0; group < 5; ++group) {
+        std::memcpy(out + GroupOffsets[group], digits + digit, GroupSizes[group]);
+        digit += GroupSizes[group];
+        if (group != 4) {
+            out[GroupOffsets[group] + GroupSizes[group]] = '-';
+        }
+    }
+}
+
+static void remove_dashes(const char *text, char *digits) {
+    for (size_t group = 0, digit = 0; group < 5; ++group) {
+        std::memcpy(digits + digit, text + GroupOffsets[group], GroupSizes[group]);
+        digit += GroupSizes[group];
+    }
+}
+
+static void format_digits_scalar(const uint8_t *bytes, char *digits) {
+    static constexpr char Hex[] = "0123456789abcdef";
+    for (size_t i = 0; i < 16; ++i) {
+        digits[2 * i] = Hex[bytes[i] >> 4];
+        digits[2 * i + 1] = Hex[bytes[i] & 0x0f];
+    }
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = static_cast<char>(c | 0x20);
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+static bool parse_digits_scalar(const char *digits, uint8_t *bytes) {
+    for (size_t i = 0; i < 16; ++i) {
+        const auto high = hex_value(digits[2 * i]);
+        const auto low = hex_value(digits[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        bytes[i] = static_cast<uint8_t>(high << 4 | low);
+    }
+    return true;
+}
+
+
+#ifdef UUID_TEXT_SSE2
+
+static void format_digits_sse2(const uint8_t *bytes, char *digits) {
+    const auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes));
+    const auto low_nibbles = _mm_set1_epi8(0x0f);
+    const auto high = _mm_and_si128(_mm_srli_epi16(input, 4), low_nibbles);
+    const auto low = _mm_and_si128(input, low_nibbles);
+
+    // '0' + n, plus the distance from '9' + 1 to 'a' for n > 9
+    auto to_hex = [](__m128i nibbles) {
+        const auto letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '9' - 1));
+        return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+    };
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(digits), to_hex(_mm_unpacklo_epi8(high, low)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(digits + 16), to_hex(_mm_unpackhi_epi8(high, low)));
+}
+
+// 16 hex digits to 8 bytes in the low half of 16 bit lanes, all ones in invalid if one is not hex
+static __m128i parse_digits(const char *digits, __m128i &invalid) {
+    const auto text = _mm_loadu_si128(reinterpret_cast<const __m128i *>(digits));
+    const auto zero = _mm_setzero_si128();
+
+    // unsigned n <= limit as saturating n - limit == 0
+    const auto decimal = _mm_sub_epi8(text, _mm_set1_epi8('0'));
+    const auto is_decimal = _mm_cmpeq_epi8(_mm_subs_epu8(decimal, _mm_set1_epi8(9)), zero);
+    const auto letter = _mm_sub_epi8(_mm_or_si128(text, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const auto is_letter = _mm_cmpeq_epi8(_mm_subs_epu8(letter, _mm_set1_epi8(5)), zero);
+    invalid = _mm_or_si128(invalid, _mm_andnot_si128(_mm_or_si128(is_decimal, is_letter), _mm_set1_epi8(-1)));
+
+    const auto nibbles = _mm_or_si128(_mm_and_si128(is_decimal, decimal),
+                                      _mm_andnot_si128(is_decimal, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+    // lanes are high digit | low digit << 8
+    const auto high = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4);
+    return _mm_or_si128(high, _mm_srli_epi16(nibbles, 8));
+}
+
+static bool parse_digits_sse2(const char *digits, uint8_t *bytes) {
+    auto invalid = _mm_setzero_si128();
+    const auto first = parse_digits(digits, invalid);
+    const auto second = parse_digits(digits + 16, invalid);
+    if (_mm_movemask_epi8(invalid) != 0) {
+        return false;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(bytes), _mm_packus_epi16(first, second));
+    return true;
+}
+
+#endif
+
+
+// Canonical text goes to digits_to_bytes, anything else to stduuid.
+template<typename DigitsToBytes>
+static bool parse_uuid_with(std::string_view text, uuids::uuid &id, DigitsToBytes digits_to_bytes) {
+    const bool canonical = text.size() == UuidTextSize && text[8] == '-' && text[13] == '-' && text[18] == '-'
+                           && text[23] == '-';
+    if (!canonical) {
+        auto parsed = uuids::uuid::from_string(text);
+        if (!parsed.has_value()) {
+            return false;
+        }
+        id = parsed.value();
+        return true;
+    }
+
+    char digits[32];
+    remove_dashes(text.data(), digits);
+    std::array<uint8_t, 16> bytes{};
+    if (!digits_to_bytes(digits, bytes.data())) {
+        return false;
+    }
+    id = uuids::uuid(bytes);
+    return true;
+}
+
+
+void format_uuid(const uuids::uuid &id, char *out) {
+#ifdef UUID_TEXT_SSE2
+    const auto bytes = id.as_bytes();
+    char digits[32];
+    format_digits_sse2(reinterpret_cast<const uint8_t *>(bytes.data()), digits);
+    insert_dashes(digits, out);
+#else
+    format_uuid_scalar(id, out);
+#endif
+}
+
+std::string format_uuid(const uuids::uuid &id) {
+    std::string text(UuidTextSize, '\0');
+    format_uuid(id, text.data());
+    return text;
+}
+
+bool parse_uuid(std::string_view text, uuids::uuid &id) {
+#ifdef UUID_TEXT_SSE2
+    return parse_uuid_with(text, id, parse_digits_sse2);
+#else
+    return parse_uuid_scalar(text, id);
+#endif
+}
+
+void format_uuid_scalar(const uuids::uuid &id, char *out) {
+    const auto bytes = id.as_bytes();
+    char digits[32];
+    format_digits_scalar(reinterpret_cast<const uint8_t *>(bytes.data()), digits);
+    insert_dashes(digits, out);
+}
+
+bool parse_uuid_scalar(std::string_view text, uuids::uuid &id) {
+    return parse_uuid_with(text, id, parse_digits_scalar);
+}
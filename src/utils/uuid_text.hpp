@@ -0,0 +1,26 @@
+#pragma once
+
+#include <uuid.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+
+constexpr size_t UuidTextSize = 36;
+
+// Lowercase 8-4-4-4-12 hex, the same text as uuids::to_string, written to out without a
+// terminator. Vectorized with SSE2 where available.
+void format_uuid(const uuids::uuid &id, char *out);
+
+std::string format_uuid(const uuids::uuid &id);
+
+// Same results as uuids::uuid::from_string. Text in the canonical 36 character form, either
+// case, takes the vectorized path, anything else is left to stduuid.
+bool parse_uuid(std::string_view text, uuids::uuid &id);
+
+// The portable versions of the above, which they fall back to without SSE2. Always built so
+// tests can hold both against stduuid.
+void format_uuid_scalar(const uuids::uuid &id, char *out);
+
+bool parse_uuid_scalar(std::string_view text, uuids::uuid &id);
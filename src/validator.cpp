@@ -0,0 +1,541 @@
+#include "validator.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+
+std::string to_string(const ValidationIssueKind &kind) {
+    switch (kind) {
+        case ValidationIssueKind::MissingFunc:
+            return "MissingFunc";
+        case ValidationIssueKind::UnboundInput:
+            return "UnboundInput";
+        case ValidationIssueKind::UnknownNode:
+            return "UnknownNode";
+        case ValidationIssueKind::UnknownOutput:
+            return "UnknownOutput";
+        case ValidationIssueKind::DatatypeMismatch:
+            return "DatatypeMismatch";
+        case ValidationIssueKind::Cycle:
+            return "Cycle";
+    }
+    assert(false);
+}
+
+
+static const FuncArg *find_output_arg(const Func &func, uint32_t output_idx) {
+    for (const auto &arg: func.args) {
+        if (arg.type == FuncArgType::Out && output_idx-- == 0) {
+            return &arg;
+        }
+    }
+    return nullptr;
+}
+
+
+GraphValidator::GraphValidator(const Graph &graph, const FuncLib &lib) : graph(&graph), lib(&lib) {}
+
+void GraphValidator::touch(const NodeId &id) {
+    dirty.insert(id);
+}
+
+bool GraphValidator::validate() {
+    index_fresh = false;
+
+    if (!validated) {
+        for (const auto &node: graph->nodes) {
+            dirty.insert(node.id);
+        }
+    }
+    update_index();
+
+    std::unordered_set<NodeId, UuidHash> pending;
+    for (const auto &id: dirty) {
+        if (locate(id) == nullptr) {
+            if (auto it = nodes.find(id); it != nodes.end()) {
+                pending.insert(it->second.consumers.begin(), it->second.consumers.end());
+                lost_edges.insert(lost_edges.end(), it->second.consumers.begin(), it->second.consumers.end());
+                forget(id);
+            }
+            continue;
+        }
+
+        pending.insert(id);
+        pending.insert(nodes[id].consumers.begin(), nodes[id].consumers.end());
+        if (auto it = dangling.find(id); it != dangling.end()) {
+            pending.insert(it->second.begin(), it->second.end());
+            for (const auto &consumer: it->second) {
+                new_edges.emplace_back(id, consumer);
+            }
+            auto &consumers = nodes[id].consumers;
+            consumers.insert(consumers.end(), it->second.begin(), it->second.end());
+            dangling.erase(it);
+        }
+    }
+    dirty.clear();
+
+    for (const auto &id: pending) {
+        const auto *node = locate(id);
+        if (node != nullptr) {
+            check_node(*node, nodes[id]);
+        }
+    }
+
+    if (!validated) {
+        find_cycles(nullptr);
+        validated = true;
+    } else {
+        // removing edges can only break cycles, adding them can only close new ones
+        if (!lost_edges.empty() && !cyclic.empty()) {
+            break_cycles();
+        }
+        if (!new_edges.empty()) {
+            join_cycles();
+        }
+    }
+    new_edges.clear();
+    lost_edges.clear();
+    if (!levels_valid && cyclic.empty()) {
+        assign_levels();
+    }
+
+    return issue_list.empty() && cyclic.empty();
+}
+
+std::vector<ValidationIssue> GraphValidator::issues() const {
+    std::vector<ValidationIssue> result;
+    result.reserve(issue_list.size() + cyclic.size());
+    result.insert(result.end(), issue_list.begin(), issue_list.end());
+    for (const auto &id: cyclic) {
+        result.push_back(ValidationIssue{ValidationIssueKind::Cycle, id, 0});
+    }
+    return result;
+}
+
+const Node *GraphValidator::locate(const NodeId &id) {
+    auto it = nodes.find(id);
+    if (it == nodes.end()) {
+        // update_index() gave every node touched and still in the graph a state
+        return nullptr;
+    }
+    const auto hint = it->second.index_hint;
+    if (hint < graph->nodes.size() && graph->nodes[hint].id == id) {
+        return &graph->nodes[hint];
+    }
+
+    // a touched node away from its hint was erased, any other was moved without a touch
+    if (index_fresh || dirty.contains(id)) {
+        return nullptr;
+    }
+    rehint(0);
+    return locate(id);
+}
+
+void GraphValidator::update_index() {
+    // Inserts and erases shift the nodes behind them, nodes in front of the first one keep their
+    // hints. A touched node that is not at its hint anymore was erased or moved, so the first
+    // change is at its hint or before. Up to there only inserts shift nodes, which move them
+    // further with every insert, so the positions that moved are a suffix.
+    auto limit = static_cast<uint32_t>(graph->nodes.size());
+    for (const auto &id: dirty) {
+        auto it = nodes.find(id);
+        if (it == nodes.end()) {
+            continue;
+        }
+        const auto hint = it->second.index_hint;
+        if (hint < limit && graph->nodes[hint].id != id) {
+            limit = hint;
+        }
+    }
+
+    auto hinted = [this](uint32_t position) {
+        auto it = nodes.find(graph->nodes[position].id);
+        return it != nodes.end() && it->second.index_hint == position;
+    };
+    uint32_t first = 0;
+    while (first < limit) {
+        const auto middle = first + (limit - first) / 2;
+        if (hinted(middle)) {
+            first = middle + 1;
+        } else {
+            limit = middle;
+        }
+    }
+    rehint(first);
+}
+
+void GraphValidator::rehint(uint32_t first) {
+    for (auto i = first; i < graph->nodes.size(); ++i) {
+        const auto &id = graph->nodes[i].id;
+        if (auto it = nodes.find(id); it != nodes.end()) {
+            it->second.index_hint = i;
+        } else if (dirty.contains(id)) {
+            nodes[id].index_hint = i;
+        }
+    }
+    index_fresh = index_fresh || first == 0;
+}
+
+void GraphValidator::forget(const NodeId &id) {
+    auto it = nodes.find(id);
+    assert(it != nodes.end());
+
+    for (const auto &producer: it->second.producers) {
+        auto &consumers = nodes.contains(producer) ? nodes[producer].consumers : dangling[producer];
+        std::erase(consumers, id);
+        if (consumers.empty()) {
+            dangling.erase(producer);
+        }
+    }
+
+    if (!it->second.consumers.empty()) {
+        auto &waiting = dangling[id];
+        waiting.insert(waiting.end(), it->second.consumers.begin(), it->second.consumers.end());
+    }
+
+    set_issues(it->second, {});
+    cyclic.erase(id);
+    nodes.erase(it);
+}
+
+void GraphValidator::check_node(const Node &node, NodeState &state) {
+    std::vector<ValidationIssue> issues;
+    std::vector<NodeId> producers;
+
+    const auto *func = lib->find(node.func_id);
+    if (func == nullptr) {
+        issues.push_back(ValidationIssue{ValidationIssueKind::MissingFunc, node.id, 0});
+    }
+
+    const auto arg_count = func != nullptr ? func->args.size() : node.inputs.size();
+    for (uint32_t arg_idx = 0; arg_idx < arg_count; ++arg_idx) {
+        const FuncArg *arg = func != nullptr ? &func->args[arg_idx] : nullptr;
+        if (arg != nullptr && arg->type != FuncArgType::In) {
+            continue;
+        }
+
+        const NodeInput *input = arg_idx < node.inputs.size() ? &node.inputs[arg_idx] : nullptr;
+        const auto binding = input != nullptr ? input->binding : BindingType::None;
+        const bool required = arg != nullptr && arg->required;
+
+        switch (binding) {
+            case BindingType::None:
+                if (required) {
+                    issues.push_back(ValidationIssue{ValidationIssueKind::UnboundInput, node.id, arg_idx});
+                }
+                break;
+
+            case BindingType::Const:
+                if (required && !input->value.has_value()) {
+                    issues.push_back(ValidationIssue{ValidationIssueKind::UnboundInput, node.id, arg_idx});
+                }
+                break;
+
+            case BindingType::Binding: {
+                producers.push_back(input->output_node_id);
+
+                const auto *producer = locate(input->output_node_id);
+                if (producer == nullptr) {
+                    issues.push_back(ValidationIssue{ValidationIssueKind::UnknownNode, node.id, arg_idx});
+                    break;
+                }
+                const auto *producer_func = lib->find(producer->func_id);
+                if (producer_func == nullptr) {
+                    break; // reported on the producer
+                }
+                const auto *output = find_output_arg(*producer_func, input->output_idx);
+                if (output == nullptr) {
+                    issues.push_back(ValidationIssue{ValidationIssueKind::UnknownOutput, node.id, arg_idx});
+                } else if (arg != nullptr && output->datatype != arg->datatype) {
+                    issues.push_back(ValidationIssue{ValidationIssueKind::DatatypeMismatch, node.id, arg_idx});
+                }
+                break;
+            }
+        }
+    }
+
+    set_issues(state, std::move(issues));
+
+    std::sort(producers.begin(), producers.end());
+    producers.erase(std::unique(producers.begin(), producers.end()), producers.end());
+    if (producers == state.producers) {
+        return;
+    }
+
+    for (const auto &producer: state.producers) {
+        if (!std::binary_search(producers.begin(), producers.end(), producer)) {
+            auto &consumers = nodes.contains(producer) ? nodes[producer].consumers : dangling[producer];
+            std::erase(consumers, node.id);
+            if (consumers.empty()) {
+                dangling.erase(producer);
+            }
+            if (lost_edges.empty() || lost_edges.back() != node.id) {
+                lost_edges.push_back(node.id);
+            }
+        }
+    }
+    for (const auto &producer: producers) {
+        if (!std::binary_search(state.producers.begin(), state.producers.end(), producer)) {
+            if (locate(producer) != nullptr) {
+                nodes[producer].consumers.push_back(node.id);
+                new_edges.emplace_back(producer, node.id);
+            } else {
+                dangling[producer].push_back(node.id);
+            }
+        }
+    }
+    state.producers = std::move(producers);
+}
+
+void GraphValidator::find_cycles(const std::unordered_set<NodeId, UuidHash> *region) {
+    // iterative Tarjan, nodes of every strongly connected component with an edge inside are cyclic
+    struct Frame {
+        const NodeId *id;
+        size_t next_producer;
+    };
+
+    std::unordered_map<NodeId, uint32_t, UuidHash> order;
+    std::unordered_map<NodeId, uint32_t, UuidHash> low;
+    std::unordered_set<NodeId, UuidHash> on_stack;
+    std::vector<const NodeId *> component_stack;
+    std::vector<Frame> frames;
+    uint32_t counter = 0;
+
+    auto visit = [&](const NodeId &root) {
+        if (order.contains(root)) {
+            return;
+        }
+
+        frames.push_back(Frame{&root, 0});
+        order[root] = low[root] = counter++;
+        component_stack.push_back(&root);
+        on_stack.insert(root);
+
+        while (!frames.empty()) {
+            auto &frame = frames.back();
+            const auto &producers = nodes[*frame.id].producers;
+
+            if (frame.next_producer < producers.size()) {
+                const auto &next = producers[frame.next_producer++];
+                auto next_it = nodes.find(next);
+                if (next_it == nodes.end() || (region != nullptr && !region->contains(next))) {
+                    continue;
+                }
+                if (!order.contains(next)) {
+                    order[next] = low[next] = counter++;
+                    component_stack.push_back(&next_it->first);
+                    on_stack.insert(next);
+                    frames.push_back(Frame{&next_it->first, 0});
+                } else if (on_stack.contains(next)) {
+                    low[*frame.id] = std::min(low[*frame.id], order[next]);
+                }
+                continue;
+            }
+
+            const auto &id = *frame.id;
+            frames.pop_back();
+            if (!frames.empty()) {
+                auto &parent = *frames.back().id;
+                low[parent] = std::min(low[parent], low[id]);
+            }
+            if (low[id] != order[id]) {
+                continue;
+            }
+
+            std::vector<const NodeId *> component;
+            while (true) {
+                const auto *member = component_stack.back();
+                component_stack.pop_back();
+                on_stack.erase(*member);
+                component.push_back(member);
+                if (*member == id) {
+                    break;
+                }
+            }
+            const bool self_loop = std::binary_search(nodes[id].producers.begin(), nodes[id].producers.end(), id);
+            if (component.size() > 1 || self_loop) {
+                for (const auto *member: component) {
+                    cyclic.insert(*member);
+                }
+            }
+        }
+    };
+
+    if (region == nullptr) {
+        cyclic.clear();
+        for (const auto &[root, root_state]: nodes) {
+            visit(root);
+        }
+    } else {
+        for (const auto &root: *region) {
+            visit(root);
+        }
+    }
+}
+
+void GraphValidator::break_cycles() {
+    // A cycle that lost an edge passes through a node that lost a producer. The cycles the
+    // cyclic nodes connected to those nodes form now are found among them alone, other cycles
+    // are intact.
+    std::unordered_set<NodeId, UuidHash> region;
+    std::vector<NodeId> stack;
+    for (const auto &id: lost_edges) {
+        if (cyclic.contains(id) && region.insert(id).second) {
+            stack.push_back(id);
+        }
+    }
+    while (!stack.empty()) {
+        const auto it = nodes.find(stack.back());
+        stack.pop_back();
+        if (it == nodes.end()) {
+            continue;
+        }
+        for (const auto *neighbours: {&it->second.producers, &it->second.consumers}) {
+            for (const auto &next: *neighbours) {
+                if (cyclic.contains(next) && region.insert(next).second) {
+                    stack.push_back(next);
+                }
+            }
+        }
+    }
+
+    for (const auto &id: region) {
+        cyclic.erase(id);
+    }
+    find_cycles(&region);
+}
+
+void GraphValidator::join_cycles() {
+    // The edges are added one by one, the search of each skips those not added yet. An edge from
+    // u to v closes a cycle if v already reaches u, the nodes on the way join it. Without a cycle
+    // in the graph a node only reaches nodes of higher levels, so the search stays below u.
+    std::unordered_map<NodeId, std::vector<NodeId>, UuidHash> not_added; // producer -> consumers
+    for (const auto &[producer, consumer]: new_edges) {
+        not_added[producer].push_back(consumer);
+    }
+    auto added = [&not_added](const NodeId &producer, const NodeId &consumer) {
+        auto it = not_added.find(producer);
+        return it == not_added.end() || std::ranges::find(it->second, consumer) == it->second.end();
+    };
+
+    std::unordered_set<NodeId, UuidHash> downstream;
+    std::unordered_set<NodeId, UuidHash> members;
+    std::vector<NodeId> stack;
+    for (const auto &[producer, consumer]: new_edges) {
+        auto &waiting = not_added[producer];
+        waiting.erase(std::ranges::find(waiting, consumer));
+        if (!nodes.contains(producer) || !nodes.contains(consumer)) {
+            continue;
+        }
+        const auto limit = nodes[producer].level;
+
+        downstream.clear();
+        downstream.insert(consumer);
+        stack.assign(1, consumer);
+        while (!stack.empty()) {
+            const auto current = stack.back();
+            stack.pop_back();
+            if (current == producer) {
+                continue;
+            }
+            for (const auto &next: nodes[current].consumers) {
+                if (downstream.contains(next) || !added(current, next)) {
+                    continue;
+                }
+                if (next == producer || !levels_valid || nodes[next].level < limit) {
+                    downstream.insert(next);
+                    stack.push_back(next);
+                }
+            }
+        }
+
+        if (!downstream.contains(producer)) {
+            // no cycle, the levels past the edge move up where they have to
+            if (!levels_valid || nodes[consumer].level > limit) {
+                continue;
+            }
+            nodes[consumer].level = limit + 1;
+            stack.assign(1, consumer);
+            while (!stack.empty()) {
+                const auto current = stack.back();
+                stack.pop_back();
+                const auto level = nodes[current].level;
+                for (const auto &next: nodes[current].consumers) {
+                    if (added(current, next) && nodes[next].level <= level) {
+                        nodes[next].level = level + 1;
+                        stack.push_back(next);
+                    }
+                }
+            }
+            continue;
+        }
+
+        // the members are the nodes downstream of v that reach u
+        levels_valid = false;
+        members.clear();
+        members.insert(producer);
+        stack.assign(1, producer);
+        while (!stack.empty()) {
+            const auto current = stack.back();
+            stack.pop_back();
+            for (const auto &next: nodes[current].producers) {
+                if (downstream.contains(next) && added(next, current) && members.insert(next).second) {
+                    stack.push_back(next);
+                }
+            }
+        }
+        cyclic.insert(members.begin(), members.end());
+    }
+}
+
+void GraphValidator::assign_levels() {
+    // Kahn's algorithm, only called while there are no cycles
+    std::unordered_map<NodeId, uint32_t, UuidHash> in_degree;
+    std::vector<NodeId> stack;
+    for (auto &[id, state]: nodes) {
+        state.level = 0;
+        const auto degree = static_cast<uint32_t>(std::ranges::count_if(state.producers, [this](const NodeId &producer) {
+            return nodes.contains(producer);
+        }));
+        in_degree[id] = degree;
+        if (degree == 0) {
+            stack.push_back(id);
+        }
+    }
+    while (!stack.empty()) {
+        const auto id = stack.back();
+        stack.pop_back();
+        const auto &state = nodes[id];
+        for (const auto &consumer: state.consumers) {
+            auto &consumer_state = nodes[consumer];
+            consumer_state.level = std::max(consumer_state.level, state.level + 1);
+            if (--in_degree[consumer] == 0) {
+                stack.push_back(consumer);
+            }
+        }
+    }
+    levels_valid = true;
+}
+
+void GraphValidator::set_issues(NodeState &state, std::vector<ValidationIssue> issues) {
+    // from the back, so that the issue moved into a freed slot is never one of this node's
+    std::ranges::sort(state.issue_slots, std::greater{});
+    for (const auto slot: state.issue_slots) {
+        remove_issue(slot);
+    }
+    state.issue_slots.clear();
+    for (auto &issue: issues) {
+        state.issue_slots.push_back(static_cast<uint32_t>(issue_list.size()));
+        issue_list.push_back(std::move(issue));
+    }
+}
+
+void GraphValidator::remove_issue(uint32_t slot) {
+    const auto last = static_cast<uint32_t>(issue_list.size() - 1);
+    if (slot != last) {
+        auto &slots = nodes[issue_list[last].node_id].issue_slots;
+        *std::ranges::find(slots, last) = slot;
+        issue_list[slot] = issue_list[last];
+    }
+    issue_list.pop_back();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "func.hpp"
+#include "graph.hpp"
+
+#include "utils/nocopy.hpp"
+#include "utils/utils.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+
+enum class ValidationIssueKind : uint8_t {
+    MissingFunc,
+    UnboundInput,     // required In arg without a binding or Const value
+    UnknownNode,      // binding to a node that is not in the graph
+    UnknownOutput,    // binding to an output index the producer func does not have
+    DatatypeMismatch, // producer Out arg and consumer In arg datatypes differ
+    Cycle,
+};
+
+std::string to_string(const ValidationIssueKind &kind);
+
+struct ValidationIssue {
+    ValidationIssueKind kind = ValidationIssueKind::MissingFunc;
+    NodeId node_id{};
+    uint32_t arg_idx = 0; // into Func::args, unused for MissingFunc and Cycle
+};
+
+
+// Validates a graph once in full and afterwards only the nodes reported through touch(),
+// plus the nodes whose result depends on them: consumers of an edited node and nodes bound to
+// a node id that just appeared. Cycles are only looked for around the edges that changed: while
+// the graph has none, every node keeps a level above those of its producers, which bounds the
+// search a new edge starts.
+//
+// Between calls nodes may be inserted, erased and edited in place, the others are expected to
+// keep their order. Each node remembers its position, only the positions behind the first
+// insert or erase are looked up again.
+struct GraphValidator {
+    NOCOPY(GraphValidator)
+
+    struct NodeState {
+        uint32_t index_hint = 0;
+        uint32_t level = 0; // above the levels of the producers, while levels_valid
+        std::vector<NodeId> producers;
+        std::vector<NodeId> consumers;
+        std::vector<uint32_t> issue_slots; // into issue_list
+    };
+
+    const Graph *graph;
+    const FuncLib *lib;
+
+    std::unordered_map<NodeId, NodeState, UuidHash> nodes;
+    std::unordered_map<NodeId, std::vector<NodeId>, UuidHash> dangling; // missing producer -> consumers
+    std::unordered_set<NodeId, UuidHash> dirty;
+    std::unordered_set<NodeId, UuidHash> cyclic;
+    std::vector<std::pair<NodeId, NodeId>> new_edges; // producer and consumer, during validate()
+    std::vector<NodeId> lost_edges;                   // consumers that lost a producer, likewise
+    std::vector<ValidationIssue> issue_list; // of all nodes, in no particular order
+    bool validated = false;
+    bool index_fresh = false; // every hint was checked during this validate()
+    bool levels_valid = false;
+
+    GraphValidator(const Graph &graph, const FuncLib &lib);
+
+    // node was added, edited or removed
+    void touch(const NodeId &id);
+
+    // Full pass on the first call, incremental afterwards. Returns true if there are no issues.
+    bool validate();
+
+    [[nodiscard]] std::vector<ValidationIssue> issues() const;
+
+    const Node *locate(const NodeId &id);
+
+    // re-hints the positions behind the first insert or erase since the last call
+    void update_index();
+
+    // hints the nodes from position first on, touched ones get a state if they have none
+    void rehint(uint32_t first);
+
+    void forget(const NodeId &id);
+
+    // records the edges the node gained and whether it lost any
+    void check_node(const Node &node, NodeState &state);
+
+    // Tarjan over the nodes of region and the edges between them, or over the whole graph
+    void find_cycles(const std::unordered_set<NodeId, UuidHash> *region);
+
+    // reclassifies the cycles that lost_edges may have broken
+    void break_cycles();
+
+    // finds the cycles new_edges closed and keeps the levels up to date otherwise
+    void join_cycles();
+
+    void assign_levels();
+
+    void set_issues(NodeState &state, std::vector<ValidationIssue> issues);
+
+    void remove_issue(uint32_t slot);
+};
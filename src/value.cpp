@@ -0,0 +1,146 @@
+#include "value.hpp"
+
+#include "utils/utils.hpp"
+
+#include <cstring>
+
+
+Value::Value(DatatypeId datatype) : heap(nullptr) {
+    if (datatype == DatatypeNone) {
+        return;
+    }
+    const auto &type = get_datatype(datatype);
+    type.ops.construct(allocate(type));
+    this->datatype = datatype;
+}
+
+Value::Value(const Value &other) : heap(nullptr) {
+    if (other.empty()) {
+        return;
+    }
+    const auto &type = get_datatype(other.datatype);
+    type.ops.copy(allocate(type), other.data());
+    datatype = other.datatype;
+}
+
+Value::Value(Value &&other) noexcept: heap(nullptr) {
+    if (other.empty()) {
+        return;
+    }
+    const auto &type = get_datatype(other.datatype);
+    if (is_inline(type)) {
+        type.ops.move(storage, other.storage);
+        type.ops.destroy(other.storage);
+    } else {
+        heap = std::exchange(other.heap, nullptr);
+    }
+    datatype = std::exchange(other.datatype, DatatypeNone);
+}
+
+Value &Value::operator=(const Value &other) {
+    if (this != &other) {
+        Value copy{other};
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+Value &Value::operator=(Value &&other) noexcept {
+    if (this != &other) {
+        reset();
+        new(this) Value(std::move(other));
+    }
+    return *this;
+}
+
+Value::~Value() {
+    reset();
+}
+
+void *Value::data() {
+    return empty() || is_inline(get_datatype(datatype)) ? storage : heap;
+}
+
+const void *Value::data() const {
+    return empty() || is_inline(get_datatype(datatype)) ? storage : heap;
+}
+
+void Value::reset() {
+    if (empty()) {
+        return;
+    }
+    const auto &type = get_datatype(datatype);
+    type.ops.destroy(data());
+    if (!is_inline(type)) {
+        ::operator delete(heap, std::align_val_t{type.alignment});
+        heap = nullptr;
+    }
+    datatype = DatatypeNone;
+}
+
+void *Value::allocate(const Datatype &type) {
+    assert(empty());
+    if (is_inline(type)) {
+        return storage;
+    }
+    heap = ::operator new(type.size, std::align_val_t{type.alignment});
+    return heap;
+}
+
+
+uint64_t hash_value(const Value &value) {
+    if (value.empty()) {
+        return 0;
+    }
+    return hash_combine(value.datatype, get_datatype(value.datatype).ops.hash(value.data()));
+}
+
+bool operator==(const Value &lhs, const Value &rhs) {
+    if (lhs.datatype != rhs.datatype) {
+        return false;
+    }
+    return lhs.empty() || get_datatype(lhs.datatype).ops.equal(lhs.data(), rhs.data());
+}
+
+void emit_value(YAML::Emitter &out, const Value &value) {
+    if (value.empty()) {
+        out << YAML::Null;
+        return;
+    }
+
+    const auto &type = get_datatype(value.datatype);
+    if (type.ops.emit != nullptr) {
+        type.ops.emit(out, value.data());
+        return;
+    }
+    assert(type.trivial);
+    out << YAML::Binary(static_cast<const unsigned char *>(value.data()), type.size);
+}
+
+bool parse_value(const YAML::Node &node, DatatypeId datatype, Value &value) {
+    if (node.IsNull()) {
+        value.reset();
+        return true;
+    }
+    if (!datatype_registry().contains(datatype) || datatype == DatatypeNone) {
+        return false;
+    }
+
+    const auto &type = get_datatype(datatype);
+    Value parsed{datatype};
+    if (type.ops.parse != nullptr) {
+        if (!type.ops.parse(node, parsed.data())) {
+            return false;
+        }
+    } else if (type.trivial && node.IsScalar()) {
+        const auto bytes = YAML::DecodeBase64(node.Scalar());
+        if (bytes.size() != type.size) {
+            return false;
+        }
+        std::memcpy(parsed.data(), bytes.data(), bytes.size());
+    } else {
+        return false;
+    }
+    value = std::move(parsed);
+    return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "datatype.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+// Single value of a registered datatype, DatatypeNone means no value. Values up to InlineSize
+// bytes live inside the Value, larger ones on the heap; copies, moves, hashing and comparison
+// go through the DatatypeOps of the datatype.
+struct Value {
+    static constexpr size_t InlineSize = 16;
+    static constexpr size_t InlineAlignment = 16;
+
+    DatatypeId datatype = DatatypeNone;
+    union {
+        alignas(InlineAlignment) std::byte storage[InlineSize];
+        void *heap;
+    };
+
+    Value() : heap(nullptr) {}
+
+    // default constructed value of the datatype, empty for DatatypeNone
+    explicit Value(DatatypeId datatype);
+
+    Value(const Value &other);
+
+    Value(Value &&other) noexcept;
+
+    Value &operator=(const Value &other);
+
+    Value &operator=(Value &&other) noexcept;
+
+    ~Value();
+
+    [[nodiscard]] bool empty() const { return datatype == DatatypeNone; }
+
+    [[nodiscard]] void *data();
+
+    [[nodiscard]] const void *data() const;
+
+    void reset();
+
+    [[nodiscard]] static bool is_inline(const Datatype &datatype) {
+        return datatype.size <= InlineSize && datatype.alignment <= InlineAlignment;
+    }
+
+    // storage for the datatype without constructing anything in it
+    [[nodiscard]] void *allocate(const Datatype &type);
+};
+
+using NodeOutputs = std::vector<Value>;
+
+
+template<typename T>
+Value make_value(DatatypeId datatype, T value) {
+    assert(get_datatype(datatype).size == sizeof(T));
+    Value result{};
+    new(result.allocate(get_datatype(datatype))) T(std::move(value));
+    result.datatype = datatype;
+    return result;
+}
+
+// returns T{} for empty values
+template<typename T>
+T value_as(const Value &value) {
+    if (value.empty()) {
+        return T{};
+    }
+    assert(get_datatype(value.datatype).size == sizeof(T));
+    return *static_cast<const T *>(value.data());
+}
+
+uint64_t hash_value(const Value &value);
+
+bool operator==(const Value &lhs, const Value &rhs);
+
+// emits through DatatypeOps::emit, trivial datatypes without it as base64 binary
+void emit_value(YAML::Emitter &out, const Value &value);
+
+// Reads what emit_value() wrote for a value of datatype, null gives an empty value. Returns
+// false if node does not hold one.
+bool parse_value(const YAML::Node &node, DatatypeId datatype, Value &value);
@@ -0,0 +1,269 @@
+#include "yaml_writer.hpp"
+
+#include "utils/uuid_text.hpp"
+
+#include <yaml-cpp/yaml.h>
+
+#include <charconv>
+#include <string_view>
+
+
+static void write_indent(std::string &out, uint32_t indent) {
+    out += '\n';
+    out.append(indent, ' ');
+}
+
+// key of a map at indent, on a new line unless it is the first key after "- " or of the document
+static void write_key(std::string &out, uint32_t indent, std::string_view key, bool first = false) {
+    if (!first) {
+        write_indent(out, indent);
+    }
+    out += key;
+    out += ':';
+}
+
+// "- " of a sequence item whose map keys are at indent
+static void write_item(std::string &out, uint32_t indent) {
+    write_indent(out, indent - 2);
+    out += "- ";
+}
+
+static void write_uint(std::string &out, uint64_t value) {
+    char digits[20];
+    auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, end);
+}
+
+static void write_int(std::string &out, int64_t value) {
+    char digits[20];
+    auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, end);
+}
+
+static void write_bool(std::string &out, bool value) {
+    out += value ? "true" : "false";
+}
+
+static void write_uuid(std::string &out, const uuids::uuid &id) {
+    const auto size = out.size();
+    out.resize(size + UuidTextSize);
+    format_uuid(id, out.data() + size);
+}
+
+// Strings YAML::Emitter certainly writes as plain scalars: words of letters, digits and a few
+// punctuation characters, without leading or trailing spaces and not a null.
+static bool is_plain(std::string_view text) {
+    if (text.empty() || text.back() == ' ' || text == "null" || text == "Null" || text == "NULL") {
+        return false;
+    }
+    auto word = [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    };
+    if (!word(text.front())) {
+        return false;
+    }
+    for (const auto c: text) {
+        if (!word(c) && c != ' ' && c != '.' && c != '/' && c != '-') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Lines after the first are shifted by indent, which turns a document of its own into the
+// value of a key at that indent.
+static void append_shifted(std::string &out, std::string_view text, uint32_t indent) {
+    for (size_t start = 0;;) {
+        const auto end = text.find('\n', start);
+        out += text.substr(start, end - start);
+        if (end == std::string_view::npos) {
+            return;
+        }
+        write_indent(out, indent);
+        start = end + 1;
+    }
+}
+
+// what follows "key:" for a string, including the separating space
+static void write_string(std::string &out, std::string_view text) {
+    out += ' ';
+    if (is_plain(text)) {
+        out += text;
+        return;
+    }
+    YAML::Emitter emitter;
+    emitter << std::string(text);
+    out += emitter.c_str();
+}
+
+// "value:" and the value of a Const input, with the key at indent
+static void write_value(std::string &out, uint32_t indent, const Value &value) {
+    if (value.empty()) {
+        write_key(out, indent, "value");
+        out += " ~";
+        return;
+    }
+    switch (value.datatype) {
+        case DatatypeInt:
+            write_key(out, indent, "value");
+            out += ' ';
+            write_int(out, value_as<int32_t>(value));
+            return;
+        case DatatypeInt64:
+            write_key(out, indent, "value");
+            out += ' ';
+            write_int(out, value_as<int64_t>(value));
+            return;
+        case DatatypeBool:
+            write_key(out, indent, "value");
+            out += ' ';
+            write_bool(out, value_as<bool>(value));
+            return;
+        case DatatypeString:
+            write_key(out, indent, "value");
+            write_string(out, *static_cast<const std::string *>(value.data()));
+            return;
+        default:
+            break;
+    }
+
+    // a map of its own puts the value on the same line or below exactly like inside the node
+    YAML::Emitter emitter;
+    emitter << YAML::BeginMap << YAML::Key << "value" << YAML::Value;
+    emit_value(emitter, value);
+    emitter << YAML::EndMap;
+    write_indent(out, indent);
+    append_shifted(out, emitter.c_str(), indent);
+}
+
+static void write_empty_seq(std::string &out, uint32_t indent) {
+    write_indent(out, indent);
+    out += "[]";
+}
+
+// node map with its keys at indent, the first key goes on the current line
+static void write_node(std::string &out, const Node &node, uint32_t indent) {
+    write_key(out, indent, "id", true);
+    out += ' ';
+    write_uuid(out, node.id);
+    write_key(out, indent, "func_id");
+    out += ' ';
+    write_uuid(out, node.func_id);
+    write_key(out, indent, "name");
+    write_string(out, node.name);
+    write_key(out, indent, "is_output");
+    out += ' ';
+    write_bool(out, node.is_output);
+    write_key(out, indent, "cache_outputs");
+    out += ' ';
+    write_bool(out, node.cache_outputs);
+    write_key(out, indent, "timeout_ms");
+    out += ' ';
+    write_uint(out, node.timeout_ms);
+
+    const auto item_indent = indent + 4;
+    write_key(out, indent, "inputs");
+    if (node.inputs.empty()) {
+        write_empty_seq(out, indent + 2);
+    }
+    for (const auto &input: node.inputs) {
+        write_item(out, item_indent);
+        write_key(out, item_indent, "binding", true);
+        switch (input.binding) {
+            case BindingType::None:
+                out += " None";
+                break;
+            case BindingType::Const:
+                out += " Const";
+                write_value(out, item_indent, input.value.value());
+                break;
+            case BindingType::Binding:
+                out += " Binding";
+                write_key(out, item_indent, "output_node_id");
+                out += ' ';
+                write_uuid(out, input.output_node_id);
+                write_key(out, item_indent, "output_idx");
+                out += ' ';
+                write_uint(out, input.output_idx);
+                break;
+        }
+    }
+
+    write_key(out, indent, "events");
+    if (node.events.empty()) {
+        write_empty_seq(out, indent + 2);
+    }
+    for (const auto &event: node.events) {
+        write_item(out, item_indent);
+        write_key(out, item_indent, "subscribers", true);
+        if (event.subscribers.empty()) {
+            write_empty_seq(out, item_indent + 2);
+        }
+        for (const auto &subscriber: event.subscribers) {
+            write_indent(out, item_indent + 2);
+            out += "- ";
+            write_uuid(out, subscriber);
+        }
+    }
+}
+
+
+void write_yaml(std::string &out, const Graph &graph) {
+    if (graph.nodes.empty()) {
+        out += "[]";
+        return;
+    }
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        if (i != 0) {
+            out += '\n';
+        }
+        out += "- ";
+        write_node(out, graph.nodes[i], 2);
+    }
+}
+
+void write_yaml(std::string &out, const Node &node) {
+    write_node(out, node, 0);
+}
+
+void write_yaml(std::string &out, const Func &func) {
+    write_key(out, 0, "id", true);
+    out += ' ';
+    write_uuid(out, func.id);
+    write_key(out, 0, "name");
+    write_string(out, func.name);
+    write_key(out, 0, "behavior");
+    out += func.behavior == FuncBehavior::Pure ? " Pure" : " Impure";
+
+    write_key(out, 0, "args");
+    if (func.args.empty()) {
+        write_empty_seq(out, 2);
+    }
+    for (const auto &arg: func.args) {
+        write_item(out, 4);
+        write_key(out, 4, "name", true);
+        write_string(out, arg.name);
+        write_key(out, 4, "datatype");
+        out += ' ';
+        write_uint(out, arg.datatype);
+        write_key(out, 4, "required");
+        out += ' ';
+        write_bool(out, arg.required);
+        write_key(out, 4, "type");
+        out += arg.type == FuncArgType::In ? " In" : " Out";
+        if (arg.streaming) {
+            write_key(out, 4, "streaming");
+            out += " true";
+        }
+    }
+
+    write_key(out, 0, "events");
+    if (func.events.empty()) {
+        write_empty_seq(out, 2);
+    }
+    for (const auto &event: func.events) {
+        write_item(out, 4);
+        write_key(out, 4, "name", true);
+        write_string(out, event.name);
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "func.hpp"
+#include "graph.hpp"
+
+#include <string>
+
+
+// Append the same text as the YAML::Emitter operator<<s of Graph, Node and Func to out. Keys,
+// indentation and the common scalars (uuids, bools, integers, plain names) are written
+// directly. Anything the emitter might quote or lay out differently, like strings with special
+// characters, floats and tensors, goes through a YAML::Emitter of its own.
+void write_yaml(std::string &out, const Graph &graph);
+
+void write_yaml(std::string &out, const Node &node);
+
+void write_yaml(std::string &out, const Func &func);
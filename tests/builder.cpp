@@ -0,0 +1,86 @@
+#include "src/builder.hpp"
+#include "src/executor.hpp"
+#include "tests/funcs.hpp"
+
+#include <unordered_set>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+TEST_CASE("Builder creates and wires nodes in bulk", "[builder]") {
+    FuncLib lib{{make_add()}};
+    Graph graph{};
+    GraphValidator validator{graph, lib};
+    GraphBuilder builder{graph, &validator};
+
+    // a running sum over 0..count-1
+    const uint32_t count = 10000;
+    builder.reserve(count);
+    const auto first = builder.add_nodes(lib.funcs[0], count);
+    REQUIRE(first == 0);
+    REQUIRE(graph.nodes.size() == count);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (i == 0) {
+            builder.set_const(i, 0, make_value(DatatypeInt, 0));
+        } else {
+            builder.bind(i, 0, i - 1);
+        }
+        builder.set_const(i, 1, make_value(DatatypeInt, static_cast<int>(i)));
+    }
+    graph.nodes.back().is_output = true;
+    REQUIRE(builder.commit());
+
+    std::unordered_set<NodeId, UuidHash> ids;
+    for (const auto &node: graph.nodes) {
+        REQUIRE(node.id.version() == uuids::uuid_version::random_number_based);
+        ids.insert(node.id);
+    }
+    REQUIRE(ids.size() == count);
+
+    Executor executor{ExecutorConfig{.thread_count = 1}};
+    auto tenant = executor.add_tenant();
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+    REQUIRE(value_as<int>(outputs.back()[0]) == static_cast<int>(count * (count - 1) / 2));
+}
+
+TEST_CASE("Builder defers validation to commit", "[builder]") {
+    FuncLib lib{{make_add()}};
+    Graph graph{};
+    GraphValidator validator{graph, lib};
+    GraphBuilder builder{graph, &validator};
+
+    const auto node_idx = builder.add_node(lib.funcs[0]);
+    builder.set_const(node_idx, 0, make_value(DatatypeInt, 1));
+    REQUIRE_FALSE(builder.commit());
+    REQUIRE(validator.issues().size() == 1);
+    REQUIRE(validator.issues()[0].kind == ValidationIssueKind::UnboundInput);
+
+    // a second batch wires the earlier node to a new one
+    const auto producer_idx = builder.add_node(lib.funcs[0]);
+    builder.set_const(producer_idx, 0, make_value(DatatypeInt, 2));
+    builder.set_const(producer_idx, 1, make_value(DatatypeInt, 3));
+    builder.bind(node_idx, 1, producer_idx);
+    REQUIRE(builder.commit());
+    REQUIRE(validator.issues().empty());
+}
+
+TEST_CASE("Builder grows the node vector geometrically", "[builder]") {
+    FuncLib lib{{make_add()}};
+    Graph graph{};
+    GraphBuilder builder{graph};
+
+    size_t reallocations = 0;
+    auto capacity = graph.nodes.capacity();
+    for (uint32_t i = 0; i < 20000; ++i) {
+        REQUIRE(builder.add_node(lib.funcs[0]) == i);
+        if (graph.nodes.capacity() != capacity) {
+            capacity = graph.nodes.capacity();
+            ++reallocations;
+        }
+    }
+    REQUIRE(reallocations <= 20);
+    REQUIRE(graph.nodes[19999].func_id == lib.funcs[0].id);
+    REQUIRE(graph.nodes[19999].inputs.size() == 3);
+    REQUIRE(builder.commit());
+}
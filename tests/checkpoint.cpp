@@ -0,0 +1,288 @@
+#include "src/checkpoint.hpp"
+#include "src/encoding.hpp"
+#include "src/executor.hpp"
+#include "src/utils/utils.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+static std::atomic<int> step_calls{0};
+static CancelToken *preempt_token = nullptr;
+static int preempt_at = 0;
+
+// step(previous) -> previous + 1, cancelling the run when it is called for the preempt_at-th time
+static FuncLib make_lib() {
+    FuncLib lib{};
+
+    Func &step = lib.funcs.emplace_back();
+    step.name = "step";
+    step.args.push_back(FuncArg{"previous", DatatypeInt, true, FuncArgType::In});
+    step.args.push_back(FuncArg{"next", DatatypeInt, true, FuncArgType::Out});
+    step.lambda = [](std::span<const Value> inputs, std::span<Value> outputs) {
+        if (++step_calls == preempt_at && preempt_token != nullptr) {
+            preempt_token->cancel();
+        }
+        outputs[0] = make_value(DatatypeInt, value_as<int>(inputs[0]) + 1);
+    };
+
+    return lib;
+}
+
+static std::shared_ptr<GraphPlan> build_chain(FuncLib &lib, int length) {
+    Graph graph{};
+    for (int i = 0; i < length; ++i) {
+        auto &step = graph.nodes.emplace_back(lib.funcs[0]);
+        if (i == 0) {
+            step.inputs[0].binding = BindingType::Const;
+            step.inputs[0].value = make_value(DatatypeInt, 0);
+        } else {
+            step.inputs[0].binding = BindingType::Binding;
+            step.inputs[0].output_node_id = graph.nodes[i - 1].id;
+        }
+    }
+    graph.nodes.back().is_output = true;
+
+    auto plan = std::make_shared<GraphPlan>();
+    REQUIRE(compile_plan(graph, lib, *plan) == RunResult::Ok);
+    return plan;
+}
+
+
+TEST_CASE("Pre-empted run resumes from its checkpoint", "[checkpoint]") {
+    auto lib = make_lib();
+    auto plan = build_chain(lib, 6);
+    const auto path = (std::filesystem::temp_directory_path() / "c_playground-checkpoint-test.bin").string();
+    std::filesystem::remove(path);
+
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+
+    {
+        Checkpoint checkpoint{};
+        REQUIRE(load_checkpoint(&checkpoint, path));
+        checkpoint.interval = std::chrono::milliseconds(0);
+
+        CancelToken token{};
+        step_calls = 0;
+        preempt_token = &token;
+        preempt_at = 4;
+
+        GraphInstance instance{plan};
+        instance.checkpoint = &checkpoint;
+        REQUIRE(executor.run(tenant, instance, &token) == RunResult::Cancelled);
+        REQUIRE(step_calls == 4);
+        REQUIRE(std::filesystem::exists(path));
+        preempt_token = nullptr;
+    }
+
+    // a new process would load the checkpoint and run the same graph again
+    Checkpoint checkpoint{};
+    REQUIRE(load_checkpoint(&checkpoint, path));
+    REQUIRE(std::ranges::count(checkpoint.completed, 1) == 3);
+
+    step_calls = 0;
+    GraphInstance instance{plan};
+    instance.checkpoint = &checkpoint;
+    REQUIRE(executor.run(tenant, instance) == RunResult::Ok);
+    REQUIRE(step_calls == 3);
+    REQUIRE(value_as<int>(instance.outputs[5][0]) == 6);
+    REQUIRE(value_as<int>(instance.outputs[1][0]) == 2);
+
+    // a completed run leaves nothing to resume
+    REQUIRE_FALSE(std::filesystem::exists(path));
+    step_calls = 0;
+    REQUIRE(executor.run(tenant, instance) == RunResult::Ok);
+    REQUIRE(step_calls == 6);
+}
+
+static std::vector<std::byte> read_file(const std::string &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    std::vector<std::byte> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return bytes;
+}
+
+static void write_file(const std::string &path, std::span<const std::byte> bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+TEST_CASE("Torn and damaged checkpoints", "[checkpoint]") {
+    auto lib = make_lib();
+    auto plan = build_chain(lib, 6);
+    const auto path = (std::filesystem::temp_directory_path() / "c_playground-checkpoint-torn.bin").string();
+    std::filesystem::remove(path);
+
+    Executor executor{ExecutorConfig{.thread_count = 1}};
+    auto tenant = executor.add_tenant();
+    {
+        Checkpoint checkpoint{};
+        REQUIRE(load_checkpoint(&checkpoint, path));
+        checkpoint.interval = std::chrono::milliseconds(0);
+        CancelToken token{};
+        step_calls = 0;
+        preempt_token = &token;
+        preempt_at = 4;
+        GraphInstance instance{plan};
+        instance.checkpoint = &checkpoint;
+        REQUIRE(executor.run(tenant, instance, &token) == RunResult::Cancelled);
+        preempt_token = nullptr;
+    }
+    const auto saved = read_file(path);
+
+    // a crash in the middle of the last append loses only that record, and the next write
+    // starts the file over instead of appending after the torn one
+    write_file(path, std::span(saved).first(saved.size() - 8));
+    {
+        Checkpoint checkpoint{};
+        REQUIRE(load_checkpoint(&checkpoint, path));
+        REQUIRE(std::ranges::count(checkpoint.completed, 1) == 2);
+        REQUIRE(checkpoint.rewrite);
+        REQUIRE(save_checkpoint(checkpoint));
+        REQUIRE(load_checkpoint(&checkpoint, path));
+        REQUIRE(std::ranges::count(checkpoint.completed, 1) == 2);
+        REQUIRE_FALSE(checkpoint.rewrite);
+
+        step_calls = 0;
+        GraphInstance instance{plan};
+        instance.checkpoint = &checkpoint;
+        REQUIRE(executor.run(tenant, instance) == RunResult::Ok);
+        REQUIRE(step_calls == 4);
+        REQUIRE(value_as<int>(instance.outputs[5][0]) == 6);
+    }
+
+    // cut inside the header, or not a checkpoint at all
+    Checkpoint checkpoint{};
+    write_file(path, std::span(saved).first(20));
+    REQUIRE_FALSE(load_checkpoint(&checkpoint, path));
+    auto damaged = saved;
+    damaged[0] = std::byte{0};
+    write_file(path, damaged);
+    REQUIRE_FALSE(load_checkpoint(&checkpoint, path));
+
+    // a record with a valid checksum over a payload that does not decode: the first record
+    // follows the header, its payload claims more values than it holds
+    damaged = saved;
+    const auto payload = damaged.data() + 32 + 16;
+    store_u32(payload, 1000);
+    const auto checksum = hash_bytes(payload, load_u32(damaged.data() + 32 + 4));
+    std::memcpy(damaged.data() + 32 + 8, &checksum, sizeof(checksum));
+    write_file(path, damaged);
+    REQUIRE_FALSE(load_checkpoint(&checkpoint, path));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Checkpoint of other Const inputs is not used", "[checkpoint]") {
+    auto lib = make_lib();
+    auto plan = build_chain(lib, 4);
+    const auto path = (std::filesystem::temp_directory_path() / "c_playground-checkpoint-const.bin").string();
+
+    Executor executor{ExecutorConfig{.thread_count = 1}};
+    auto tenant = executor.add_tenant();
+
+    Checkpoint checkpoint{};
+    REQUIRE(load_checkpoint(&checkpoint, path));
+    GraphInstance instance{plan};
+    instance.checkpoint = &checkpoint;
+
+    CancelToken token{};
+    token.cancel();
+    REQUIRE(executor.run(tenant, instance, &token) == RunResult::Cancelled);
+
+    // complete the first two nodes by hand, then change the input they were computed from
+    checkpoint.completed[0] = 1;
+    checkpoint.outputs[0] = {make_value(DatatypeInt, 1)};
+    checkpoint.completed[1] = 1;
+    checkpoint.outputs[1] = {make_value(DatatypeInt, 2)};
+    REQUIRE(save_checkpoint(checkpoint));
+    REQUIRE(load_checkpoint(&checkpoint, path));
+
+    instance.set_const(0, 0, make_value(DatatypeInt, 10));
+    step_calls = 0;
+    REQUIRE(executor.run(tenant, instance) == RunResult::Ok);
+    REQUIRE(step_calls == 4);
+    REQUIRE(value_as<int>(instance.outputs[3][0]) == 14);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Checkpoint does not restore consumers of unsaved producers", "[checkpoint]") {
+    // strings other than DatatypeString are not trivial, so checkpoints cannot encode them
+    constexpr DatatypeId DatatypeText = 110;
+    if (!datatype_registry().contains(DatatypeText)) {
+        datatype_registry().add(make_datatype<std::string>(DatatypeText, "text"));
+    }
+
+    static std::atomic<int> count_calls{0};
+    static CancelToken *cancel_in_last = nullptr;
+    FuncLib lib{};
+    Func &load = lib.funcs.emplace_back();
+    load.name = "load";
+    load.args.push_back(FuncArg{"values", DatatypeText, true, FuncArgType::Out});
+    load.lambda = [](std::span<const Value>, std::span<Value> outputs) {
+        outputs[0] = make_value(DatatypeText, std::string("abc"));
+    };
+    Func &count = lib.funcs.emplace_back();
+    count.name = "count";
+    count.args.push_back(FuncArg{"values", DatatypeText, true, FuncArgType::In});
+    count.args.push_back(FuncArg{"count", DatatypeInt, true, FuncArgType::Out});
+    count.lambda = [](std::span<const Value> inputs, std::span<Value> outputs) {
+        ++count_calls;
+        outputs[0] = make_value(DatatypeInt, static_cast<int>(value_as<std::string>(inputs[0]).size()));
+    };
+    Func &last = lib.funcs.emplace_back();
+    last.name = "last";
+    last.args.push_back(FuncArg{"count", DatatypeInt, true, FuncArgType::In});
+    last.args.push_back(FuncArg{"result", DatatypeInt, true, FuncArgType::Out});
+    last.lambda = [](std::span<const Value> inputs, std::span<Value> outputs) {
+        if (cancel_in_last != nullptr) {
+            cancel_in_last->cancel();
+        }
+        outputs[0] = make_value(DatatypeInt, value_as<int>(inputs[0]) * 10);
+    };
+
+    // load -> count -> last
+    Graph graph{};
+    for (const auto &func: lib.funcs) {
+        auto &node = graph.nodes.emplace_back(func);
+        if (graph.nodes.size() > 1) {
+            node.inputs[0].binding = BindingType::Binding;
+            node.inputs[0].output_node_id = graph.nodes[graph.nodes.size() - 2].id;
+        }
+    }
+    graph.nodes.back().is_output = true;
+    auto plan = std::make_shared<GraphPlan>();
+    REQUIRE(compile_plan(graph, lib, *plan) == RunResult::Ok);
+
+    const auto path = (std::filesystem::temp_directory_path() / "c_playground-checkpoint-unsaved.bin").string();
+    std::filesystem::remove(path);
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+
+    {
+        Checkpoint checkpoint{};
+        REQUIRE(load_checkpoint(&checkpoint, path));
+        checkpoint.interval = std::chrono::milliseconds(0);
+        CancelToken token{};
+        cancel_in_last = &token;
+        GraphInstance instance{plan};
+        instance.checkpoint = &checkpoint;
+        REQUIRE(executor.run(tenant, instance, &token) == RunResult::Cancelled);
+        cancel_in_last = nullptr;
+        REQUIRE(checkpoint.completed == std::vector<uint8_t>{0, 1, 0});
+    }
+
+    // load runs again, so count has to as well
+    Checkpoint checkpoint{};
+    REQUIRE(load_checkpoint(&checkpoint, path));
+    count_calls = 0;
+    GraphInstance instance{plan};
+    instance.checkpoint = &checkpoint;
+    REQUIRE(executor.run(tenant, instance) == RunResult::Ok);
+    REQUIRE(count_calls == 1);
+    REQUIRE(value_as<int>(instance.outputs[2][0]) == 30);
+}
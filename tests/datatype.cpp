@@ -0,0 +1,119 @@
+#include "src/graph.hpp"
+#include "src/value.hpp"
+
+#include <limits>
+#include <string>
+#include <thread>
+#include <yaml-cpp/yaml.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+struct Vec3 {
+    float x, y, z;
+
+    bool operator==(const Vec3 &other) const = default;
+};
+
+constexpr DatatypeId DatatypeVec3 = 100;
+
+static void register_vec3() {
+    if (!datatype_registry().contains(DatatypeVec3)) {
+        datatype_registry().add(make_datatype<Vec3>(DatatypeVec3, "vec3"));
+    }
+}
+
+
+// destroyed at exit, after any function-local static of the library
+static Value value_until_exit{};
+
+TEST_CASE("Builtin datatypes have layouts", "[datatype]") {
+    REQUIRE(get_datatype(DatatypeInt).size == sizeof(int32_t));
+    REQUIRE(get_datatype(DatatypeDouble).alignment == alignof(double));
+    REQUIRE(get_datatype(DatatypeFloat).trivial);
+    REQUIRE_FALSE(get_datatype(DatatypeString).trivial);
+}
+
+TEST_CASE("Values in statics outlive the registry lookups", "[datatype]") {
+    value_until_exit = make_value(DatatypeString, std::string("freed through the registry at exit"));
+    REQUIRE(value_as<std::string>(value_until_exit) == "freed through the registry at exit");
+}
+
+TEST_CASE("Values copy, move, hash and compare through the registry", "[datatype]") {
+    auto text = make_value(DatatypeString, std::string(100, 'x'));
+    auto copy = text;
+    REQUIRE(copy == text);
+    REQUIRE(hash_value(copy) == hash_value(text));
+
+    auto moved = std::move(copy);
+    REQUIRE(copy.empty());
+    REQUIRE(value_as<std::string>(moved) == std::string(100, 'x'));
+
+    REQUIRE_FALSE(make_value(DatatypeInt, 1) == make_value(DatatypeInt, 2));
+    REQUIRE_FALSE(make_value(DatatypeInt, 1) == make_value(DatatypeFloat, 1.0f));
+    REQUIRE(Value(DatatypeDouble) == make_value(DatatypeDouble, 0.0));
+    REQUIRE(Value(DatatypeNone).empty());
+
+    register_vec3();
+    auto vec = make_value(DatatypeVec3, Vec3{1, 2, 3});
+    REQUIRE(value_as<Vec3>(Value(vec)) == Vec3{1, 2, 3});
+}
+
+TEST_CASE("Floats hash and compare by their bytes", "[datatype]") {
+    // the output cache needs equal values to hash alike, NaN included
+    const auto nan = make_value(DatatypeDouble, std::numeric_limits<double>::quiet_NaN());
+    REQUIRE(nan == Value(nan));
+    REQUIRE(hash_value(nan) == hash_value(Value(nan)));
+
+    const auto zero = make_value(DatatypeFloat, 0.0f);
+    const auto negative_zero = make_value(DatatypeFloat, -0.0f);
+    REQUIRE_FALSE(zero == negative_zero);
+    REQUIRE(hash_value(zero) != hash_value(negative_zero));
+}
+
+TEST_CASE("Datatypes can be registered while others are looked up", "[datatype]") {
+    constexpr DatatypeId first = 200;
+    bool consistent = true;
+    std::thread reader([&consistent] {
+        for (int i = 0; i < 10000; ++i) {
+            consistent &= get_datatype(DatatypeInt).size == sizeof(int32_t);
+        }
+    });
+    for (DatatypeId id = first; id < first + 16; ++id) {
+        if (!datatype_registry().contains(id)) {
+            datatype_registry().add(make_datatype<int64_t>(id, "wide"));
+        }
+    }
+    reader.join();
+    REQUIRE(consistent);
+    REQUIRE(get_datatype(first + 15).size == sizeof(int64_t));
+}
+
+TEST_CASE("Batch hash kernels agree with scalar hash", "[datatype]") {
+    const auto &type = get_datatype(DatatypeFloat);
+    REQUIRE(type.ops.hash_batch != nullptr);
+
+    float values[37];
+    for (int i = 0; i < 37; ++i) {
+        values[i] = static_cast<float>(i) * 0.5f;
+    }
+    uint64_t hashes[37];
+    hash_values(type, values, 37, hashes);
+    for (int i = 0; i < 37; ++i) {
+        REQUIRE(hashes[i] == type.ops.hash(&values[i]));
+    }
+}
+
+TEST_CASE("Const inputs are emitted through the registry", "[datatype][serialization]") {
+    Func func{};
+    func.name = "func";
+    func.args.push_back(FuncArg{"arg", DatatypeInt, true, FuncArgType::In});
+
+    Node node{func};
+    node.inputs[0].binding = BindingType::Const;
+    node.inputs[0].value = make_value(DatatypeInt, 42);
+
+    YAML::Emitter out;
+    out << node;
+    REQUIRE(std::string(out.c_str()).find("value: 42") != std::string::npos);
+}
@@ -0,0 +1,288 @@
+#include "src/executor.hpp"
+#include "tests/funcs.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+static std::atomic<int> add_calls{0};
+
+static FuncLib make_lib() {
+    return FuncLib{{make_identity(), make_add(FuncBehavior::Pure, true, &add_calls)}};
+}
+
+// constant(a) + constant(b)
+static void build_sum_graph(Graph &graph, FuncLib &lib, int a, int b) {
+    auto &constant = lib.funcs[0];
+    auto &add = lib.funcs[1];
+
+    auto &lhs = graph.nodes.emplace_back(constant);
+    lhs.inputs[0].binding = BindingType::Const;
+    lhs.inputs[0].value = make_value(1, a);
+
+    auto &rhs = graph.nodes.emplace_back(constant);
+    rhs.inputs[0].binding = BindingType::Const;
+    rhs.inputs[0].value = make_value(1, b);
+
+    auto &sum = graph.nodes.emplace_back(add);
+    sum.is_output = true;
+    sum.inputs[0].binding = BindingType::Binding;
+    sum.inputs[0].output_node_id = graph.nodes[0].id;
+    sum.inputs[1].binding = BindingType::Binding;
+    sum.inputs[1].output_node_id = graph.nodes[1].id;
+}
+
+
+TEST_CASE("Executor evaluates a graph", "[executor]") {
+    auto lib = make_lib();
+    Graph graph{};
+    build_sum_graph(graph, lib, 2, 3);
+
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+    REQUIRE(value_as<int>(outputs[2][0]) == 5);
+}
+
+TEST_CASE("Executor shares Pure outputs across tenants", "[executor]") {
+    auto lib = make_lib();
+    constexpr int graph_count = 16;
+    std::vector<Graph> graphs(graph_count);
+    for (auto &graph: graphs) {
+        build_sum_graph(graph, lib, 20, 22);
+    }
+
+    Executor executor{ExecutorConfig{.thread_count = 4}};
+    add_calls = 0;
+
+    std::vector<std::thread> callers;
+    std::atomic<int> correct{0};
+    for (auto &graph: graphs) {
+        auto tenant = executor.add_tenant(TenantQuota{.max_in_flight = 2});
+        callers.emplace_back([&, tenant] {
+            std::vector<NodeOutputs> outputs;
+            if (executor.run(tenant, graph, lib, outputs) == RunResult::Ok && value_as<int>(outputs[2][0]) == 42) {
+                ++correct;
+            }
+        });
+    }
+    for (auto &caller: callers) {
+        caller.join();
+    }
+
+    REQUIRE(correct == graph_count);
+    REQUIRE(add_calls == 1);
+}
+
+TEST_CASE("Executor respects per-tenant quota", "[executor]") {
+    FuncLib lib{};
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+
+    Func &slow = lib.funcs.emplace_back();
+    slow.name = "slow";
+    slow.args.push_back(FuncArg{"result", 1, true, FuncArgType::Out});
+    slow.lambda = [&](std::span<const Value>, std::span<Value> outputs) {
+        auto now = ++running;
+        auto seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        --running;
+        outputs[0] = make_value(1, 1);
+    };
+
+    Graph graph{};
+    for (int i = 0; i < 8; ++i) {
+        graph.nodes.emplace_back(slow).is_output = true;
+    }
+
+    Executor executor{ExecutorConfig{.thread_count = 4}};
+    auto tenant = executor.add_tenant(TenantQuota{.max_in_flight = 1});
+
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+    REQUIRE(peak == 1);
+}
+
+TEST_CASE("Executor rejects cycles and unbound inputs", "[executor]") {
+    auto lib = make_lib();
+    Executor executor{ExecutorConfig{.thread_count = 1}};
+    auto tenant = executor.add_tenant();
+    std::vector<NodeOutputs> outputs;
+
+    Graph unbound{};
+    unbound.nodes.emplace_back(lib.funcs[1]).is_output = true;
+    REQUIRE(executor.run(tenant, unbound, lib, outputs) == RunResult::UnboundInput);
+
+    Graph cycle{};
+    cycle.nodes.emplace_back(lib.funcs[0]);
+    auto &second = cycle.nodes.emplace_back(lib.funcs[0]);
+    second.is_output = true;
+    cycle.nodes[0].inputs[0].binding = BindingType::Binding;
+    cycle.nodes[0].inputs[0].output_node_id = cycle.nodes[1].id;
+    cycle.nodes[1].inputs[0].binding = BindingType::Binding;
+    cycle.nodes[1].inputs[0].output_node_id = cycle.nodes[0].id;
+    REQUIRE(executor.run(tenant, cycle, lib, outputs) == RunResult::Cycle);
+}
+
+TEST_CASE("Executor runs many instances of one plan", "[executor]") {
+    auto lib = make_lib();
+    Graph graph{};
+    build_sum_graph(graph, lib, 0, 0);
+
+    auto plan = std::make_shared<GraphPlan>();
+    REQUIRE(compile_plan(graph, lib, *plan) == RunResult::Ok);
+    REQUIRE(plan->evaluated_count == 3);
+    REQUIRE(plan->roots.size() == 2);
+
+    constexpr int instance_count = 64;
+    std::vector<GraphInstance> instances;
+    for (int i = 0; i < instance_count; ++i) {
+        auto &instance = instances.emplace_back(plan);
+        instance.set_const(0, 0, make_value(1, i));
+        instance.set_const(1, 0, make_value(1, 1000));
+    }
+
+    Executor executor{ExecutorConfig{.thread_count = 4}};
+    std::vector<std::thread> callers;
+    for (int caller = 0; caller < 4; ++caller) {
+        auto tenant = executor.add_tenant(TenantQuota{.max_in_flight = 4});
+        callers.emplace_back([&, tenant, caller] {
+            for (int i = caller; i < instance_count; i += 4) {
+                executor.run(tenant, instances[i]);
+            }
+        });
+    }
+    for (auto &caller: callers) {
+        caller.join();
+    }
+
+    for (int i = 0; i < instance_count; ++i) {
+        REQUIRE(value_as<int>(instances[i].outputs[2][0]) == i + 1000);
+    }
+
+    instances[5].clear_const(0, 0);
+    executor.run(0, instances[5]);
+    REQUIRE(value_as<int>(instances[5].outputs[2][0]) == 1000);
+}
+
+// step(previous) -> previous + 1, waiting up to a second for a stop request
+static Func make_waiting_step(std::atomic<int> &started) {
+    Func step{};
+    step.name = "step";
+    step.args.push_back(FuncArg{"previous", 1, false, FuncArgType::In});
+    step.args.push_back(FuncArg{"next", 1, true, FuncArgType::Out});
+    step.lambda = [&started](std::span<const Value> inputs, std::span<Value> outputs) {
+        ++started;
+        for (int i = 0; i < 1000 && !stop_requested(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        outputs[0] = make_value(1, value_as<int>(inputs[0]) + 1);
+    };
+    return step;
+}
+
+TEST_CASE("Executor skips the rest of a cancelled run", "[executor]") {
+    std::atomic<int> started{0};
+    FuncLib lib{};
+    lib.funcs.push_back(make_waiting_step(started));
+
+    Graph graph{};
+    for (int i = 0; i < 5; ++i) {
+        auto &step = graph.nodes.emplace_back(lib.funcs[0]);
+        if (i > 0) {
+            step.inputs[0].binding = BindingType::Binding;
+            step.inputs[0].output_node_id = graph.nodes[i - 1].id;
+        }
+    }
+    graph.nodes.back().is_output = true;
+
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+    CancelToken token{};
+
+    std::vector<NodeOutputs> outputs;
+    RunResult result = RunResult::Ok;
+    const auto begin = std::chrono::steady_clock::now();
+    std::thread caller([&] { result = executor.run(tenant, graph, lib, outputs, &token); });
+    while (started == 0) {
+        std::this_thread::yield();
+    }
+    token.cancel();
+    caller.join();
+
+    REQUIRE(result == RunResult::Cancelled);
+    REQUIRE(started == 1);
+    REQUIRE(outputs[4].empty());
+    REQUIRE(std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(900));
+}
+
+TEST_CASE("Executor drops outputs of nodes past their timeout", "[executor]") {
+    std::atomic<int> started{0};
+    auto lib = make_lib();
+    lib.funcs.push_back(make_waiting_step(started));
+
+    Graph graph{};
+    auto &slow = graph.nodes.emplace_back(lib.funcs[2]);
+    slow.timeout_ms = 20;
+
+    auto &constant = graph.nodes.emplace_back(lib.funcs[0]);
+    constant.is_output = true;
+    constant.inputs[0].binding = BindingType::Binding;
+    constant.inputs[0].output_node_id = graph.nodes[0].id;
+
+    Executor executor{ExecutorConfig{.thread_count = 1}};
+    auto tenant = executor.add_tenant();
+
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::TimedOut);
+    REQUIRE(started == 1);
+    REQUIRE(outputs[0][0].empty());
+    REQUIRE(outputs[1].empty());
+
+    graph.nodes[0].timeout_ms = 0;
+    graph.nodes[0].inputs[0].binding = BindingType::Const;
+    graph.nodes[0].inputs[0].value = make_value(1, 41);
+    std::atomic<bool> stop{false};
+    lib.funcs[2].lambda = [&stop](std::span<const Value> inputs, std::span<Value> outputs) {
+        outputs[0] = make_value(1, value_as<int>(inputs[0]) + 1);
+        stop = stop_requested();
+    };
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+    REQUIRE(value_as<int>(outputs[1][0]) == 42);
+    REQUIRE_FALSE(stop);
+}
+
+TEST_CASE("Executor skips consumers of nodes past their timeout", "[executor]") {
+    std::atomic<int> started{0};
+    auto lib = make_lib();
+    lib.funcs.push_back(make_waiting_step(started));
+
+    // slow -> add(slow, constant), the add must not see the missing value
+    Graph graph{};
+    auto &slow = graph.nodes.emplace_back(lib.funcs[2]);
+    slow.timeout_ms = 20;
+    auto &constant = graph.nodes.emplace_back(lib.funcs[0]);
+    constant.inputs[0].binding = BindingType::Const;
+    constant.inputs[0].value = make_value(1, 1);
+    auto &sum = graph.nodes.emplace_back(lib.funcs[1]);
+    sum.is_output = true;
+    sum.inputs[0].binding = BindingType::Binding;
+    sum.inputs[0].output_node_id = graph.nodes[0].id;
+    sum.inputs[1].binding = BindingType::Binding;
+    sum.inputs[1].output_node_id = graph.nodes[1].id;
+
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+
+    add_calls = 0;
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::TimedOut);
+    REQUIRE(started == 1);
+    REQUIRE(add_calls == 0);
+    REQUIRE(outputs[2].empty());
+}
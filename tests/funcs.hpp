@@ -0,0 +1,48 @@
+#pragma once
+
+#include "src/func.hpp"
+#include "src/value.hpp"
+
+#include <atomic>
+#include <span>
+
+
+// Funcs most tests build their graphs from, funcs specific to one test stay in its file.
+
+// add(a, b) -> sum over ints, counting its calls in calls if given
+inline Func make_add(FuncBehavior behavior = FuncBehavior::Pure, bool required = true, std::atomic<int> *calls = nullptr) {
+    Func add{};
+    add.name = "add";
+    add.behavior = behavior;
+    add.args.push_back(FuncArg{"a", DatatypeInt, required, FuncArgType::In});
+    add.args.push_back(FuncArg{"b", DatatypeInt, required, FuncArgType::In});
+    add.args.push_back(FuncArg{"sum", DatatypeInt, true, FuncArgType::Out});
+    add.lambda = [calls](std::span<const Value> inputs, std::span<Value> outputs) {
+        if (calls != nullptr) {
+            ++*calls;
+        }
+        outputs[0] = make_value(DatatypeInt, value_as<int>(inputs[0]) + value_as<int>(inputs[1]));
+    };
+    return add;
+}
+
+// identity(value) -> value over ints
+inline Func make_identity() {
+    Func identity{};
+    identity.name = "identity";
+    identity.behavior = FuncBehavior::Pure;
+    identity.args.push_back(FuncArg{"value", DatatypeInt, true, FuncArgType::In});
+    identity.args.push_back(FuncArg{"result", DatatypeInt, true, FuncArgType::Out});
+    identity.lambda = [](std::span<const Value> inputs, std::span<Value> outputs) {
+        outputs[0] = inputs[0];
+    };
+    return identity;
+}
+
+// source() -> value, an int, declared only
+inline Func make_source() {
+    Func source{};
+    source.name = "source";
+    source.args.push_back(FuncArg{"value", DatatypeInt, true, FuncArgType::Out});
+    return source;
+}
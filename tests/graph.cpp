@@ -0,0 +1,148 @@
+#include "src/executor.hpp"
+#include "src/graph.hpp"
+#include "src/tensor.hpp"
+#include "src/utils/thread_pool.hpp"
+#include "src/utils/utils.hpp"
+#include "tests/funcs.hpp"
+
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+// layers of adds, each summing two nodes of the previous layer, stored in shuffled order
+static Graph build_layers(FuncLib &lib, int layers, int width) {
+    std::vector<Node> nodes;
+    for (int layer = 0; layer < layers; ++layer) {
+        for (int i = 0; i < width; ++i) {
+            auto &node = nodes.emplace_back(lib.funcs[0]);
+            if (layer == 0) {
+                node.inputs[0].binding = BindingType::Const;
+                node.inputs[0].value = make_value(DatatypeInt, i);
+                continue;
+            }
+            const auto previous = (layer - 1) * width;
+            node.inputs[0].binding = BindingType::Binding;
+            node.inputs[0].output_node_id = nodes[previous + i].id;
+            node.inputs[1].binding = BindingType::Binding;
+            node.inputs[1].output_node_id = nodes[previous + (i + 1) % width].id;
+        }
+    }
+    for (int i = 0; i < width; ++i) {
+        nodes[(layers - 1) * width + i].is_output = true;
+    }
+
+    std::ranges::shuffle(nodes, std::mt19937{7});
+    Graph graph{};
+    graph.nodes = std::move(nodes);
+    return graph;
+}
+
+static bool producers_first(const Graph &graph) {
+    std::unordered_map<NodeId, size_t, UuidHash> positions;
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        positions.emplace(graph.nodes[i].id, i);
+    }
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        for (const auto &input: graph.nodes[i].inputs) {
+            if (input.binding == BindingType::Binding && positions.at(input.output_node_id) > i) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static std::vector<int> output_values(const Graph &graph, const std::vector<NodeOutputs> &outputs) {
+    std::vector<std::pair<NodeId, int>> values;
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        if (graph.nodes[i].is_output) {
+            values.emplace_back(graph.nodes[i].id, value_as<int>(outputs[i][0]));
+        }
+    }
+    std::sort(values.begin(), values.end());
+    std::vector<int> result;
+    for (const auto &[id, value]: values) {
+        result.push_back(value);
+    }
+    return result;
+}
+
+
+TEST_CASE("Reordering puts producers before consumers", "[graph]") {
+    FuncLib lib{{make_add(FuncBehavior::Pure, false)}};
+    auto graph = build_layers(lib, 6, 8);
+    auto &unused = graph.nodes.emplace_back(lib.funcs[0]);
+    const auto unused_id = unused.id;
+    REQUIRE_FALSE(producers_first(graph));
+
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+    const auto expected = output_values(graph, outputs);
+
+    for (const auto order: {NodeOrder::PostOrder, NodeOrder::Depth}) {
+        std::vector<NodeId> previous_ids;
+        for (const auto &node: graph.nodes) {
+            previous_ids.push_back(node.id);
+        }
+
+        const auto permutation = reorder_nodes(graph, order);
+        REQUIRE(permutation.size() == graph.nodes.size());
+        for (size_t i = 0; i < permutation.size(); ++i) {
+            REQUIRE(graph.nodes[i].id == previous_ids[permutation[i]]);
+        }
+        REQUIRE(producers_first(graph));
+        const auto unused_position = std::ranges::find(graph.nodes, unused_id, &Node::id) - graph.nodes.begin();
+        for (size_t i = unused_position; i < graph.nodes.size(); ++i) {
+            REQUIRE_FALSE(graph.nodes[i].is_output);
+        }
+
+        REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+        REQUIRE(output_values(graph, outputs) == expected);
+    }
+
+    // by depth, all Const inputs come first
+    for (size_t i = 0; i < 8; ++i) {
+        REQUIRE(graph.nodes[i].inputs[0].binding == BindingType::Const);
+    }
+}
+
+TEST_CASE("Reordering keeps Const values", "[graph]") {
+    FuncLib lib{{make_add(FuncBehavior::Pure, false)}};
+    Graph graph{};
+    auto &node = graph.nodes.emplace_back(lib.funcs[0]);
+    node.is_output = true;
+    node.inputs[0].binding = BindingType::Const;
+    node.inputs[0].value = make_value(DatatypeString, std::string("stored on the heap"));
+    graph.nodes.emplace_back(lib.funcs[0]);
+    std::swap(graph.nodes[0], graph.nodes[1]);
+
+    REQUIRE(reorder_nodes(graph, NodeOrder::PostOrder) == std::vector<uint32_t>{1, 0});
+    REQUIRE(value_as<std::string>(graph.nodes[0].inputs[0].value.value()) == "stored on the heap");
+}
+
+TEST_CASE("Parallel emission matches the serial emitter", "[graph]") {
+    FuncLib lib{{make_add(FuncBehavior::Pure, false)}};
+    ThreadPool pool{ThreadPoolConfig{.thread_count = 3}};
+    const float weights[] = {0.5f, -2.0f};
+
+    for (const auto layers: {0, 1, 40, 300}) {
+        auto graph = layers == 0 ? Graph{} : build_layers(lib, layers, 10);
+        for (size_t i = 0; i < graph.nodes.size(); i += 7) {
+            auto &node = graph.nodes[i];
+            node.name = i % 2 == 0 ? "quoted: \"name\"\nover lines" : "";
+            node.inputs[1].binding = BindingType::Const;
+            node.inputs[1].value = i % 3 == 0 ? make_value(DatatypeTensor, make_array<float>(DatatypeFloat, weights))
+                                              : make_value(DatatypeString, std::string("- not a sequence"));
+            node.events.emplace_back().subscribers.push_back(graph.nodes[0].id);
+        }
+
+        YAML::Emitter out;
+        out << graph;
+        REQUIRE(emit_graph_parallel(graph, pool) == out.c_str());
+    }
+}
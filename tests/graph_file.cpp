@@ -0,0 +1,199 @@
+#include "src/graph_file.hpp"
+#include "src/tensor.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+static FuncLib make_lib() {
+    FuncLib lib{};
+
+    Func &scale = lib.funcs.emplace_back();
+    scale.name = "scale";
+    scale.behavior = FuncBehavior::Pure;
+    scale.args.push_back(FuncArg{"values", DatatypeTensor, true, FuncArgType::In});
+    scale.args.push_back(FuncArg{"factor", DatatypeFloat, true, FuncArgType::In});
+    scale.args.push_back(FuncArg{"label", DatatypeString, false, FuncArgType::In});
+    scale.args.push_back(FuncArg{"scaled", DatatypeTensor, true, FuncArgType::Out});
+    scale.events.push_back(FuncEvent{"done"});
+
+    return lib;
+}
+
+static Graph build_graph(FuncLib &lib, int count) {
+    const float values[] = {1.0f, 2.0f, 3.0f, 4.0f};
+    Graph graph{};
+    for (int i = 0; i < count; ++i) {
+        auto &node = graph.nodes.emplace_back(lib.funcs[0]);
+        node.name = i % 2 == 0 ? "even" : "odd";
+        node.timeout_ms = static_cast<uint32_t>(i);
+        if (i == 0) {
+            node.inputs[0].binding = BindingType::Const;
+            node.inputs[0].value = make_value(DatatypeTensor, make_array<float>(DatatypeFloat, values));
+        } else {
+            node.inputs[0].binding = BindingType::Binding;
+            node.inputs[0].output_node_id = graph.nodes[i - 1].id;
+        }
+        node.inputs[1].binding = BindingType::Const;
+        node.inputs[1].value = make_value(DatatypeFloat, static_cast<float>(i) * 0.5f);
+        node.inputs[2].binding = BindingType::Const;
+        node.inputs[2].value = make_value(DatatypeString, "node " + std::to_string(i));
+        if (i > 0) {
+            node.events[0].subscribers.push_back(graph.nodes[0].id);
+        }
+    }
+    graph.nodes.back().is_output = true;
+    return graph;
+}
+
+template<typename T>
+static std::string emit(const T &value) {
+    YAML::Emitter out;
+    out << value;
+    return out.c_str();
+}
+
+
+TEST_CASE("Graph files are read in place", "[graph_file]") {
+    auto lib = make_lib();
+    const auto graph = build_graph(lib, 5);
+    const auto path = (std::filesystem::temp_directory_path() / "c_playground-graph-file.bin").string();
+    REQUIRE(save_graph_file(graph, lib.funcs, path));
+
+    GraphFile file{};
+    REQUIRE(open_graph_file(&file, path));
+    REQUIRE(file.nodes.size() == 5);
+    REQUIRE(file.funcs.size() == 1);
+
+    // names are stored once
+    REQUIRE(file.nodes[0].name.offset == file.nodes[2].name.offset);
+    REQUIRE(file.string(file.nodes[1].name) == "odd");
+    REQUIRE(to_uuid(file.nodes[3].id) == graph.nodes[3].id);
+    REQUIRE(file.nodes[4].flags == FileNodeIsOutput);
+
+    const auto inputs = file.node_inputs(file.nodes[0]);
+    REQUIRE(inputs.size() == 4);
+    Value borrowed{};
+    REQUIRE(file.value(inputs[0], borrowed, true));
+    const auto tensor = value_as<Tensor>(borrowed);
+    REQUIRE(tensor.as<float>()[2] == 3.0f);
+    REQUIRE(reinterpret_cast<const std::byte *>(tensor.data()) >= file.values.data());
+    REQUIRE(reinterpret_cast<const std::byte *>(tensor.data()) < file.values.data() + file.values.size());
+
+    Graph loaded{};
+    REQUIRE(file.to_graph(loaded));
+    REQUIRE(emit(loaded) == emit(graph));
+    std::vector<Func> funcs;
+    REQUIRE(file.to_funcs(funcs));
+    REQUIRE(emit(funcs[0]) == emit(lib.funcs[0]));
+
+    borrowed.reset();
+    file = GraphFile{};
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Graph files convert from and to YAML", "[graph_file]") {
+    auto lib = make_lib();
+    const auto graph = build_graph(lib, 3);
+    const auto yaml = emit(graph);
+    const auto path = (std::filesystem::temp_directory_path() / "c_playground-graph-file-yaml.bin").string();
+
+    std::istringstream input(yaml);
+    REQUIRE(yaml_to_graph_file(input, lib, path));
+    GraphFile file{};
+    REQUIRE(open_graph_file(&file, path));
+
+    std::ostringstream graph_yaml;
+    std::ostringstream funcs_yaml;
+    REQUIRE(graph_file_to_yaml(file, graph_yaml, &funcs_yaml));
+    REQUIRE(graph_yaml.str() == yaml);
+    REQUIRE(funcs_yaml.str().find("name: scale") != std::string::npos);
+    file = GraphFile{};
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Damaged graph files are rejected", "[graph_file]") {
+    auto lib = make_lib();
+    std::vector<std::byte> bytes;
+    REQUIRE(encode_graph_file(build_graph(lib, 2), lib.funcs, bytes));
+
+    GraphFile file{};
+    REQUIRE(view_graph_file(&file, bytes));
+    REQUIRE_FALSE(view_graph_file(&file, std::span<const std::byte>(bytes).first(bytes.size() - 8)));
+    REQUIRE_FALSE(view_graph_file(&file, std::span<const std::byte>(bytes).first(sizeof(GraphFileHeader) - 1)));
+
+    // records are patched in a copy, at the offset the view found them
+    const auto patched = [&](const void *record, const auto &field, auto value) {
+        auto copy = bytes;
+        const auto offset = reinterpret_cast<const std::byte *>(&field) - bytes.data();
+        REQUIRE(reinterpret_cast<const std::byte *>(record) <= bytes.data() + offset);
+        std::memcpy(copy.data() + offset, &value, sizeof(field));
+        return copy;
+    };
+    std::vector<Func> funcs;
+    Graph graph{};
+
+    auto damaged = patched(&file.funcs[0], file.funcs[0].behavior, uint32_t{7});
+    REQUIRE(view_graph_file(&file, damaged));
+    REQUIRE_FALSE(file.to_funcs(funcs));
+
+    REQUIRE(view_graph_file(&file, bytes));
+    damaged = patched(&file.args[1], file.args[1].type, uint8_t{2});
+    REQUIRE(view_graph_file(&file, damaged));
+    REQUIRE_FALSE(file.to_funcs(funcs));
+
+    REQUIRE(view_graph_file(&file, bytes));
+    damaged = patched(&file.funcs[0], file.funcs[0].args.count, uint32_t{1000});
+    REQUIRE(view_graph_file(&file, damaged));
+    REQUIRE_FALSE(file.to_funcs(funcs));
+
+    REQUIRE(view_graph_file(&file, bytes));
+    damaged = patched(&file.inputs[0], file.inputs[0].value_size, uint64_t{1} << 40);
+    REQUIRE(view_graph_file(&file, damaged));
+    REQUIRE_FALSE(file.to_graph(graph));
+
+    REQUIRE(view_graph_file(&file, bytes));
+    damaged = patched(&file.inputs[1], file.inputs[1].binding, uint8_t{9});
+    REQUIRE(view_graph_file(&file, damaged));
+    REQUIRE_FALSE(file.to_graph(graph));
+
+    // a section running past the end of the file
+    GraphFileHeader header{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    header.sections[static_cast<size_t>(GraphFileSection::Values)].size = bytes.size();
+    damaged = bytes;
+    std::memcpy(damaged.data(), &header, sizeof(header));
+    REQUIRE_FALSE(view_graph_file(&file, damaged));
+
+    bytes[0] = std::byte{0};
+    REQUIRE_FALSE(view_graph_file(&file, bytes));
+    REQUIRE_FALSE(open_graph_file(&file, "/nonexistent/c_playground-graph-file.bin"));
+}
+
+TEST_CASE("Const values without an encoding fail the save", "[graph_file]") {
+    // strings other than DatatypeString are not trivial, so graph files cannot encode them
+    constexpr DatatypeId DatatypeText = 110;
+    if (!datatype_registry().contains(DatatypeText)) {
+        datatype_registry().add(make_datatype<std::string>(DatatypeText, "text"));
+    }
+    auto lib = make_lib();
+    auto graph = build_graph(lib, 3);
+    graph.nodes[1].inputs[2].value = make_value(DatatypeText, std::string("unencodable"));
+    const auto path = (std::filesystem::temp_directory_path() / "c_playground-graph-file-text.bin").string();
+    std::filesystem::remove(path);
+
+    std::vector<std::byte> bytes;
+    GraphFileError error{};
+    REQUIRE_FALSE(encode_graph_file(graph, lib.funcs, bytes, &error));
+    REQUIRE(bytes.empty());
+    REQUIRE(error.node_id == graph.nodes[1].id);
+    REQUIRE(error.arg_idx == 2);
+
+    error = GraphFileError{};
+    REQUIRE_FALSE(save_graph_file(graph, lib.funcs, path, &error));
+    REQUIRE(error.node_id == graph.nodes[1].id);
+    REQUIRE_FALSE(std::filesystem::exists(path));
+}
@@ -0,0 +1,128 @@
+#include "src/builder.hpp"
+#include "src/index.hpp"
+#include "tests/funcs.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+static std::vector<NodeId> sorted(std::span<const NodeId> ids) {
+    std::vector<NodeId> result(ids.begin(), ids.end());
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+
+TEST_CASE("Index answers queries by func, name and consumers", "[index]") {
+    FuncLib lib{{make_source(), make_add()}};
+    Graph graph{};
+    GraphIndex index{graph};
+    GraphBuilder builder{graph, nullptr, &index};
+
+    // two sources, each feeding both inputs of an add
+    const auto sources = builder.add_nodes(lib.funcs[0], 2);
+    const auto adds = builder.add_nodes(lib.funcs[1], 2);
+    for (uint32_t i = 0; i < 2; ++i) {
+        builder.bind(adds + i, 0, sources + i);
+        builder.bind(adds + i, 1, sources + i);
+    }
+    graph.nodes[sources].name = "sensor/left";
+    graph.nodes[sources + 1].name = "sensor/right";
+    graph.nodes[adds].name = "sum";
+    builder.commit();
+
+    REQUIRE(index.nodes_of(lib.funcs[0].id).size() == 2);
+    REQUIRE(index.nodes_of(lib.funcs[1].id).size() == 2);
+    REQUIRE(index.consumers_of(graph.nodes[sources].id).size() == 1);
+    REQUIRE(index.consumers_of(graph.nodes[sources].id)[0] == graph.nodes[adds].id);
+    REQUIRE(index.consumers_of(graph.nodes[adds].id).empty());
+
+    REQUIRE(index.with_name_prefix("sensor/") == std::vector<NodeId>{graph.nodes[sources].id, graph.nodes[sources + 1].id});
+    REQUIRE(index.with_name_prefix("sensor/", 1).size() == 1);
+    REQUIRE(index.with_name_prefix("sensors").empty());
+    REQUIRE(index.with_name_prefix("").size() == 4);
+
+    // rewire the second add to the first source and rename it
+    graph.nodes[adds + 1].inputs[1].output_node_id = graph.nodes[sources].id;
+    graph.nodes[adds + 1].name = "sensor/sum";
+    index.touch(graph.nodes[adds + 1].id);
+    REQUIRE(sorted(index.consumers_of(graph.nodes[sources].id))
+            == sorted(std::vector<NodeId>{graph.nodes[adds].id, graph.nodes[adds + 1].id}));
+    REQUIRE(index.consumers_of(graph.nodes[sources + 1].id).size() == 1);
+    REQUIRE(index.with_name_prefix("sensor/").size() == 3);
+}
+
+TEST_CASE("Index follows removed and moved nodes", "[index]") {
+    FuncLib lib{{make_source(), make_add()}};
+    Graph graph{};
+    GraphBuilder builder{graph};
+    const auto source = builder.add_node(lib.funcs[0]);
+    const auto add = builder.add_node(lib.funcs[1]);
+    builder.bind(add, 0, source);
+    builder.commit();
+
+    GraphIndex index{graph};
+    const auto source_id = graph.nodes[source].id;
+    const auto add_id = graph.nodes[add].id;
+
+    // removing the source moves the add to the front, its binding now dangles
+    graph.nodes.erase(graph.nodes.begin());
+    index.touch(source_id);
+    REQUIRE(index.find(source_id) == nullptr);
+    REQUIRE(index.find(add_id) == &graph.nodes[0]);
+    REQUIRE(index.nodes_of(lib.funcs[0].id).empty());
+    REQUIRE(index.consumers_of(source_id).size() == 1);
+
+    graph.nodes.erase(graph.nodes.begin());
+    index.touch(add_id);
+    REQUIRE(index.consumers_of(source_id).empty());
+    REQUIRE(index.nodes_of(lib.funcs[1].id).empty());
+    REQUIRE(index.with_name_prefix("").empty());
+    REQUIRE(index.nodes.empty());
+}
+
+TEST_CASE("Index stays consistent through bulk edits of one func", "[index]") {
+    FuncLib lib{{make_source(), make_add()}};
+    Graph graph{};
+    GraphBuilder builder{graph};
+    const auto sources = builder.add_nodes(lib.funcs[0], 4);
+    const auto adds = builder.add_nodes(lib.funcs[1], 2000);
+    for (uint32_t i = 0; i < 2000; ++i) {
+        builder.bind(adds + i, 0, sources + i % 4);
+        builder.bind(adds + i, 1, sources + (i + 1) % 4);
+    }
+    builder.commit();
+    GraphIndex index{graph};
+
+    // remove every third add and rewire every other one, reporting them in one batch
+    std::mt19937 random{3};
+    std::vector<NodeId> touched;
+    for (size_t i = graph.nodes.size() - 1; i >= 4; --i) {
+        touched.push_back(graph.nodes[i].id);
+        if (random() % 3 == 0) {
+            graph.nodes.erase(graph.nodes.begin() + static_cast<ptrdiff_t>(i));
+        } else if (random() % 2 == 0) {
+            graph.nodes[i].inputs[1].output_node_id = graph.nodes[random() % 4].id;
+        }
+    }
+    index.touch(touched);
+
+    const GraphIndex rebuilt{graph};
+    REQUIRE(sorted(index.nodes_of(lib.funcs[1].id)) == sorted(rebuilt.nodes_of(lib.funcs[1].id)));
+    for (uint32_t i = 0; i < 4; ++i) {
+        const auto &id = graph.nodes[i].id;
+        REQUIRE(sorted(index.consumers_of(id)) == sorted(rebuilt.consumers_of(id)));
+        const auto consumers = index.consumers_of(id);
+        for (uint32_t slot = 0; slot < consumers.size(); ++slot) {
+            const auto &entry = index.nodes.at(consumers[slot]);
+            const auto producer_idx = std::ranges::find(entry.producers, id) - entry.producers.begin();
+            REQUIRE(entry.consumer_slots[producer_idx] == slot);
+        }
+    }
+    const auto of_func = index.nodes_of(lib.funcs[1].id);
+    for (uint32_t slot = 0; slot < of_func.size(); ++slot) {
+        REQUIRE(index.nodes.at(of_func[slot]).func_slot == slot);
+    }
+}
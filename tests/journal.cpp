@@ -0,0 +1,202 @@
+#include "src/journal.hpp"
+#include "tests/funcs.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+static std::string emit(const Graph &graph) {
+    YAML::Emitter out;
+    out << graph;
+    return out.c_str();
+}
+
+static std::string temp_path(const std::string &name) {
+    const auto path = (std::filesystem::temp_directory_path() / name).string();
+    for (const auto *suffix: {"", ".journal", ".journal.old"}) {
+        std::filesystem::remove(path + suffix);
+    }
+    return path;
+}
+
+
+TEST_CASE("Journal replays edits on top of the snapshot", "[journal]") {
+    FuncLib lib{{make_add()}};
+    const auto path = temp_path("c_playground-journal.bin");
+
+    Graph graph{};
+    {
+        Journal journal{};
+        std::vector<Func> funcs;
+        REQUIRE(open_journal(&journal, path, graph, funcs));
+        REQUIRE(graph.nodes.empty());
+        for (int i = 0; i < 3; ++i) {
+            graph.nodes.emplace_back(lib.funcs[0]).name = "node " + std::to_string(i);
+        }
+        REQUIRE(journal.snapshot(graph, lib.funcs));
+        const auto snapshot_size = std::filesystem::file_size(path);
+
+        graph.nodes[1].name = "edited";
+        graph.nodes[1].inputs[0].binding = BindingType::Const;
+        graph.nodes[1].inputs[0].value = make_value(DatatypeInt, 7);
+        REQUIRE(journal.upsert(graph.nodes[1]));
+        REQUIRE(journal.remove(graph.nodes[0].id));
+        graph.nodes.erase(graph.nodes.begin());
+        REQUIRE(journal.upsert(graph.nodes.emplace_back(lib.funcs[0])));
+
+        // edits leave the snapshot alone
+        REQUIRE(std::filesystem::file_size(path) == snapshot_size);
+    }
+
+    Graph loaded{};
+    std::vector<Func> funcs;
+    Journal journal{};
+    REQUIRE(open_journal(&journal, path, loaded, funcs));
+    REQUIRE(emit(loaded) == emit(graph));
+    REQUIRE(funcs.size() == 1);
+    REQUIRE(funcs[0].id == lib.funcs[0].id);
+}
+
+TEST_CASE("Torn journal records are cut off", "[journal]") {
+    FuncLib lib{{make_add()}};
+    const auto path = temp_path("c_playground-journal-torn.bin");
+
+    Graph graph{};
+    {
+        Journal journal{};
+        std::vector<Func> funcs;
+        REQUIRE(open_journal(&journal, path, graph, funcs));
+        REQUIRE(journal.upsert(graph.nodes.emplace_back(lib.funcs[0])));
+    }
+    const auto complete_size = std::filesystem::file_size(path + ".journal");
+    {
+        // half of a record, as left by a crash in the middle of an append
+        std::ofstream log(path + ".journal", std::ios::binary | std::ios::app);
+        const char partial[] = {1, 0, 0, 0, 100, 0, 0, 0, 42};
+        log.write(partial, sizeof(partial));
+    }
+
+    Graph loaded{};
+    std::vector<Func> funcs;
+    {
+        Journal journal{};
+        REQUIRE(open_journal(&journal, path, loaded, funcs));
+        REQUIRE(emit(loaded) == emit(graph));
+        REQUIRE(std::filesystem::file_size(path + ".journal") == complete_size);
+
+        REQUIRE(journal.upsert(graph.nodes.emplace_back(lib.funcs[0])));
+    }
+    loaded.nodes.clear();
+    Journal journal{};
+    REQUIRE(open_journal(&journal, path, loaded, funcs));
+    REQUIRE(emit(loaded) == emit(graph));
+}
+
+TEST_CASE("Damaged journal records end the replay", "[journal]") {
+    FuncLib lib{{make_add()}};
+    const auto path = temp_path("c_playground-journal-damaged.bin");
+
+    Graph graph{};
+    uint64_t first_size = 0;
+    {
+        Journal journal{};
+        std::vector<Func> funcs;
+        REQUIRE(open_journal(&journal, path, graph, funcs));
+        REQUIRE(journal.upsert(graph.nodes.emplace_back(lib.funcs[0])));
+        first_size = std::filesystem::file_size(path + ".journal");
+        REQUIRE(journal.upsert(graph.nodes.emplace_back(lib.funcs[0])));
+        REQUIRE(journal.upsert(graph.nodes.emplace_back(lib.funcs[0])));
+    }
+    {
+        // a flipped byte in the payload of the second record, its checksum no longer matches
+        std::fstream log(path + ".journal", std::ios::binary | std::ios::in | std::ios::out);
+        log.seekp(static_cast<std::streamoff>(first_size + 40));
+        log.put('\x7f');
+    }
+
+    Graph loaded{};
+    std::vector<Func> funcs;
+    {
+        Journal journal{};
+        REQUIRE(open_journal(&journal, path, loaded, funcs));
+        REQUIRE(loaded.nodes.size() == 1);
+        REQUIRE(loaded.nodes[0].id == graph.nodes[0].id);
+        REQUIRE(std::filesystem::file_size(path + ".journal") == first_size);
+    }
+
+    // a damaged snapshot fails the open rather than losing the graph
+    {
+        Journal journal{};
+        Graph reopened{};
+        REQUIRE(open_journal(&journal, path, reopened, funcs));
+        REQUIRE(journal.snapshot(graph, lib.funcs));
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+    loaded.nodes.clear();
+    Journal journal{};
+    REQUIRE_FALSE(open_journal(&journal, path, loaded, funcs));
+}
+
+TEST_CASE("Journal rejects nodes it cannot store", "[journal]") {
+    constexpr DatatypeId DatatypeText = 110;
+    if (!datatype_registry().contains(DatatypeText)) {
+        datatype_registry().add(make_datatype<std::string>(DatatypeText, "text"));
+    }
+    FuncLib lib{{make_add()}};
+    const auto path = temp_path("c_playground-journal-text.bin");
+
+    Graph graph{};
+    Journal journal{};
+    std::vector<Func> funcs;
+    REQUIRE(open_journal(&journal, path, graph, funcs));
+    const auto log_size = std::filesystem::file_size(path + ".journal");
+
+    auto &node = graph.nodes.emplace_back(lib.funcs[0]);
+    node.inputs[0].binding = BindingType::Const;
+    node.inputs[0].value = make_value(DatatypeText, std::string("unencodable"));
+    REQUIRE_FALSE(journal.upsert(node));
+    REQUIRE(std::filesystem::file_size(path + ".journal") == log_size);
+    REQUIRE_FALSE(journal.snapshot(graph, lib.funcs));
+}
+
+TEST_CASE("Journal compacts in the background", "[journal]") {
+    FuncLib lib{{make_add()}};
+    const auto path = temp_path("c_playground-journal-compact.bin");
+
+    Graph graph{};
+    {
+        Journal journal{};
+        std::vector<Func> funcs;
+        REQUIRE(open_journal(&journal, path, graph, funcs));
+        REQUIRE(journal.snapshot(graph, lib.funcs));
+        journal.compact_size = 4096;
+
+        for (int i = 0; i < 200; ++i) {
+            auto &node = graph.nodes.emplace_back(lib.funcs[0]);
+            node.name = "node " + std::to_string(i);
+            REQUIRE(journal.upsert(node));
+            if (i % 3 == 0) {
+                REQUIRE(journal.remove(graph.nodes[graph.nodes.size() / 2].id));
+                graph.nodes.erase(graph.nodes.begin() + static_cast<ptrdiff_t>(graph.nodes.size() / 2));
+            }
+        }
+        REQUIRE(journal.wait_compaction());
+        REQUIRE_FALSE(std::filesystem::exists(path + ".journal.old"));
+        const auto snapshot_size = std::filesystem::file_size(path);
+
+        // appends during a compaction stay in the new log until the next one
+        REQUIRE(journal.compact());
+        REQUIRE(journal.wait_compaction());
+        REQUIRE(std::filesystem::file_size(path + ".journal") == 16);
+        REQUIRE(std::filesystem::file_size(path) >= snapshot_size);
+    }
+
+    Graph loaded{};
+    std::vector<Func> funcs;
+    Journal journal{};
+    REQUIRE(open_journal(&journal, path, loaded, funcs));
+    REQUIRE(emit(loaded) == emit(graph));
+    REQUIRE(funcs.size() == 1);
+}
@@ -0,0 +1,111 @@
+#include "src/executor.hpp"
+#include "src/lazy_graph.hpp"
+#include "src/loader.hpp"
+#include "src/yaml_writer.hpp"
+#include "tests/funcs.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+// chains of adds, node i of chain c adds c to node i - 1 (so holds c * (i + 1)), named after its position
+static Graph build_chains(FuncLib &lib, int chains, int length) {
+    Graph graph{};
+    for (int chain = 0; chain < chains; ++chain) {
+        for (int i = 0; i < length; ++i) {
+            auto &node = graph.nodes.emplace_back(lib.funcs[0]);
+            node.name = "chain " + std::to_string(chain) + ": " + std::to_string(i);
+            node.inputs[1].binding = BindingType::Const;
+            node.inputs[1].value = make_value(DatatypeInt, chain);
+            if (i > 0) {
+                node.inputs[0].binding = BindingType::Binding;
+                node.inputs[0].output_node_id = graph.nodes[graph.nodes.size() - 2].id;
+            }
+        }
+    }
+    return graph;
+}
+
+static std::string save(const std::string &yaml, const std::string &name) {
+    const auto path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream(path, std::ios::binary) << yaml;
+    return path;
+}
+
+
+TEST_CASE("Lazy graph loads nodes on first access", "[lazy_graph]") {
+    FuncLib lib{{make_add(FuncBehavior::Pure, false)}};
+    const auto graph = build_chains(lib, 4, 25);
+    std::string yaml;
+    write_yaml(yaml, graph);
+    const auto path = save(yaml, "c_playground-lazy-graph.yaml");
+
+    LazyGraph lazy{};
+    REQUIRE(open_lazy_graph(&lazy, path, lib));
+    REQUIRE(lazy.size() == graph.nodes.size());
+    REQUIRE(lazy.graph.nodes.empty());
+    for (uint32_t i = 0; i < lazy.size(); ++i) {
+        REQUIRE(lazy.entries[i].id == graph.nodes[i].id);
+    }
+
+    // a viewport in the middle
+    REQUIRE(lazy.load_range(30, 40));
+    REQUIRE(lazy.graph.nodes.size() == 10);
+    REQUIRE(lazy.node(35)->name == "chain 1: 10");
+    REQUIRE(lazy.graph.nodes.size() == 10);
+    REQUIRE(lazy.find(graph.nodes[99].id)->name == "chain 3: 24");
+    REQUIRE(lazy.find(NodeId{}) == nullptr);
+    REQUIRE(lazy.node(100) == nullptr);
+
+    std::stringstream loaded;
+    YAML::Emitter out(loaded);
+    out << *lazy.node(35);
+    std::stringstream expected;
+    YAML::Emitter expected_out(expected);
+    expected_out << graph.nodes[35];
+    REQUIRE(loaded.str() == expected.str());
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Lazy graph runs only what outputs need", "[lazy_graph]") {
+    FuncLib lib{{make_add(FuncBehavior::Pure, false)}};
+    const auto graph = build_chains(lib, 3, 40);
+    YAML::Emitter out;
+    out << graph;
+    const auto path = save(out.c_str(), "c_playground-lazy-reachable.yaml");
+
+    LazyGraph lazy{};
+    REQUIRE(open_lazy_graph(&lazy, path, lib));
+    const NodeId output = graph.nodes[40 + 19].id;
+    REQUIRE(lazy.load_reachable(std::span(&output, 1)));
+    REQUIRE(lazy.graph.nodes.size() == 20);
+    REQUIRE(lazy.load_reachable(std::span(&output, 1)));
+    REQUIRE(lazy.graph.nodes.size() == 20);
+
+    for (auto &node: lazy.graph.nodes) {
+        node.is_output = node.id == output;
+    }
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, lazy.graph, lib, outputs) == RunResult::Ok);
+    const auto output_idx = std::ranges::find(lazy.graph.nodes, output, &Node::id) - lazy.graph.nodes.begin();
+    REQUIRE(value_as<int>(outputs[output_idx][0]) == 20);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Lazy graph rejects what it cannot index", "[lazy_graph]") {
+    FuncLib lib{{make_add(FuncBehavior::Pure, false)}};
+    LazyGraph lazy{};
+    REQUIRE(open_lazy_graph(&lazy, save("[]", "c_playground-lazy-empty.yaml"), lib));
+    REQUIRE(lazy.size() == 0);
+
+    REQUIRE_FALSE(open_lazy_graph(&lazy, save("nodes: []", "c_playground-lazy-map.yaml"), lib));
+    REQUIRE_FALSE(open_lazy_graph(&lazy, save("- name: no id", "c_playground-lazy-id.yaml"), lib));
+    for (const auto *name: {"c_playground-lazy-empty.yaml", "c_playground-lazy-map.yaml", "c_playground-lazy-id.yaml"}) {
+        std::filesystem::remove(std::filesystem::temp_directory_path() / name);
+    }
+}
@@ -0,0 +1,125 @@
+#include "src/graph.hpp"
+#include "src/loader.hpp"
+#include "src/tensor.hpp"
+
+#include <sstream>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+// mix(count, scale, label, weights, enabled) -> result
+static FuncLib make_lib() {
+    FuncLib lib{};
+
+    Func &mix = lib.funcs.emplace_back();
+    mix.name = "mix";
+    mix.behavior = FuncBehavior::Pure;
+    mix.args.push_back(FuncArg{"count", DatatypeInt, true, FuncArgType::In});
+    mix.args.push_back(FuncArg{"scale", DatatypeFloat, true, FuncArgType::In});
+    mix.args.push_back(FuncArg{"label", DatatypeString, false, FuncArgType::In});
+    mix.args.push_back(FuncArg{"weights", DatatypeTensor, false, FuncArgType::In});
+    mix.args.push_back(FuncArg{"enabled", DatatypeBool, false, FuncArgType::In});
+    mix.args.push_back(FuncArg{"result", DatatypeTensor, true, FuncArgType::Out, true});
+    mix.events.push_back(FuncEvent{"changed"});
+
+    return lib;
+}
+
+template<typename T>
+static std::string emit(const T &value) {
+    YAML::Emitter out;
+    out << value;
+    return out.c_str();
+}
+
+
+TEST_CASE("Loaded graphs emit the same YAML", "[loader]") {
+    auto lib = make_lib();
+    const float weights[] = {0.25f, -1.5f, 3.0f};
+
+    Graph graph{};
+    auto &first = graph.nodes.emplace_back(lib.funcs[0]);
+    first.name = "first";
+    first.timeout_ms = 250;
+    first.inputs[0].binding = BindingType::Const;
+    first.inputs[0].value = make_value(DatatypeInt, -42);
+    first.inputs[1].binding = BindingType::Const;
+    first.inputs[1].value = make_value(DatatypeFloat, 0.5f);
+    first.inputs[2].binding = BindingType::Const;
+    first.inputs[2].value = make_value(DatatypeString, std::string("with: \"quotes\" and\nnewlines"));
+    first.inputs[3].binding = BindingType::Const;
+    first.inputs[3].value = make_value(DatatypeTensor, make_array<float>(DatatypeFloat, weights));
+    first.inputs[4].binding = BindingType::Const;
+    first.inputs[4].value = Value{};
+    const auto first_id = first.id;
+
+    auto &second = graph.nodes.emplace_back(lib.funcs[0]);
+    second.is_output = true;
+    second.cache_outputs = true;
+    second.inputs[0].binding = BindingType::Binding;
+    second.inputs[0].output_node_id = first_id;
+    second.inputs[1].binding = BindingType::Const;
+    second.inputs[1].value = make_value(DatatypeFloat, 2.0f);
+    second.inputs[4].binding = BindingType::Const;
+    second.inputs[4].value = make_value(DatatypeBool, true);
+    second.events[0].subscribers.push_back(first_id);
+
+    const auto yaml = emit(graph);
+    std::istringstream input(yaml);
+    Graph loaded{};
+    REQUIRE(load_graph(input, lib, loaded));
+    REQUIRE(loaded.nodes.size() == 2);
+    REQUIRE(emit(loaded) == yaml);
+
+    REQUIRE(loaded.nodes[0].id == first_id);
+    REQUIRE(loaded.nodes[0].timeout_ms == 250);
+    REQUIRE(value_as<int>(*loaded.nodes[0].inputs[0].value) == -42);
+    REQUIRE(*loaded.nodes[0].inputs[3].value == *graph.nodes[0].inputs[3].value);
+    REQUIRE(loaded.nodes[0].inputs[4].value->empty());
+    REQUIRE(loaded.nodes[1].inputs[0].output_node_id == first_id);
+    REQUIRE(loaded.nodes[1].events[0].subscribers == std::vector<NodeId>{first_id});
+}
+
+TEST_CASE("Loaded funcs emit the same YAML", "[loader]") {
+    auto lib = make_lib();
+    lib.funcs.emplace_back().name = "empty";
+
+    YAML::Emitter out;
+    out << YAML::BeginSeq << lib.funcs[0] << lib.funcs[1] << YAML::EndSeq;
+    std::istringstream input(out.c_str());
+    std::vector<Func> funcs;
+    REQUIRE(load_funcs(input, funcs));
+    REQUIRE(funcs.size() == 2);
+    REQUIRE(funcs[0].id == lib.funcs[0].id);
+    REQUIRE(funcs[0].args[5].streaming);
+    REQUIRE(emit(funcs[0]) == emit(lib.funcs[0]));
+    REQUIRE(emit(funcs[1]) == emit(lib.funcs[1]));
+
+    // a single func is a document of its own
+    std::istringstream single(emit(lib.funcs[0]));
+    funcs.clear();
+    REQUIRE(load_funcs(single, funcs));
+    REQUIRE(funcs.size() == 1);
+}
+
+TEST_CASE("Malformed graphs are rejected", "[loader]") {
+    auto lib = make_lib();
+    Graph graph{};
+    graph.nodes.emplace_back(lib.funcs[0]).inputs[0].binding = BindingType::Const;
+    graph.nodes[0].inputs[0].value = make_value(DatatypeInt, 1);
+    const auto yaml = emit(graph);
+
+    Graph loaded{};
+    std::istringstream truncated(yaml.substr(0, yaml.size() / 2) + "\n  - [");
+    REQUIRE_FALSE(load_graph(truncated, lib, loaded));
+
+    // values are parsed as the datatype of the arg, an int does not take text
+    auto wrong_value = yaml;
+    wrong_value.replace(wrong_value.find("value: 1"), 8, "value: one");
+    std::istringstream wrong(wrong_value);
+    REQUIRE_FALSE(load_graph(wrong, lib, loaded));
+
+    // without the func the datatype is unknown
+    std::istringstream missing(yaml);
+    REQUIRE_FALSE(load_graph(missing, FuncLib{}, loaded));
+}
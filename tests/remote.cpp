@@ -0,0 +1,227 @@
+#include "src/executor.hpp"
+#include "src/encoding.hpp"
+#include "src/remote.hpp"
+#include "src/tensor.hpp"
+
+#include <cstring>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <catch2/catch_test_macros.hpp>
+
+
+// Impure funcs: sum of a float tensor, and greeting a name
+static FuncLib make_lib() {
+    FuncLib lib{};
+
+    Func &sum = lib.funcs.emplace_back();
+    sum.name = "sum";
+    sum.args.push_back(FuncArg{"values", DatatypeTensor, true, FuncArgType::In});
+    sum.args.push_back(FuncArg{"sum", DatatypeDouble, true, FuncArgType::Out});
+    sum.lambda = [](std::span<const Value> inputs, std::span<Value> outputs) {
+        const auto tensor = value_as<Tensor>(inputs[0]);
+        double total = 0;
+        for (const auto value: tensor.as<float>()) {
+            total += value;
+        }
+        outputs[0] = make_value(DatatypeDouble, total);
+    };
+
+    Func &greet = lib.funcs.emplace_back();
+    greet.name = "greet";
+    greet.args.push_back(FuncArg{"name", DatatypeString, true, FuncArgType::In});
+    greet.args.push_back(FuncArg{"greeting", DatatypeString, true, FuncArgType::Out});
+    greet.lambda = [](std::span<const Value> inputs, std::span<Value> outputs) {
+        outputs[0] = make_value(DatatypeString, "hello " + value_as<std::string>(inputs[0]));
+    };
+
+    return lib;
+}
+
+static Tensor make_ramp(uint32_t count) {
+    auto tensor = Tensor::uninitialized(DatatypeFloat, {count});
+    auto values = tensor.as_mutable<float>();
+    for (uint32_t i = 0; i < count; ++i) {
+        values[i] = static_cast<float>(i);
+    }
+    return tensor;
+}
+
+
+TEST_CASE("Values survive encoding", "[remote]") {
+    std::vector<Value> values;
+    values.push_back(make_value(DatatypeInt, 42));
+    values.push_back(make_value(DatatypeString, std::string(100, 'x')));
+    values.push_back(Value{});
+    values.push_back(make_value(DatatypeTensor, make_ramp(33)));
+
+    std::vector<std::byte> buffer(encoded_size(values));
+    encode_values(values, buffer.data());
+
+    std::vector<Value> decoded;
+    REQUIRE(decode_values(buffer, decoded, false));
+    REQUIRE(decoded == values);
+
+    REQUIRE(decode_values(buffer, decoded, true));
+    REQUIRE(decoded == values);
+    REQUIRE(value_as<Tensor>(decoded[3]).data() > buffer.data());
+
+    buffer.resize(buffer.size() - 16);
+    REQUIRE_FALSE(decode_values(buffer, decoded, false));
+}
+
+TEST_CASE("Ring wraps messages around its end", "[remote]") {
+    ShmChannel channel{};
+    REQUIRE(create_channel(&channel, "", 256));
+    auto &ring = channel.requests;
+
+    // 48 byte records do not divide 256, so every few messages a padding record is written
+    for (uint32_t i = 0; i < 100; ++i) {
+        auto dst = ring.begin_write(32, std::chrono::milliseconds(0));
+        REQUIRE(dst != nullptr);
+        std::memset(dst, static_cast<int>(i), 32);
+        ring.end_write();
+
+        auto src = ring.begin_read(std::chrono::milliseconds(0));
+        REQUIRE(src.size() == 32);
+        REQUIRE(src[0] == static_cast<std::byte>(i));
+        REQUIRE(src[31] == static_cast<std::byte>(i));
+        ring.end_read();
+    }
+    REQUIRE(ring.begin_read(std::chrono::milliseconds(0)).empty());
+}
+
+TEST_CASE("Executor runs offloaded funcs in a worker", "[remote]") {
+    const auto worker_lib = make_lib();
+    auto host_lib = make_lib();
+    for (auto &func: host_lib.funcs) {
+        func.id = worker_lib.funcs[&func - host_lib.funcs.data()].id;
+    }
+
+    RemoteWorker worker{};
+    REQUIRE(create_remote_worker(&worker, "", 1 << 20));
+    std::thread server([&] { serve_remote_worker(worker.channel, worker_lib); });
+
+    const FuncId offloaded[] = {host_lib.funcs[0].id, host_lib.funcs[1].id};
+    REQUIRE(offload_funcs(host_lib, offloaded, worker));
+
+    Graph graph{};
+    auto &sum = graph.nodes.emplace_back(host_lib.funcs[0]);
+    sum.is_output = true;
+    sum.inputs[0].binding = BindingType::Const;
+    sum.inputs[0].value = make_value(DatatypeTensor, make_ramp(1000));
+
+    auto &greet = graph.nodes.emplace_back(host_lib.funcs[1]);
+    greet.is_output = true;
+    greet.inputs[0].binding = BindingType::Const;
+    greet.inputs[0].value = make_value(DatatypeString, std::string("worker"));
+
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+    for (int i = 0; i < 8; ++i) {
+        std::vector<NodeOutputs> outputs;
+        REQUIRE(executor.run(tenant, graph, host_lib, outputs) == RunResult::Ok);
+        REQUIRE(value_as<double>(outputs[0][0]) == 499500.0);
+        REQUIRE(value_as<std::string>(outputs[1][0]) == "hello worker");
+    }
+
+    worker.stop();
+    server.join();
+
+    // a stopped worker fails the call, the node produces no value and the run fails
+    worker.timeout = std::chrono::milliseconds(50);
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, host_lib, outputs) == RunResult::InvalidInput);
+    REQUIRE(outputs[1][0].empty());
+    REQUIRE_FALSE(worker.alive);
+}
+
+struct alignas(32) Wide {
+    float lanes[8];
+
+    bool operator==(const Wide &other) const = default;
+};
+
+constexpr DatatypeId DatatypeWide = 300;
+
+TEST_CASE("Remote calls that cannot be made fail their node", "[remote]") {
+    if (!datatype_registry().contains(DatatypeWide)) {
+        datatype_registry().add(make_datatype<Wide>(DatatypeWide, "wide"));
+    }
+
+    // too aligned for the encoding, rejected before anything is offloaded
+    auto host_lib = make_lib();
+    auto &wide = host_lib.funcs.emplace_back();
+    wide.args.push_back(FuncArg{"value", DatatypeWide, true, FuncArgType::In});
+    wide.lambda = [](std::span<const Value>, std::span<Value>) {};
+    RemoteWorker worker{};
+    REQUIRE(create_remote_worker(&worker, "", 4096));
+    const FuncId both[] = {host_lib.funcs[1].id, wide.id};
+    REQUIRE_FALSE(offload_funcs(host_lib, both, worker));
+    REQUIRE(host_lib.funcs[1].lambda);
+    REQUIRE_FALSE(host_lib.funcs[1].fallible_lambda);
+
+    const auto worker_lib = make_lib();
+    host_lib.funcs[1].id = worker_lib.funcs[1].id;
+    const FuncId greet_id[] = {host_lib.funcs[1].id};
+    REQUIRE(offload_funcs(host_lib, greet_id, worker));
+    std::thread server([&] { serve_remote_worker(worker.channel, worker_lib); });
+
+    Graph graph{};
+    auto &greet = graph.nodes.emplace_back(host_lib.funcs[1]);
+    greet.is_output = true;
+    greet.inputs[0].binding = BindingType::Const;
+    greet.inputs[0].value = make_value(DatatypeString, std::string("worker"));
+
+    Executor executor{ExecutorConfig{.thread_count = 1}};
+    auto tenant = executor.add_tenant();
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, host_lib, outputs) == RunResult::Ok);
+    REQUIRE(value_as<std::string>(outputs[0][0]) == "hello worker");
+
+    // a request larger than the ring fails without taking the worker down
+    graph.nodes[0].inputs[0].value = make_value(DatatypeString, std::string(8192, 'x'));
+    REQUIRE(executor.run(tenant, graph, host_lib, outputs) == RunResult::InvalidInput);
+    REQUIRE(outputs[0][0].empty());
+    REQUIRE(worker.alive);
+
+    worker.stop();
+    server.join();
+}
+
+#ifdef __linux__
+TEST_CASE("Worker runs in another process", "[remote]") {
+    const auto lib = make_lib();
+    const auto name = "/c_playground-remote-" + std::to_string(getpid());
+
+    RemoteWorker worker{};
+    REQUIRE(create_remote_worker(&worker, name, 1 << 16));
+
+    const auto pid = fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        ShmChannel channel{};
+        if (!open_channel(&channel, name, 1 << 16)) {
+            _exit(1);
+        }
+        serve_remote_worker(channel, lib);
+        _exit(0);
+    }
+
+    std::vector<Value> inputs{make_value(DatatypeString, std::string("process"))};
+    std::vector<Value> outputs(1);
+    REQUIRE(worker.call(lib.funcs[1].id, inputs, outputs));
+    REQUIRE(value_as<std::string>(outputs[0]) == "hello process");
+
+    worker.stop();
+    int status = 0;
+    REQUIRE(waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+}
+#endif
@@ -0,0 +1,223 @@
+#include "src/executor.hpp"
+#include "src/stream.hpp"
+#include "tests/funcs.hpp"
+
+#include <atomic>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+static std::atomic<int> produced{0};
+static std::atomic<int> consumed{0};
+static std::atomic<int> max_ahead{0};
+
+// count -> numbers 0..count-1 (forever for count 0) -> squares -> sum of the first limit squares
+static FuncLib make_lib() {
+    FuncLib lib{};
+
+    Func &source = lib.funcs.emplace_back();
+    source.name = "source";
+    source.args.push_back(FuncArg{"count", DatatypeInt, true, FuncArgType::In});
+    source.args.push_back(FuncArg{"numbers", DatatypeInt, true, FuncArgType::Out, true});
+    source.stream_lambda = [](auto inputs, auto, auto, auto writers) {
+        const auto count = value_as<int>(inputs[0]);
+        for (int i = 0; count == 0 || i < count; ++i) {
+            max_ahead = std::max(max_ahead.load(), ++produced - consumed);
+            if (!writers[0].write(make_value(DatatypeInt, i))) {
+                return;
+            }
+        }
+    };
+
+    Func &square = lib.funcs.emplace_back();
+    square.name = "square";
+    square.args.push_back(FuncArg{"numbers", DatatypeInt, true, FuncArgType::In, true});
+    square.args.push_back(FuncArg{"squares", DatatypeInt64, true, FuncArgType::Out, true});
+    square.stream_lambda = [](auto, auto readers, auto, auto writers) {
+        Value chunk{};
+        while (readers[0].next(chunk)) {
+            const int64_t number = value_as<int>(chunk);
+            if (!writers[0].write(make_value(DatatypeInt64, number * number))) {
+                return;
+            }
+        }
+    };
+
+    Func &sum = lib.funcs.emplace_back();
+    sum.name = "sum";
+    sum.args.push_back(FuncArg{"squares", DatatypeInt64, true, FuncArgType::In, true});
+    sum.args.push_back(FuncArg{"limit", DatatypeInt, false, FuncArgType::In});
+    sum.args.push_back(FuncArg{"sum", DatatypeInt64, true, FuncArgType::Out});
+    sum.stream_lambda = [](auto inputs, auto readers, auto outputs, auto) {
+        const auto limit = value_as<int>(inputs[0]);
+        int64_t total = 0;
+        Value chunk{};
+        for (int i = 0; (limit == 0 || i < limit) && readers[0].next(chunk); ++i) {
+            total += value_as<int64_t>(chunk);
+            ++consumed;
+        }
+        outputs[0] = make_value(DatatypeInt64, total);
+    };
+
+    lib.funcs.push_back(make_identity());
+
+    return lib;
+}
+
+static void build_pipeline(Graph &graph, FuncLib &lib, int count, int limit) {
+    auto &source = graph.nodes.emplace_back(lib.funcs[0]);
+    source.inputs[0].binding = BindingType::Const;
+    source.inputs[0].value = make_value(DatatypeInt, count);
+
+    auto &square = graph.nodes.emplace_back(lib.funcs[1]);
+    square.inputs[0].binding = BindingType::Binding;
+    square.inputs[0].output_node_id = graph.nodes[0].id;
+
+    auto &sum = graph.nodes.emplace_back(lib.funcs[2]);
+    sum.is_output = true;
+    sum.inputs[0].binding = BindingType::Binding;
+    sum.inputs[0].output_node_id = graph.nodes[1].id;
+    sum.inputs[1].binding = BindingType::Const;
+    sum.inputs[1].value = make_value(DatatypeInt, limit);
+}
+
+
+TEST_CASE("Stages run as a pipeline with bounded buffering", "[stream]") {
+    auto lib = make_lib();
+    Graph graph{};
+    build_pipeline(graph, lib, 10000, 0);
+
+    produced = 0;
+    consumed = 0;
+    max_ahead = 0;
+
+    // a single worker thread still runs all three stages at the same time
+    Executor executor{ExecutorConfig{.thread_count = 1, .stream_capacity = 4}};
+    auto tenant = executor.add_tenant();
+
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+
+    int64_t expected = 0;
+    for (int64_t i = 0; i < 10000; ++i) {
+        expected += i * i;
+    }
+    REQUIRE(value_as<int64_t>(outputs[2][0]) == expected);
+    REQUIRE(consumed == 10000);
+
+    // two channels of 4 plus the chunk each stage holds
+    REQUIRE(max_ahead <= 2 * 4 + 3);
+}
+
+TEST_CASE("Consumer stopping early ends an unbounded stream", "[stream]") {
+    auto lib = make_lib();
+    Graph graph{};
+    build_pipeline(graph, lib, 0, 10);
+
+    Executor executor{ExecutorConfig{.thread_count = 2, .stream_capacity = 2}};
+    auto tenant = executor.add_tenant();
+
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+    REQUIRE(value_as<int64_t>(outputs[2][0]) == 285);
+}
+
+TEST_CASE("Streams fan out and accept Const inputs", "[stream]") {
+    auto lib = make_lib();
+    Graph graph{};
+    build_pipeline(graph, lib, 100, 0);
+
+    // a second consumer of the squares and a square of a single Const chunk
+    auto &other_sum = graph.nodes.emplace_back(lib.funcs[2]);
+    other_sum.is_output = true;
+    other_sum.inputs[0].binding = BindingType::Binding;
+    other_sum.inputs[0].output_node_id = graph.nodes[1].id;
+
+    auto &single = graph.nodes.emplace_back(lib.funcs[1]);
+    single.inputs[0].binding = BindingType::Const;
+    single.inputs[0].value = make_value(DatatypeInt, 7);
+
+    auto &single_sum = graph.nodes.emplace_back(lib.funcs[2]);
+    single_sum.is_output = true;
+    single_sum.inputs[0].binding = BindingType::Binding;
+    single_sum.inputs[0].output_node_id = graph.nodes[4].id;
+
+    Executor executor{ExecutorConfig{.thread_count = 2, .stream_capacity = 1}};
+    auto tenant = executor.add_tenant();
+
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+    REQUIRE(value_as<int64_t>(outputs[2][0]) == 328350);
+    REQUIRE(value_as<int64_t>(outputs[3][0]) == 328350);
+    REQUIRE(value_as<int64_t>(outputs[5][0]) == 49);
+}
+
+TEST_CASE("Stream bound to a single-value input is rejected", "[stream]") {
+    auto lib = make_lib();
+    Graph graph{};
+    build_pipeline(graph, lib, 10, 0);
+
+    auto &plain = graph.nodes.emplace_back(lib.funcs[3]);
+    plain.is_output = true;
+    plain.inputs[0].binding = BindingType::Binding;
+    plain.inputs[0].output_node_id = graph.nodes[0].id;
+
+    Executor executor{ExecutorConfig{.thread_count = 1}};
+    auto tenant = executor.add_tenant();
+
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::StreamMismatch);
+}
+
+TEST_CASE("Stage waiting for a value behind its own stream is rejected", "[stream]") {
+    auto lib = make_lib();
+
+    // numbers 0..count-1 like source, and count as a single value
+    Func &numbered = lib.funcs.emplace_back();
+    numbered.name = "numbered";
+    numbered.args.push_back(FuncArg{"count", DatatypeInt, true, FuncArgType::In});
+    numbered.args.push_back(FuncArg{"numbers", DatatypeInt, true, FuncArgType::Out, true});
+    numbered.args.push_back(FuncArg{"count", DatatypeInt, true, FuncArgType::Out});
+    numbered.stream_lambda = [](auto inputs, auto, auto outputs, auto writers) {
+        const auto count = value_as<int>(inputs[0]);
+        for (int i = 0; i < count && writers[0].write(make_value(DatatypeInt, i)); ++i) {
+        }
+        outputs[0] = inputs[0];
+    };
+
+    Executor executor{ExecutorConfig{.thread_count = 2, .stream_capacity = 2}};
+    auto tenant = executor.add_tenant();
+    std::vector<NodeOutputs> outputs;
+
+    // the sum of the squares would only start once numbered is done writing them
+    Graph graph{};
+    build_pipeline(graph, lib, 10, 0);
+    graph.nodes[0].func_id = numbered.id;
+    graph.nodes[2].inputs[1].binding = BindingType::Binding;
+    graph.nodes[2].inputs[1].output_node_id = graph.nodes[0].id;
+    graph.nodes[2].inputs[1].output_idx = 1;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::StreamDeadlock);
+
+    // a second sum of the squares limited by the first one
+    graph = Graph{};
+    build_pipeline(graph, lib, 10, 0);
+    auto &limited = graph.nodes.emplace_back(lib.funcs[2]);
+    limited.is_output = true;
+    limited.inputs[0].binding = BindingType::Binding;
+    limited.inputs[0].output_node_id = graph.nodes[1].id;
+    limited.inputs[1].binding = BindingType::Binding;
+    limited.inputs[1].output_node_id = graph.nodes[2].id;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::StreamDeadlock);
+
+    // the limit taken from a stage that is not upstream of the sum is fine
+    graph = Graph{};
+    build_pipeline(graph, lib, 10, 0);
+    auto &count = graph.nodes.emplace_back(numbered);
+    count.inputs[0].binding = BindingType::Const;
+    count.inputs[0].value = make_value(DatatypeInt, 3);
+    graph.nodes[2].inputs[1].binding = BindingType::Binding;
+    graph.nodes[2].inputs[1].output_node_id = count.id;
+    graph.nodes[2].inputs[1].output_idx = 1;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+    REQUIRE(value_as<int64_t>(outputs[2][0]) == 0 + 1 + 4);
+}
@@ -0,0 +1,175 @@
+#include "src/executor.hpp"
+#include "src/subgraph.hpp"
+#include "tests/funcs.hpp"
+
+#include <atomic>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+static std::atomic<int> add_calls{0};
+
+// add(a, b) -> sum, and twice_plus(x, y) = (x + x) + y as a subgraph of adds
+static FuncLib make_lib() {
+    FuncLib lib{};
+
+    lib.funcs.push_back(make_add(FuncBehavior::Impure, true, &add_calls));
+
+    Graph graph{};
+    const auto twice_id = graph.nodes.emplace_back(lib.funcs[0]).id;
+    auto &plus = graph.nodes.emplace_back(lib.funcs[0]);
+    plus.inputs[0].binding = BindingType::Binding;
+    plus.inputs[0].output_node_id = twice_id;
+    const auto plus_id = plus.id;
+
+    lib.funcs.push_back(make_subgraph_func(
+            "twice_plus",
+            std::move(graph),
+            {
+                    FuncArg{"x", DatatypeInt, true, FuncArgType::In},
+                    FuncArg{"y", DatatypeInt, true, FuncArgType::In},
+                    FuncArg{"result", DatatypeInt, true, FuncArgType::Out},
+            },
+            {{{twice_id, 0}, {twice_id, 1}}, {{plus_id, 1}}},
+            {{plus_id, 0}}
+    ));
+
+    return lib;
+}
+
+// a chain of calls, call i computes twice_plus(previous, i)
+static Graph build_chain(Func &func, int length) {
+    Graph graph{};
+    for (int i = 0; i < length; ++i) {
+        auto &call = graph.nodes.emplace_back(func);
+        if (i == 0) {
+            call.inputs[0].binding = BindingType::Const;
+            call.inputs[0].value = make_value(DatatypeInt, 1);
+        } else {
+            call.inputs[0].binding = BindingType::Binding;
+            call.inputs[0].output_node_id = graph.nodes[i - 1].id;
+        }
+        call.inputs[1].binding = BindingType::Const;
+        call.inputs[1].value = make_value(DatatypeInt, i);
+    }
+    graph.nodes.back().is_output = true;
+    return graph;
+}
+
+static int expected_chain(int length) {
+    int result = 1;
+    for (int i = 0; i < length; ++i) {
+        result = 2 * result + i;
+    }
+    return result;
+}
+
+
+TEST_CASE("Small subgraphs are inlined and large ones compiled once", "[subgraph]") {
+    auto lib = make_lib();
+    const auto graph = build_chain(lib.funcs[1], 4);
+
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+
+    auto inlined = std::make_shared<GraphPlan>();
+    REQUIRE(compile_plan(graph, lib, *inlined) == RunResult::Ok);
+    REQUIRE(inlined->node_count == graph.nodes.size() + 4 * 2);
+    REQUIRE(inlined->evaluated_count == inlined->node_count);
+    REQUIRE(lib.funcs[1].subgraph->plan == nullptr);
+
+    auto shared = std::make_shared<GraphPlan>();
+    REQUIRE(compile_plan(graph, lib, *shared, CompileOptions{.max_inline_nodes = 0}) == RunResult::Ok);
+    REQUIRE(shared->node_count == graph.nodes.size());
+    const auto *inner_plan = lib.funcs[1].subgraph->plan.get();
+    REQUIRE(inner_plan != nullptr);
+    REQUIRE(inner_plan->evaluated_count == 2);
+
+    // a second plan reuses the inner plan compiled for the first
+    GraphPlan again{};
+    REQUIRE(compile_plan(graph, lib, again, CompileOptions{.max_inline_nodes = 0}) == RunResult::Ok);
+    REQUIRE(lib.funcs[1].subgraph->plan.get() == inner_plan);
+
+    for (const auto &plan: {inlined, shared}) {
+        GraphInstance instance{plan};
+        add_calls = 0;
+        REQUIRE(executor.run(tenant, instance) == RunResult::Ok);
+        REQUIRE(value_as<int>(instance.outputs[3][0]) == expected_chain(4));
+        REQUIRE(add_calls == 4 * 2);
+
+    }
+
+    // Const inputs of a call that was not inlined stay on the call
+    GraphInstance instance{shared};
+    instance.set_const(0, 0, make_value(DatatypeInt, 0));
+    REQUIRE(executor.run(tenant, instance) == RunResult::Ok);
+    REQUIRE(value_as<int>(instance.outputs[3][0]) == expected_chain(4) - 16);
+}
+
+TEST_CASE("Subgraphs nest", "[subgraph]") {
+    auto lib = make_lib();
+
+    // twice_plus_twice(x, y) = twice_plus(twice_plus(x, y), y)
+    Graph graph{};
+    const auto first_id = graph.nodes.emplace_back(lib.funcs[1]).id;
+    auto &second = graph.nodes.emplace_back(lib.funcs[1]);
+    second.inputs[0].binding = BindingType::Binding;
+    second.inputs[0].output_node_id = first_id;
+    const auto second_id = second.id;
+    lib.funcs.push_back(make_subgraph_func(
+            "twice_plus_twice",
+            std::move(graph),
+            {
+                    FuncArg{"x", DatatypeInt, true, FuncArgType::In},
+                    FuncArg{"y", DatatypeInt, true, FuncArgType::In},
+                    FuncArg{"result", DatatypeInt, true, FuncArgType::Out},
+            },
+            {{{first_id, 0}}, {{first_id, 1}, {second_id, 1}}},
+            {{second_id, 0}}
+    ));
+
+    Graph outer{};
+    auto &call = outer.nodes.emplace_back(lib.funcs[2]);
+    call.is_output = true;
+    call.inputs[0].binding = BindingType::Const;
+    call.inputs[0].value = make_value(DatatypeInt, 3);
+    call.inputs[1].binding = BindingType::Const;
+    call.inputs[1].value = make_value(DatatypeInt, 5);
+
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+    for (const auto max_inline_nodes: {16u, 0u}) {
+        auto plan = std::make_shared<GraphPlan>();
+        REQUIRE(compile_plan(outer, lib, *plan, CompileOptions{.max_inline_nodes = max_inline_nodes}) == RunResult::Ok);
+        GraphInstance instance{plan};
+        REQUIRE(executor.run(tenant, instance) == RunResult::Ok);
+        REQUIRE(value_as<int>(instance.outputs[0][0]) == 2 * (2 * 3 + 5) + 5);
+    }
+}
+
+TEST_CASE("Recursive subgraphs are rejected", "[subgraph]") {
+    auto lib = make_lib();
+
+    // again(x) = again(x), declared first so the inner call has the right inputs
+    Func declaration{};
+    declaration.args.push_back(FuncArg{"x", DatatypeInt, true, FuncArgType::In});
+    declaration.args.push_back(FuncArg{"result", DatatypeInt, true, FuncArgType::Out});
+    Graph graph{};
+    const auto inner_id = graph.nodes.emplace_back(declaration).id;
+    auto &again = lib.funcs.emplace_back(make_subgraph_func(
+            "again", std::move(graph), declaration.args, {{{inner_id, 0}}}, {{inner_id, 0}}
+    ));
+    again.subgraph->graph.nodes[0].func_id = again.id;
+
+    Graph outer{};
+    auto &call = outer.nodes.emplace_back(again);
+    call.is_output = true;
+    call.inputs[0].binding = BindingType::Const;
+    call.inputs[0].value = make_value(DatatypeInt, 3);
+
+    for (const auto max_inline_nodes: {16u, 0u}) {
+        GraphPlan plan{};
+        REQUIRE(compile_plan(outer, lib, plan, CompileOptions{.max_inline_nodes = max_inline_nodes})
+                == RunResult::RecursiveSubgraph);
+    }
+}
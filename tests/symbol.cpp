@@ -0,0 +1,68 @@
+#include "src/graph.hpp"
+#include "src/utils/symbol.hpp"
+#include "src/utils/thread_pool.hpp"
+
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+TEST_CASE("Symbols intern each text once", "[symbol]") {
+    const Symbol add = "add";
+    const Symbol again = std::string("ad") + "d";
+    REQUIRE(add.id == again.id);
+    REQUIRE(add == again);
+    REQUIRE(add == "add");
+    REQUIRE(add == std::string_view("add"));
+    REQUIRE_FALSE(add == "sub");
+    REQUIRE(add.view() == "add");
+    REQUIRE(add.str() == "add");
+
+    REQUIRE(Symbol{}.empty());
+    REQUIRE(Symbol("").empty());
+    REQUIRE(Symbol{} == "");
+
+    // comparing with text that was never interned leaves the table alone
+    const auto count = symbol_count();
+    REQUIRE_FALSE(add == "a text nothing interned");
+    REQUIRE(symbol_count() == count);
+
+    const std::string long_text(100000, 'x');
+    REQUIRE(Symbol(long_text).view() == long_text);
+    REQUIRE(Symbol(long_text) == Symbol(long_text));
+}
+
+TEST_CASE("Nodes share the name of their func", "[symbol]") {
+    Func func{};
+    func.name = "shared name";
+    func.args.push_back(FuncArg{"shared name", DatatypeInt, true, FuncArgType::In});
+    Node node{func};
+    REQUIRE(node.name.id == func.name.id);
+    REQUIRE(func.args[0].name.id == func.name.id);
+    REQUIRE(sizeof(node.name) == 4);
+}
+
+TEST_CASE("Symbols intern concurrently", "[symbol]") {
+    ThreadPool pool{ThreadPoolConfig{.thread_count = 4}};
+    constexpr size_t Count = 20000;
+    std::vector<Symbol> first(Count);
+    std::vector<Symbol> second(Count);
+
+    // both passes race on the same texts, crossing several blocks of the table
+    TaskGroup group{pool};
+    for (auto *symbols: {&first, &second}) {
+        group.run([&pool, symbols] {
+            pool.parallel_for(0, Count, 64, [symbols](size_t begin, size_t end) {
+                for (auto i = begin; i < end; ++i) {
+                    (*symbols)[i] = "concurrent " + std::to_string(i);
+                }
+            });
+        });
+    }
+    group.wait();
+
+    for (size_t i = 0; i < Count; ++i) {
+        REQUIRE(first[i] == second[i]);
+        REQUIRE(first[i].view() == "concurrent " + std::to_string(i));
+    }
+}
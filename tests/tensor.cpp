@@ -0,0 +1,151 @@
+#include "src/executor.hpp"
+#include "src/tensor.hpp"
+
+#include <atomic>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+TEST_CASE("Tensor values share their buffer", "[tensor]") {
+    Tensor tensor{DatatypeFloat, {4, 8}};
+    REQUIRE(tensor.element_count() == 32);
+    REQUIRE(tensor.byte_size() == 32 * sizeof(float));
+    tensor.as_mutable<float>()[3] = 1.5f;
+
+    auto value = make_value(DatatypeTensor, tensor);
+    auto copy = value;
+    const auto &copied = *static_cast<const Tensor *>(copy.data());
+    REQUIRE(copied.data() == tensor.data());
+    REQUIRE(copy == value);
+    REQUIRE(hash_value(copy) == hash_value(value));
+
+    Tensor other{DatatypeFloat, {4, 8}};
+    REQUIRE_FALSE(other == tensor);
+    other.as_mutable<float>()[3] = 1.5f;
+    REQUIRE(other == tensor);
+    REQUIRE(hash_tensor(other) == hash_tensor(tensor));
+
+    Tensor strings{DatatypeString, {3}};
+    strings.as_mutable<std::string>()[1] = "long enough to live on the heap for sure";
+    auto strings_copy = strings;
+    REQUIRE(strings_copy == strings);
+}
+
+TEST_CASE("Element-wise funcs run in parallel chunks", "[tensor][executor]") {
+    std::atomic<int> chunks{0};
+
+    FuncLib lib{};
+    Func &scale = lib.funcs.emplace_back();
+    scale.name = "scale";
+    scale.behavior = FuncBehavior::Pure;
+    scale.args.push_back(FuncArg{"values", DatatypeTensor, true, FuncArgType::In});
+    scale.args.push_back(FuncArg{"factor", DatatypeFloat, true, FuncArgType::In});
+    scale.args.push_back(FuncArg{"result", DatatypeTensor, true, FuncArgType::Out});
+    scale.elementwise = ElementwiseFunc{
+            [&chunks](std::span<const void *const> inputs, std::span<void *const> outputs, size_t count) {
+                ++chunks;
+                auto values = static_cast<const float *>(inputs[0]);
+                auto factor = *static_cast<const float *>(inputs[1]);
+                auto result = static_cast<float *>(outputs[0]);
+                for (size_t i = 0; i < count; ++i) {
+                    result[i] = values[i] * factor;
+                }
+            },
+            {DatatypeFloat, DatatypeFloat},
+            {DatatypeFloat}
+    };
+
+    constexpr uint32_t count = 1 << 20;
+    Tensor input = Tensor::uninitialized(DatatypeFloat, {count});
+    auto input_values = input.as_mutable<float>();
+    for (uint32_t i = 0; i < count; ++i) {
+        input_values[i] = static_cast<float>(i);
+    }
+
+    Graph graph{};
+    auto &node = graph.nodes.emplace_back(scale);
+    node.is_output = true;
+    node.inputs[0].binding = BindingType::Const;
+    node.inputs[0].value = make_value(DatatypeTensor, input);
+    node.inputs[1].binding = BindingType::Const;
+    node.inputs[1].value = make_value(DatatypeFloat, 2.0f);
+
+    Executor executor{ExecutorConfig{.thread_count = 4, .chunk_bytes = 16 * 1024}};
+    auto tenant = executor.add_tenant();
+    std::vector<NodeOutputs> outputs;
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+
+    REQUIRE(chunks == count / (16 * 1024 / sizeof(float)));
+    const auto &result = *static_cast<const Tensor *>(outputs[0][0].data());
+    REQUIRE(result.shape == std::vector<uint32_t>{count});
+    auto result_values = result.as<float>();
+    bool all_scaled = true;
+    for (uint32_t i = 0; i < count; ++i) {
+        all_scaled &= result_values[i] == static_cast<float>(i) * 2.0f;
+    }
+    REQUIRE(all_scaled);
+
+    // evaluated again rather than looked up, nothing is hashed
+    REQUIRE(executor.run(tenant, graph, lib, outputs) == RunResult::Ok);
+    REQUIRE(chunks == 2 * count / (16 * 1024 / sizeof(float)));
+    REQUIRE(executor.cache.misses == 0);
+}
+
+TEST_CASE("Element-wise funcs fail on inputs that do not match", "[tensor][executor]") {
+    std::atomic<int> calls{0};
+
+    FuncLib lib{};
+    Func &add = lib.funcs.emplace_back();
+    add.name = "add";
+    add.behavior = FuncBehavior::Pure;
+    add.args.push_back(FuncArg{"a", DatatypeTensor, true, FuncArgType::In});
+    add.args.push_back(FuncArg{"b", DatatypeTensor, true, FuncArgType::In});
+    add.args.push_back(FuncArg{"sum", DatatypeTensor, true, FuncArgType::Out});
+    add.elementwise = ElementwiseFunc{
+            [&calls](std::span<const void *const> inputs, std::span<void *const> outputs, size_t count) {
+                ++calls;
+                auto a = static_cast<const float *>(inputs[0]);
+                auto b = static_cast<const float *>(inputs[1]);
+                auto sum = static_cast<float *>(outputs[0]);
+                for (size_t i = 0; i < count; ++i) {
+                    sum[i] = a[i] + b[i];
+                }
+            },
+            {DatatypeFloat, DatatypeFloat},
+            {DatatypeFloat}
+    };
+
+    // add(a, b) -> add(sum, b), the second add must not run on a missing sum
+    Graph graph{};
+    auto &first = graph.nodes.emplace_back(add);
+    first.inputs[0].binding = BindingType::Const;
+    first.inputs[1].binding = BindingType::Const;
+    auto &second = graph.nodes.emplace_back(add);
+    second.is_output = true;
+    second.inputs[0].binding = BindingType::Binding;
+    second.inputs[0].output_node_id = graph.nodes[0].id;
+    second.inputs[1].binding = BindingType::Const;
+
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+    std::vector<NodeOutputs> outputs;
+    auto run_with = [&](Value a, Value b) {
+        graph.nodes[0].inputs[0].value = a;
+        graph.nodes[0].inputs[1].value = b;
+        graph.nodes[1].inputs[1].value = b;
+        return executor.run(tenant, graph, lib, outputs);
+    };
+
+    const auto floats = make_value(DatatypeTensor, Tensor{DatatypeFloat, {4}});
+    REQUIRE(run_with(floats, floats) == RunResult::Ok);
+    REQUIRE(calls == 2);
+
+    calls = 0;
+    REQUIRE(run_with(floats, make_value(DatatypeTensor, Tensor{DatatypeFloat, {5}})) == RunResult::InvalidInput);
+    REQUIRE(run_with(floats, make_value(DatatypeTensor, Tensor{DatatypeInt, {4}})) == RunResult::InvalidInput);
+    REQUIRE(run_with(make_value(DatatypeFloat, 1.0f), make_value(DatatypeFloat, 2.0f)) == RunResult::InvalidInput);
+    REQUIRE(calls == 0);
+    REQUIRE(outputs[0][0].empty());
+    REQUIRE(outputs[1].empty());
+}
@@ -0,0 +1,141 @@
+#include "src/utils/thread_pool.hpp"
+
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+
+// fib(n) with a task per call above the cutoff, every task waiting on a group of its own
+static uint64_t parallel_fib(ThreadPool &pool, uint32_t n) {
+    if (n < 12) {
+        return n < 2 ? n : parallel_fib(pool, n - 1) + parallel_fib(pool, n - 2);
+    }
+    uint64_t lhs = 0;
+    TaskGroup group{pool};
+    group.run([&] { lhs = parallel_fib(pool, n - 1); });
+    const auto rhs = parallel_fib(pool, n - 2);
+    group.wait();
+    return lhs + rhs;
+}
+
+
+TEST_CASE("Task groups run every task and their continuations", "[thread_pool]") {
+    ThreadPool pool{ThreadPoolConfig{.thread_count = 4}};
+    REQUIRE(pool.thread_count() == 4);
+
+    std::atomic<int> done{0};
+    std::atomic<int> seen_by_continuation{-1};
+    {
+        TaskGroup group{pool};
+        for (int i = 0; i < 1000; ++i) {
+            group.run([&] { ++done; });
+        }
+        group.then([&] { seen_by_continuation = done.load(); });
+        group.wait();
+        REQUIRE(done == 1000);
+        REQUIRE(seen_by_continuation == 1000);
+
+        // on a drained group a continuation runs right away
+        group.then([&] { ++done; });
+    }
+    REQUIRE(done == 1001);
+}
+
+TEST_CASE("Continuations wait for tasks added after them", "[thread_pool]") {
+    ThreadPool pool{ThreadPoolConfig{.thread_count = 2}};
+    std::atomic<bool> release{false};
+    std::atomic<bool> later_done{false};
+    std::atomic<bool> seen_later{false};
+    {
+        TaskGroup group{pool};
+        group.run([&] {
+            while (!release) {
+                std::this_thread::yield();
+            }
+        });
+        group.then([&] { seen_later = later_done.load(); });
+        group.run([&] { later_done = true; });
+        while (!later_done) {
+            std::this_thread::yield();
+        }
+        release = true;
+        group.wait();
+    }
+    REQUIRE(seen_later);
+}
+
+TEST_CASE("Nested task groups under stress", "[thread_pool]") {
+    ThreadPool pool{ThreadPoolConfig{.thread_count = 4}};
+    for (int round = 0; round < 20; ++round) {
+        REQUIRE(parallel_fib(pool, 22) == 17711);
+    }
+
+    // many groups submitting into one pool at once from outside threads
+    std::vector<std::thread> submitters;
+    std::atomic<int> done{0};
+    for (int i = 0; i < 4; ++i) {
+        submitters.emplace_back([&] {
+            for (int round = 0; round < 50; ++round) {
+                TaskGroup group{pool};
+                for (int task = 0; task < 20; ++task) {
+                    group.run([&] { ++done; });
+                }
+                group.then([&] { ++done; });
+            }
+        });
+    }
+    for (auto &submitter: submitters) {
+        submitter.join();
+    }
+    REQUIRE(done == 4 * 50 * 21);
+}
+
+TEST_CASE("parallel_for covers the range once", "[thread_pool]") {
+    ThreadPool pool{ThreadPoolConfig{.thread_count = 3, .pin_threads = true}};
+    PerThread<std::vector<size_t>> visited{pool};
+
+    std::vector<std::atomic<int>> hits(10007);
+    pool.parallel_for(0, hits.size(), 0, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            ++hits[i];
+            visited.local().push_back(i);
+        }
+    });
+    for (const auto &hit: hits) {
+        REQUIRE(hit == 1);
+    }
+
+    size_t total = 0;
+    visited.for_each([&](const std::vector<size_t> &indices) { total += indices.size(); });
+    REQUIRE(total == hits.size());
+
+    pool.parallel_for(5, 5, 1, [](size_t, size_t) { FAIL(); });
+}
+
+TEST_CASE("Thread pool benchmark", "[thread_pool][.benchmark]") {
+    ThreadPool pool{};
+    std::vector<float> values(1 << 20);
+    std::iota(values.begin(), values.end(), 0.0f);
+
+    BENCHMARK("submit and wait for 10000 tasks") {
+        std::atomic<int> done{0};
+        TaskGroup group{pool};
+        for (int i = 0; i < 10000; ++i) {
+            group.run([&] { ++done; });
+        }
+        group.wait();
+        return done.load();
+    };
+
+    BENCHMARK("parallel_for over 1M floats") {
+        pool.parallel_for(0, values.size(), 0, [&](size_t begin, size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                values[i] = values[i] * 0.5f + 1.0f;
+            }
+        });
+        return values[0];
+    };
+}
@@ -0,0 +1,245 @@
+#include "src/encoding.hpp"
+#include "src/executor.hpp"
+#include "src/tensor.hpp"
+#include "src/trace.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <random>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+static std::atomic<int> sensor_calls{0};
+
+// sensor() -> noisy readings, scale(readings, factor) -> scaled readings
+static FuncLib make_lib() {
+    FuncLib lib{};
+
+    Func &sensor = lib.funcs.emplace_back();
+    sensor.name = "sensor";
+    sensor.behavior = FuncBehavior::Impure;
+    sensor.args.push_back(FuncArg{"readings", DatatypeTensor, true, FuncArgType::Out});
+    sensor.args.push_back(FuncArg{"label", DatatypeString, true, FuncArgType::Out});
+    sensor.lambda = [](std::span<const Value>, std::span<Value> outputs) {
+        static std::mt19937 engine{std::random_device{}()};
+        auto readings = Tensor::uninitialized(DatatypeFloat, {256});
+        std::uniform_real_distribution<float> noise{-1.0f, 1.0f};
+        for (auto &reading: readings.as_mutable<float>()) {
+            reading = noise(engine);
+        }
+        outputs[0] = make_value(DatatypeTensor, std::move(readings));
+        outputs[1] = make_value(DatatypeString, "reading " + std::to_string(++sensor_calls));
+    };
+
+    Func &scale = lib.funcs.emplace_back();
+    scale.name = "scale";
+    scale.behavior = FuncBehavior::Pure;
+    scale.args.push_back(FuncArg{"readings", DatatypeTensor, true, FuncArgType::In});
+    scale.args.push_back(FuncArg{"factor", DatatypeFloat, true, FuncArgType::In});
+    scale.args.push_back(FuncArg{"scaled", DatatypeTensor, true, FuncArgType::Out});
+    scale.lambda = [](std::span<const Value> inputs, std::span<Value> outputs) {
+        const auto readings = value_as<Tensor>(inputs[0]);
+        const auto factor = value_as<float>(inputs[1]);
+        if (readings.element != DatatypeFloat) {
+            return;
+        }
+        auto scaled = Tensor::uninitialized(DatatypeFloat, readings.shape);
+        std::ranges::transform(readings.as<float>(), scaled.as_mutable<float>().begin(),
+                               [factor](float reading) { return reading * factor; });
+        outputs[0] = make_value(DatatypeTensor, std::move(scaled));
+    };
+
+    return lib;
+}
+
+static std::shared_ptr<GraphPlan> build_plan(FuncLib &lib) {
+    Graph graph{};
+    graph.nodes.emplace_back(lib.funcs[0]);
+
+    auto &scale = graph.nodes.emplace_back(lib.funcs[1]);
+    scale.is_output = true;
+    scale.inputs[0].binding = BindingType::Binding;
+    scale.inputs[0].output_node_id = graph.nodes[0].id;
+    scale.inputs[1].binding = BindingType::Const;
+    scale.inputs[1].value = make_value(DatatypeFloat, 3.0f);
+
+    auto plan = std::make_shared<GraphPlan>();
+    REQUIRE(compile_plan(graph, lib, *plan) == RunResult::Ok);
+    return plan;
+}
+
+
+TEST_CASE("Replay reproduces recorded runs without calling Impure funcs", "[trace]") {
+    auto lib = make_lib();
+    auto plan = build_plan(lib);
+    const auto path = (std::filesystem::temp_directory_path() / "c_playground-trace-test.bin").string();
+
+    Executor executor{ExecutorConfig{.thread_count = 2}};
+    auto tenant = executor.add_tenant();
+
+    std::vector<std::vector<NodeOutputs>> recorded;
+    {
+        Trace trace{};
+        GraphInstance instance{plan};
+        instance.trace = &trace;
+        for (int i = 0; i < 3; ++i) {
+            executor.run(tenant, instance);
+            recorded.push_back(instance.outputs);
+        }
+        REQUIRE(trace.run_count == 3);
+        REQUIRE(save_trace(trace, path));
+    }
+    REQUIRE(recorded[0][1] != recorded[1][1]);
+
+    Trace trace{};
+    REQUIRE(load_trace(&trace, path));
+    std::filesystem::remove(path);
+    REQUIRE(trace.mode == TraceMode::Replay);
+    REQUIRE(trace.run_count == 3);
+
+    // the Pure cache would hide a mismatch, start without it
+    Executor replayer{ExecutorConfig{.thread_count = 2, .cache_capacity = 0}};
+    tenant = replayer.add_tenant();
+    GraphInstance instance{plan};
+    instance.trace = &trace;
+
+    const auto calls = sensor_calls.load();
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(replayer.run(tenant, instance) == RunResult::Ok);
+        REQUIRE(instance.outputs == recorded[i]);
+    }
+    REQUIRE(sensor_calls == calls);
+    REQUIRE(trace.misses == 0);
+
+    // past the end of the trace Impure nodes produce nothing and their consumers are skipped
+    REQUIRE(replayer.run(tenant, instance) == RunResult::InvalidInput);
+    REQUIRE(instance.outputs[0][0].empty());
+    REQUIRE(instance.outputs[1].empty());
+    REQUIRE(trace.misses == 1);
+    REQUIRE(sensor_calls == calls);
+}
+
+TEST_CASE("Damaged traces are rejected", "[trace]") {
+    const auto path = (std::filesystem::temp_directory_path() / "c_playground-trace-damaged.bin").string();
+
+    auto lib = make_lib();
+    Trace recorded{};
+    recorded.begin_run(*build_plan(lib));
+    std::vector<Value> outputs{make_value(DatatypeInt, 7)};
+    recorded.record(1, outputs);
+    recorded.bytes.resize(recorded.bytes.size() - 16);
+    REQUIRE(save_trace(recorded, path));
+
+    Trace trace{};
+    REQUIRE_FALSE(load_trace(&trace, path));
+    REQUIRE_FALSE(load_trace(&trace, path + ".missing"));
+
+    // cut inside the header
+    recorded.bytes.resize(20);
+    REQUIRE(save_trace(recorded, path));
+    REQUIRE_FALSE(load_trace(&trace, path));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Replay of corrupt records fails the run", "[trace]") {
+    auto lib = make_lib();
+    auto plan = build_plan(lib);
+    const auto path = (std::filesystem::temp_directory_path() / "c_playground-trace-corrupt.bin").string();
+
+    Executor executor{ExecutorConfig{.thread_count = 1, .cache_capacity = 0}};
+    auto tenant = executor.add_tenant();
+    {
+        Trace trace{};
+        GraphInstance instance{plan};
+        instance.trace = &trace;
+        REQUIRE(executor.run(tenant, instance) == RunResult::Ok);
+
+        // the readings tensor follows the 32 byte header, the 16 byte record header, the count
+        // and its value header; claim more elements than were stored
+        auto shape = trace.bytes.data() + 32 + 16 + 16 + 16 + 8;
+        REQUIRE(load_u32(shape) == 256);
+        store_u32(shape, 1 << 20);
+        REQUIRE(save_trace(trace, path));
+    }
+
+    // the file is whole, only the record is not
+    Trace trace{};
+    REQUIRE(load_trace(&trace, path));
+    std::filesystem::remove(path);
+    GraphInstance instance{plan};
+    instance.trace = &trace;
+    REQUIRE(executor.run(tenant, instance) == RunResult::InvalidInput);
+    REQUIRE(trace.misses == 1);
+    REQUIRE(instance.outputs[0][0].empty());
+    REQUIRE(instance.outputs[1].empty());
+
+    // no prefix of an encoding decodes, and no byte of it reads past the end when damaged; the
+    // tensor goes last, it ends without padding
+    std::vector<Value> values{make_value(DatatypeString, std::string("text")), make_value(DatatypeTensor, Tensor{DatatypeFloat, {4, 3}})};
+    std::vector<std::byte> bytes(encoded_size(values));
+    encode_values(values, bytes.data());
+    std::vector<Value> decoded;
+    for (size_t size = 0; size < bytes.size(); ++size) {
+        REQUIRE_FALSE(decode_values(std::span(bytes).first(size), decoded, true));
+    }
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        auto damaged = bytes;
+        damaged[i] = std::byte{0xff};
+        decode_values(damaged, decoded, false);
+    }
+}
+
+TEST_CASE("Replay misses what was not recorded and plans of other graphs", "[trace]") {
+    auto lib = make_lib();
+    auto plan = build_plan(lib);
+    const auto path = (std::filesystem::temp_directory_path() / "c_playground-trace-misses.bin").string();
+
+    Executor executor{ExecutorConfig{.thread_count = 2, .cache_capacity = 0}};
+    auto tenant = executor.add_tenant();
+
+    // readings of strings have no encoding, the first run records the sensor without them
+    const auto sensor = lib.funcs[0].lambda;
+    lib.funcs[0].lambda = [](std::span<const Value>, std::span<Value> outputs) {
+        outputs[0] = make_value(DatatypeTensor, Tensor{DatatypeString, {2}});
+        outputs[1] = make_value(DatatypeString, std::string("strings"));
+    };
+    {
+        Trace trace{};
+        GraphInstance instance{plan};
+        instance.trace = &trace;
+        executor.run(tenant, instance);
+        lib.funcs[0].lambda = sensor;
+        executor.run(tenant, instance);
+        REQUIRE(trace.unrecorded == 1);
+        REQUIRE(save_trace(trace, path));
+    }
+
+    Trace trace{};
+    REQUIRE(load_trace(&trace, path));
+    std::filesystem::remove(path);
+    GraphInstance instance{plan};
+    instance.trace = &trace;
+    REQUIRE(executor.run(tenant, instance) == RunResult::InvalidInput);
+    REQUIRE(trace.misses == 1);
+    REQUIRE(instance.outputs[0][0].empty());
+    REQUIRE(executor.run(tenant, instance) == RunResult::Ok);
+    REQUIRE(trace.misses == 1);
+    REQUIRE_FALSE(instance.outputs[0][0].empty());
+
+    // as many nodes, but two sensors
+    Graph graph{};
+    graph.nodes.emplace_back(lib.funcs[0]).is_output = true;
+    graph.nodes.emplace_back(lib.funcs[0]).is_output = true;
+    auto other = std::make_shared<GraphPlan>();
+    REQUIRE(compile_plan(graph, lib, *other) == RunResult::Ok);
+    REQUIRE(other->node_count == plan->node_count);
+
+    trace.replayed = 0;
+    GraphInstance other_instance{other};
+    other_instance.trace = &trace;
+    const auto calls = sensor_calls.load();
+    REQUIRE(executor.run(tenant, other_instance) == RunResult::InvalidInput);
+    REQUIRE(trace.misses == 1 + 2);
+    REQUIRE(sensor_calls == calls);
+}
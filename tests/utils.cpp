@@ -0,0 +1,89 @@
+#include "src/utils/thread_pool.hpp"
+#include "src/utils/utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+
+static bool is_version4(const uuids::uuid &id) {
+    return id.version() == uuids::uuid_version::random_number_based && id.variant() == uuids::uuid_variant::rfc;
+}
+
+
+TEST_CASE("Uuids from all threads are distinct", "[utils]") {
+    ThreadPool pool{ThreadPoolConfig{.thread_count = 4}};
+    constexpr size_t Count = 400000;
+    std::vector<uuids::uuid> ids(Count);
+
+    // singles and bulk fills of varying size, racing on every thread of the pool
+    pool.parallel_for(0, Count, 1000, [&](size_t begin, size_t end) {
+        if (begin / 1000 % 2 == 0) {
+            for (auto i = begin; i < end; ++i) {
+                ids[i] = generate_uuid();
+            }
+        } else {
+            generate_uuids(std::span(ids).subspan(begin, end - begin));
+        }
+    });
+
+    REQUIRE(std::all_of(ids.begin(), ids.end(), is_version4));
+    std::sort(ids.begin(), ids.end());
+    REQUIRE(std::adjacent_find(ids.begin(), ids.end()) == ids.end());
+}
+
+TEST_CASE("Time ordered uuids increase", "[utils]") {
+    const auto unix_ms = [] {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+    };
+    set_uuid_version(UuidVersion::TimeOrdered);
+    const auto before = unix_ms();
+    std::vector<uuids::uuid> ids(100000);
+    for (size_t i = 0; i < ids.size() / 2; ++i) {
+        ids[i] = generate_uuid();
+    }
+    generate_uuids(std::span(ids).subspan(ids.size() / 2));
+    const auto after = unix_ms();
+    set_uuid_version(UuidVersion::Random);
+
+    REQUIRE(std::is_sorted(ids.begin(), ids.end()));
+    REQUIRE(std::adjacent_find(ids.begin(), ids.end()) == ids.end());
+    for (const auto &id: ids) {
+        const auto bytes = id.as_bytes();
+        REQUIRE(static_cast<uint8_t>(bytes[6]) >> 4 == 7);
+        REQUIRE(id.variant() == uuids::uuid_variant::rfc);
+        uint64_t ms = 0;
+        for (int i = 0; i < 6; ++i) {
+            ms = ms << 8 | static_cast<uint8_t>(bytes[i]);
+        }
+        REQUIRE(ms >= before);
+        REQUIRE(ms <= after);
+    }
+    REQUIRE(is_version4(generate_uuid()));
+}
+
+TEST_CASE("Uuid generation benchmark", "[.benchmark][utils]") {
+    std::vector<uuids::uuid> ids(1 << 16);
+    ThreadPool pool{ThreadPoolConfig{.thread_count = 4}};
+
+    BENCHMARK("generate_uuid") {
+        for (auto &id: ids) {
+            id = generate_uuid();
+        }
+        return ids.back();
+    };
+    BENCHMARK("generate_uuids") {
+        generate_uuids(ids);
+        return ids.back();
+    };
+    BENCHMARK("generate_uuids on 4 threads") {
+        pool.parallel_for(0, ids.size(), 4096, [&](size_t begin, size_t end) {
+            generate_uuids(std::span(ids).subspan(begin, end - begin));
+        });
+        return ids.back();
+    };
+}
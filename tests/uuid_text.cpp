@@ -0,0 +1,145 @@
+#include "src/utils/utils.hpp"
+#include "src/utils/uuid_text.hpp"
+
+#include <random>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+
+static uuids::uuid random_uuid(std::mt19937_64 &random) {
+    std::array<uint8_t, 16> bytes{};
+    for (auto &byte: bytes) {
+        byte = static_cast<uint8_t>(random());
+    }
+    return uuids::uuid(bytes);
+}
+
+// parse_uuid, parse_uuid_scalar and stduuid agree on text, both on whether it parses and on the
+// result
+static void require_same_parse(std::string_view text) {
+    const auto expected = uuids::uuid::from_string(text);
+    for (auto *parse: {parse_uuid, parse_uuid_scalar}) {
+        uuids::uuid id{};
+        REQUIRE(parse(text, id) == expected.has_value());
+        if (expected.has_value()) {
+            REQUIRE(id == expected.value());
+        }
+    }
+}
+
+
+TEST_CASE("Uuid text matches stduuid", "[uuid_text]") {
+    std::mt19937_64 random{11};
+    for (int i = 0; i < 10000; ++i) {
+        const auto id = random_uuid(random);
+        const auto text = format_uuid(id);
+        REQUIRE(text == uuids::to_string(id));
+        std::string scalar_text(UuidTextSize, '\0');
+        format_uuid_scalar(id, scalar_text.data());
+        REQUIRE(scalar_text == text);
+
+        uuids::uuid parsed{};
+        REQUIRE(parse_uuid(text, parsed));
+        REQUIRE(parsed == id);
+        parsed = {};
+        REQUIRE(parse_uuid_scalar(text, parsed));
+        REQUIRE(parsed == id);
+    }
+
+    for (const auto *text: {"", "{}", "-", "0123456789ABCDEFabcdef0123456789", "{01234567-89ab-cdef-0123-456789abcdef}",
+                            "01234567-89AB-CDEF-0123-456789ABCDEF", "01234567-89ab-cdef-0123-456789abcdeg",
+                            "01234567-89ab-cdef-0123-456789abcde", "0-1234567-89ab-cdef-0123-456789abcde"}) {
+        require_same_parse(text);
+    }
+}
+
+TEST_CASE("Uuid parsing fuzzed against stduuid", "[uuid_text]") {
+    // mutations of canonical text, keeping it 36 characters most of the time to hit the fast path
+    std::mt19937_64 random{12};
+    const std::string alphabet = "0123456789abcdefABCDEFgG-{}/:@`\x7f\x80\xff";
+    for (int i = 0; i < 200000; ++i) {
+        auto text = format_uuid(random_uuid(random));
+        const auto mutations = random() % 4;
+        for (uint64_t m = 0; m < mutations; ++m) {
+            const auto position = random() % text.size();
+            switch (random() % 8) {
+                case 0:
+                    text.erase(position, 1);
+                    break;
+                case 1:
+                    text.insert(position, 1, alphabet[random() % alphabet.size()]);
+                    break;
+                case 2:
+                    text[position] = static_cast<char>(random());
+                    break;
+                default:
+                    text[position] = alphabet[random() % alphabet.size()];
+                    break;
+            }
+        }
+        require_same_parse(text);
+    }
+}
+
+TEST_CASE("Uuid text benchmark", "[.benchmark][uuid_text]") {
+    std::mt19937_64 random{13};
+    std::vector<uuids::uuid> ids(4096);
+    for (auto &id: ids) {
+        id = random_uuid(random);
+    }
+    std::vector<std::string> texts;
+    for (const auto &id: ids) {
+        texts.push_back(uuids::to_string(id));
+    }
+
+    BENCHMARK("stduuid to_string") {
+        size_t size = 0;
+        for (const auto &id: ids) {
+            size += uuids::to_string(id).size();
+        }
+        return size;
+    };
+    BENCHMARK("format_uuid") {
+        char text[UuidTextSize];
+        size_t sum = 0;
+        for (const auto &id: ids) {
+            format_uuid(id, text);
+            sum += static_cast<uint8_t>(text[0]);
+        }
+        return sum;
+    };
+    BENCHMARK("format_uuid_scalar") {
+        char text[UuidTextSize];
+        size_t sum = 0;
+        for (const auto &id: ids) {
+            format_uuid_scalar(id, text);
+            sum += static_cast<uint8_t>(text[0]);
+        }
+        return sum;
+    };
+    BENCHMARK("stduuid from_string") {
+        size_t valid = 0;
+        for (const auto &text: texts) {
+            valid += uuids::uuid::from_string(text).has_value();
+        }
+        return valid;
+    };
+    BENCHMARK("parse_uuid") {
+        size_t valid = 0;
+        uuids::uuid id{};
+        for (const auto &text: texts) {
+            valid += parse_uuid(text, id);
+        }
+        return valid;
+    };
+    BENCHMARK("parse_uuid_scalar") {
+        size_t valid = 0;
+        uuids::uuid id{};
+        for (const auto &text: texts) {
+            valid += parse_uuid_scalar(text, id);
+        }
+        return valid;
+    };
+}
@@ -0,0 +1,204 @@
+#include "src/validator.hpp"
+#include "tests/funcs.hpp"
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+static FuncLib make_lib() {
+    FuncLib lib{};
+
+    Func &source = lib.funcs.emplace_back();
+    source.name = "source";
+    source.args.push_back(FuncArg{"int", 1, true, FuncArgType::Out});
+    source.args.push_back(FuncArg{"float", 2, true, FuncArgType::Out});
+
+    lib.funcs.push_back(make_identity());
+
+    return lib;
+}
+
+static void bind(Node &node, uint32_t arg_idx, const Node &producer, uint32_t output_idx) {
+    node.inputs[arg_idx].binding = BindingType::Binding;
+    node.inputs[arg_idx].output_node_id = producer.id;
+    node.inputs[arg_idx].output_idx = output_idx;
+}
+
+static size_t count_issues(const GraphValidator &validator, ValidationIssueKind kind) {
+    auto issues = validator.issues();
+    return std::ranges::count_if(issues, [kind](const ValidationIssue &issue) { return issue.kind == kind; });
+}
+
+
+TEST_CASE("Validator reports unbound inputs and datatype mismatches", "[validator]") {
+    auto lib = make_lib();
+    Graph graph{};
+    graph.nodes.emplace_back(lib.funcs[0]);
+    graph.nodes.emplace_back(lib.funcs[1]);
+    graph.nodes.emplace_back(lib.funcs[1]);
+
+    GraphValidator validator{graph, lib};
+    REQUIRE_FALSE(validator.validate());
+    REQUIRE(count_issues(validator, ValidationIssueKind::UnboundInput) == 2);
+
+    bind(graph.nodes[1], 0, graph.nodes[0], 0);
+    bind(graph.nodes[2], 0, graph.nodes[0], 1);
+    validator.touch(graph.nodes[1].id);
+    validator.touch(graph.nodes[2].id);
+    REQUIRE_FALSE(validator.validate());
+    REQUIRE(count_issues(validator, ValidationIssueKind::UnboundInput) == 0);
+    REQUIRE(count_issues(validator, ValidationIssueKind::DatatypeMismatch) == 1);
+
+    bind(graph.nodes[2], 0, graph.nodes[1], 0);
+    validator.touch(graph.nodes[2].id);
+    REQUIRE(validator.validate());
+}
+
+TEST_CASE("Validator tracks cycles incrementally", "[validator]") {
+    auto lib = make_lib();
+    Graph graph{};
+    for (int i = 0; i < 4; ++i) {
+        graph.nodes.emplace_back(lib.funcs[1]);
+    }
+    for (int i = 1; i < 4; ++i) {
+        bind(graph.nodes[i], 0, graph.nodes[i - 1], 0);
+    }
+    bind(graph.nodes[0], 0, graph.nodes[3], 0);
+
+    GraphValidator validator{graph, lib};
+    REQUIRE_FALSE(validator.validate());
+    REQUIRE(count_issues(validator, ValidationIssueKind::Cycle) == 4);
+
+    graph.nodes[0].inputs[0].binding = BindingType::Const;
+    graph.nodes[0].inputs[0].value = make_value(1, 7);
+    validator.touch(graph.nodes[0].id);
+    REQUIRE(validator.validate());
+
+    bind(graph.nodes[1], 0, graph.nodes[2], 0);
+    validator.touch(graph.nodes[1].id);
+    REQUIRE_FALSE(validator.validate());
+    REQUIRE(count_issues(validator, ValidationIssueKind::Cycle) == 2);
+}
+
+TEST_CASE("Validator handles removed and re-added producers", "[validator]") {
+    auto lib = make_lib();
+    Graph graph{};
+    graph.nodes.emplace_back(lib.funcs[0]);
+    graph.nodes.emplace_back(lib.funcs[1]);
+    bind(graph.nodes[1], 0, graph.nodes[0], 0);
+
+    GraphValidator validator{graph, lib};
+    REQUIRE(validator.validate());
+
+    auto removed = graph.nodes[0].id;
+    graph.nodes.erase(graph.nodes.begin());
+    validator.touch(removed);
+    REQUIRE_FALSE(validator.validate());
+    REQUIRE(count_issues(validator, ValidationIssueKind::UnknownNode) == 1);
+
+    auto &readded = graph.nodes.emplace_back(lib.funcs[0]);
+    readded.id = removed;
+    validator.touch(removed);
+    REQUIRE(validator.validate());
+}
+
+TEST_CASE("Validator agrees with a full pass through random edits", "[validator]") {
+    auto lib = make_lib();
+    Graph graph{};
+    for (int i = 0; i < 200; ++i) {
+        auto &node = graph.nodes.emplace_back(lib.funcs[1]);
+        node.inputs[0].binding = BindingType::Const;
+        node.inputs[0].value = make_value(1, i);
+    }
+
+    auto cycle_members = [](const GraphValidator &validator) {
+        std::vector<NodeId> members;
+        for (const auto &issue: validator.issues()) {
+            if (issue.kind == ValidationIssueKind::Cycle) {
+                members.push_back(issue.node_id);
+            }
+        }
+        std::sort(members.begin(), members.end());
+        return members;
+    };
+
+    // mostly edges towards later nodes, now and then one back that may close a cycle or a
+    // constant that may break one
+    GraphValidator validator{graph, lib};
+    REQUIRE(validator.validate());
+    std::mt19937 random{5};
+    for (int round = 0; round < 300; ++round) {
+        for (int edit = 0; edit < 3; ++edit) {
+            const auto consumer = 1 + random() % 199;
+            auto &input = graph.nodes[consumer].inputs[0];
+            const auto kind = random() % 10;
+            if (kind == 0) {
+                input.binding = BindingType::Const;
+                input.value = make_value(1, 0);
+            } else {
+                const auto producer = kind <= 2 ? random() % 200 : random() % consumer;
+                bind(graph.nodes[consumer], 0, graph.nodes[producer], 0);
+            }
+            validator.touch(graph.nodes[consumer].id);
+        }
+        const bool valid = validator.validate();
+
+        GraphValidator full{graph, lib};
+        REQUIRE(full.validate() == valid);
+        REQUIRE(cycle_members(validator) == cycle_members(full));
+    }
+}
+
+TEST_CASE("Validator follows inserts and erases in the middle", "[validator]") {
+    auto lib = make_lib();
+    Graph graph{};
+    for (int i = 0; i < 100; ++i) {
+        auto &node = graph.nodes.emplace_back(lib.funcs[i % 10 == 0 ? 0 : 1]);
+        if (i % 10 != 0) {
+            bind(node, 0, graph.nodes[std::max(0, i - 1 - i % 3)], 0);
+        }
+    }
+
+    auto sorted_issues = [](const GraphValidator &validator) {
+        auto issues = validator.issues();
+        std::ranges::sort(issues, [](const ValidationIssue &a, const ValidationIssue &b) {
+            return std::tie(a.node_id, a.arg_idx, a.kind) < std::tie(b.node_id, b.arg_idx, b.kind);
+        });
+        return issues;
+    };
+    auto same = [](const ValidationIssue &a, const ValidationIssue &b) {
+        return a.kind == b.kind && a.node_id == b.node_id && a.arg_idx == b.arg_idx;
+    };
+
+    GraphValidator validator{graph, lib};
+    validator.validate();
+    std::mt19937 random{7};
+    for (int round = 0; round < 200; ++round) {
+        for (int edit = 0; edit < 2; ++edit) {
+            const auto position = random() % graph.nodes.size();
+            if (random() % 2 == 0 && graph.nodes.size() > 10) {
+                validator.touch(graph.nodes[position].id);
+                graph.nodes.erase(graph.nodes.begin() + position);
+            } else {
+                Node node{lib.funcs[1]};
+                bind(node, 0, graph.nodes[random() % graph.nodes.size()], 0);
+                validator.touch(node.id);
+                graph.nodes.insert(graph.nodes.begin() + position, std::move(node));
+            }
+        }
+        const bool valid = validator.validate();
+
+        // every node and no other has a state, at its position
+        REQUIRE(validator.nodes.size() == graph.nodes.size());
+        for (uint32_t i = 0; i < graph.nodes.size(); ++i) {
+            REQUIRE(validator.nodes.at(graph.nodes[i].id).index_hint == i);
+        }
+
+        GraphValidator full{graph, lib};
+        REQUIRE(full.validate() == valid);
+        REQUIRE(std::ranges::equal(sorted_issues(validator), sorted_issues(full), same));
+    }
+}
@@ -0,0 +1,121 @@
+#include "src/tensor.hpp"
+#include "src/yaml_writer.hpp"
+
+#include <random>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+
+static Func make_func() {
+    Func func{};
+    func.name = "mix";
+    func.behavior = FuncBehavior::Impure;
+    func.args.push_back(FuncArg{"a", DatatypeInt, true, FuncArgType::In});
+    func.args.push_back(FuncArg{"weights", DatatypeTensor, false, FuncArgType::In});
+    func.args.push_back(FuncArg{"label", DatatypeString, false, FuncArgType::In});
+    func.args.push_back(FuncArg{"scale", DatatypeDouble, false, FuncArgType::In});
+    func.args.push_back(FuncArg{"on", DatatypeBool, false, FuncArgType::In});
+    func.args.push_back(FuncArg{"out", DatatypeInt64, true, FuncArgType::Out, true});
+    func.events.push_back(FuncEvent{"done"});
+    func.events.push_back(FuncEvent{""});
+    return func;
+}
+
+// every binding, datatype and the empty sequences, with node names from names
+static Graph build_graph(const Func &func, const std::vector<std::string> &names) {
+    const float weights[] = {1.5f, -2.0f, 0.25f};
+    Graph graph{};
+    for (size_t i = 0; i < names.size(); ++i) {
+        auto &node = graph.nodes.emplace_back(func);
+        node.name = names[i];
+        node.is_output = i % 2 == 0;
+        node.timeout_ms = static_cast<uint32_t>(i * 1000);
+        node.inputs[0].binding = BindingType::Const;
+        node.inputs[0].value = make_value(DatatypeInt, static_cast<int>(i) - 3);
+        node.inputs[1].binding = BindingType::Const;
+        node.inputs[1].value = i % 3 == 0 ? make_value(DatatypeTensor, make_array<float>(DatatypeFloat, weights)) : Value{};
+        node.inputs[2].binding = BindingType::Const;
+        node.inputs[2].value = make_value(DatatypeString, names[names.size() - 1 - i]);
+        node.inputs[3].binding = BindingType::Const;
+        node.inputs[3].value = make_value(DatatypeDouble, 0.1 * static_cast<double>(i));
+        node.inputs[4].binding = BindingType::Const;
+        node.inputs[4].value = make_value(DatatypeBool, i % 2 == 1);
+        if (i > 0) {
+            node.inputs[0].binding = BindingType::Binding;
+            node.inputs[0].output_node_id = graph.nodes[i - 1].id;
+            node.inputs[0].output_idx = static_cast<uint32_t>(i % 2);
+            node.events[0].subscribers.push_back(graph.nodes[0].id);
+        }
+        if (i % 4 == 3) {
+            node.inputs.clear();
+            node.events.clear();
+        }
+    }
+    return graph;
+}
+
+static std::string emitted(const auto &value) {
+    YAML::Emitter out;
+    out << value;
+    return out.c_str();
+}
+
+static std::string written(const auto &value) {
+    std::string out;
+    write_yaml(out, value);
+    return out;
+}
+
+
+TEST_CASE("Writer matches the emitter", "[yaml_writer]") {
+    const std::vector<std::string> names = {
+        "add", "", "two words", "trailing ", " leading", "key: value", "ends:", "a # comment", "- item",
+        "null", "~", "true", "1", "1e3", "over\nlines", "[flow]", "\"quoted\"", "a'b", "path/to.node-1", "ü",
+    };
+    auto func = make_func();
+    REQUIRE(written(func) == emitted(func));
+
+    func.args.clear();
+    func.events.clear();
+    func.name = "needs: quotes";
+    REQUIRE(written(func) == emitted(func));
+
+    const auto graph = build_graph(make_func(), names);
+    REQUIRE(written(graph) == emitted(graph));
+    for (const auto &node: graph.nodes) {
+        REQUIRE(written(node) == emitted(node));
+    }
+    REQUIRE(written(Graph{}) == emitted(Graph{}));
+}
+
+TEST_CASE("Writer takes the plain path only for plain scalars", "[yaml_writer]") {
+    // the characters the plain path accepts and some it must leave to the emitter
+    const std::string alphabet = "aZ09_ ./-:#'\"~n";
+    std::mt19937 random{5};
+    std::vector<std::string> names;
+    for (int i = 0; i < 2000; ++i) {
+        std::string name(random() % 6, ' ');
+        for (auto &c: name) {
+            c = alphabet[random() % alphabet.size()];
+        }
+        names.push_back(std::move(name));
+    }
+    const auto graph = build_graph(make_func(), names);
+    REQUIRE(written(graph) == emitted(graph));
+}
+
+TEST_CASE("Writer benchmark", "[.benchmark][yaml_writer]") {
+    std::vector<std::string> names(1000);
+    for (size_t i = 0; i < names.size(); ++i) {
+        names[i] = "node " + std::to_string(i);
+    }
+    const auto graph = build_graph(make_func(), names);
+
+    BENCHMARK("emitter") {
+        return emitted(graph).size();
+    };
+    BENCHMARK("writer") {
+        return written(graph).size();
+    };
+}